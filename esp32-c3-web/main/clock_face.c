@@ -0,0 +1,444 @@
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * NAME:
+ *      clock_face.c
+ *
+ * PURPOSE:
+ *      This module provides the clock faces (word table, masks and grid maps)
+ *      used by the display task. The face compiled into the firmware is always
+ *      available, more faces are read in place from the "faces" partition.
+ *
+ * DEPENDENCIES:
+ *      ---
+ *
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*
+ * (C) Andrew Bright 2023, github.com/e5h
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*][ Include Files ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+
+#include "clock_face.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*][ LOCAL : Constants and Types ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+
+/* The image is read in place, so these must match tools/gen_clock_faces.py */
+_Static_assert( sizeof( CLOCK_FACE_IMAGE_HEADER ) == 16, "CLOCK_FACE_IMAGE_HEADER does not match the image" );
+_Static_assert( sizeof( CLOCK_FACE_HEADER ) == 120, "CLOCK_FACE_HEADER does not match the image" );
+_Static_assert( sizeof( CLOCK_FACE_WORD ) == 6, "CLOCK_FACE_WORD does not match the image" );
+_Static_assert( sizeof( CLOCK_TRIE_NODE ) == 10, "CLOCK_TRIE_NODE does not match the image" );
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*][ LOCAL : Variables ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+
+/* Header of the built-in face, the tables are linked directly */
+static const CLOCK_FACE_HEADER clock_builtin_header_S = {
+    .name_c             = CLOCK_FACE_NAME,
+    .language_c         = CLOCK_FACE_LANGUAGE,
+    .led_count_u16      = WC_RGB_LED_COUNT,
+    .grid_width_u8      = CLOCK_GRID_WIDTH,
+    .grid_height_u8     = CLOCK_GRID_HEIGHT,
+    .led_type_u8        = WC_RGB_LED_TYPE,
+    .mask_words_u8      = CLOCK_MASK_WORDS,
+    .num_words_u8       = CLOCK_NUM_WORDS,
+    .num_slots_u8       = CLOCK_NUM_TIME_SLOTS,
+    .num_hours_u8       = CLOCK_NUM_HOURS,
+    .num_hour_forms_u8  = CLOCK_NUM_HOUR_FORMS,
+    .hash_buckets_u16   = CLOCK_WORD_HASH_BUCKETS,
+    .hash_slots_u16     = CLOCK_WORD_HASH_SLOTS,
+    .trie_nodes_u16     = CLOCK_TRIE_NODES,
+    .trie_words_u16     = CLOCK_TRIE_WORDS,
+    .names_size_u16     = CLOCK_FACE_NAMES_SIZE,
+    .pixels_size_u16    = CLOCK_FACE_PIXELS_SIZE,
+};
+
+const CLOCK_FACE CLOCK_FACE_builtin_S = {
+    .header_S               = &clock_builtin_header_S,
+    .words_S                = CLOCK_face_words_S,
+    .names_c                = CLOCK_face_names_c,
+    .pixels_u8              = CLOCK_face_pixels_u8,
+    .xy_pixel_u8            = &CLOCK_xy_pixel_u8[ 0 ][ 0 ],
+    .pixel_x_u8             = CLOCK_pixel_x_u8,
+    .pixel_y_u8             = CLOCK_pixel_y_u8,
+    .word_masks_S           = CLOCK_word_masks_S,
+    .slot_masks_S           = CLOCK_slot_masks_S,
+    .slot_hour_offset_u8    = CLOCK_slot_hour_offset_u8,
+    .slot_hour_form_u8      = CLOCK_slot_hour_form_u8,
+    .hour_masks_S           = CLOCK_hour_masks_S,
+    .hash_seed_u16          = CLOCK_word_hash_seed_u16,
+    .hash_slot_u8           = CLOCK_word_hash_slot_u8,
+    .trie_S                 = CLOCK_trie_S,
+    .trie_words_u8          = CLOCK_trie_words_u8,
+    .read_start_u16         = CLOCK_word_read_start_u16,
+    .read_end_u16           = CLOCK_word_read_end_u16,
+};
+
+static CLOCK_FACE clock_loaded_faces_S[ CLOCK_FACE_MAX - 1 ];   /* Pointers into the mapped partition */
+static const CLOCK_FACE* clock_faces_S[ CLOCK_FACE_MAX ] = { &CLOCK_FACE_builtin_S };
+static UINT8 clock_num_faces_u8 = 1;
+
+static esp_partition_mmap_handle_t clock_face_mmap_h;
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*][ Function Definitions ][~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      FaceTable() - "Locate one table of a face"
+ *
+ * DESCRIPTION:
+ *      Checks that the table lies inside the face and is aligned for its
+ *      elements before handing out a pointer to it.
+ *
+ * INPUTS:
+ *      header - the face in the mapped image
+ *      table - the table to locate
+ *      size - bytes the table must hold
+ *      align - alignment of the table elements
+ *
+ * OUTPUTS:
+ *      (const void*) the table, NULL if it does not fit
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+static const void* FaceTable( const CLOCK_FACE_HEADER* header_S, CLOCK_FACE_TABLE_E table_E, UINT32 size_u32, UINT32 align_u32 )
+{
+    UINT32 offset_u32 = header_S->table_u32[ table_E ];
+
+    if( ( offset_u32 < sizeof( CLOCK_FACE_HEADER ) ) || ( offset_u32 > header_S->size_u32 )
+     || ( size_u32 > ( header_S->size_u32 - offset_u32 ) ) || ( ( offset_u32 & ( align_u32 - 1 ) ) != 0 ) )
+    {
+        ESP_LOGE( "FaceTable()", "Face \"%.16s\": table %d out of bounds", header_S->name_c, table_E );
+        return NULL;
+    }
+
+    return (const UINT8*)header_S + offset_u32;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      FaceLoad() - "Check a face of the image and point at its tables"
+ *
+ * DESCRIPTION:
+ *      The display task indexes the tables without bounds checks, so every
+ *      count and index of the face is checked here once: table bounds, LED
+ *      indexes, word references of the hash and the trie. The face must fit
+ *      the LED chain the firmware was built for (count, type and pixel
+ *      mask size). Nothing is copied.
+ *
+ * INPUTS:
+ *      header - the face in the mapped image
+ *      face - filled with pointers to the tables
+ *
+ * OUTPUTS:
+ *      TRUE - face usable
+ *      FALSE - face rejected
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+static BOOL FaceLoad( const CLOCK_FACE_HEADER* header_S, CLOCK_FACE* face_S )
+{
+    const CHAR* tag_str = "FaceLoad()";
+    UINT32 num_words_u32 = header_S->num_words_u8;
+    UINT32 num_cells_u32 = header_S->grid_width_u8 * header_S->grid_height_u8;
+    UINT32 num_hour_masks_u32 = header_S->num_hour_forms_u8 * CLOCK_NUM_HOURS;
+    UINT32 mask_bytes_u32 = sizeof( CLOCK_PIXEL_MASK );
+
+    /* Geometry and LED chain */
+    if( ( header_S->led_count_u16 == 0 ) || ( header_S->led_count_u16 > WC_RGB_LED_COUNT )
+     || ( header_S->led_type_u8 != WC_RGB_LED_TYPE ) || ( header_S->mask_words_u8 != CLOCK_MASK_WORDS )
+     || ( num_cells_u32 != header_S->led_count_u16 ) )
+    {
+        ESP_LOGE( tag_str, "Face \"%.16s\": %d LEDs of type %d do not fit this firmware (%d LEDs of type %d)",
+            header_S->name_c, header_S->led_count_u16, header_S->led_type_u8, WC_RGB_LED_COUNT, WC_RGB_LED_TYPE );
+        return FALSE;
+    }
+
+    if( ( header_S->num_slots_u8 != CLOCK_NUM_TIME_SLOTS ) || ( header_S->num_hours_u8 != CLOCK_NUM_HOURS )
+     || ( header_S->grid_width_u8 < 2 )
+     || ( header_S->num_hour_forms_u8 == 0 )
+     || ( header_S->hash_buckets_u16 == 0 ) || ( ( header_S->hash_buckets_u16 & ( header_S->hash_buckets_u16 - 1 ) ) != 0 )
+     || ( header_S->hash_slots_u16 == 0 ) || ( ( header_S->hash_slots_u16 & ( header_S->hash_slots_u16 - 1 ) ) != 0 )
+     || ( header_S->trie_nodes_u16 == 0 ) || ( header_S->names_size_u16 == 0 )
+     || ( header_S->name_c[ sizeof( header_S->name_c ) - 1 ] != '\0' )
+     || ( header_S->language_c[ sizeof( header_S->language_c ) - 1 ] != '\0' ) )
+    {
+        ESP_LOGE( tag_str, "Face \"%.16s\": invalid header", header_S->name_c );
+        return FALSE;
+    }
+
+    face_S->header_S            = header_S;
+    face_S->words_S             = FaceTable( header_S, FACE_TABLE_WORDS, num_words_u32 * sizeof( CLOCK_FACE_WORD ), 2 );
+    face_S->names_c             = FaceTable( header_S, FACE_TABLE_NAMES, header_S->names_size_u16, 1 );
+    face_S->pixels_u8           = FaceTable( header_S, FACE_TABLE_PIXELS, header_S->pixels_size_u16, 1 );
+    face_S->xy_pixel_u8         = FaceTable( header_S, FACE_TABLE_XY_PIXEL, num_cells_u32, 1 );
+    face_S->pixel_x_u8          = FaceTable( header_S, FACE_TABLE_PIXEL_X, header_S->led_count_u16, 1 );
+    face_S->pixel_y_u8          = FaceTable( header_S, FACE_TABLE_PIXEL_Y, header_S->led_count_u16, 1 );
+    face_S->word_masks_S        = FaceTable( header_S, FACE_TABLE_WORD_MASKS, num_words_u32 * mask_bytes_u32, 8 );
+    face_S->slot_masks_S        = FaceTable( header_S, FACE_TABLE_SLOT_MASKS, CLOCK_NUM_TIME_SLOTS * mask_bytes_u32, 8 );
+    face_S->slot_hour_offset_u8 = FaceTable( header_S, FACE_TABLE_SLOT_HOUR_OFFSET, CLOCK_NUM_TIME_SLOTS, 1 );
+    face_S->slot_hour_form_u8   = FaceTable( header_S, FACE_TABLE_SLOT_HOUR_FORM, CLOCK_NUM_TIME_SLOTS, 1 );
+    face_S->hour_masks_S        = FaceTable( header_S, FACE_TABLE_HOUR_MASKS, num_hour_masks_u32 * mask_bytes_u32, 8 );
+    face_S->hash_seed_u16       = FaceTable( header_S, FACE_TABLE_HASH_SEED, header_S->hash_buckets_u16 * sizeof( UINT16 ), 2 );
+    face_S->hash_slot_u8        = FaceTable( header_S, FACE_TABLE_HASH_SLOT, header_S->hash_slots_u16, 1 );
+    face_S->trie_S              = FaceTable( header_S, FACE_TABLE_TRIE, header_S->trie_nodes_u16 * sizeof( CLOCK_TRIE_NODE ), 2 );
+    face_S->trie_words_u8       = FaceTable( header_S, FACE_TABLE_TRIE_WORDS, header_S->trie_words_u16, 1 );
+    face_S->read_start_u16      = FaceTable( header_S, FACE_TABLE_READ_START, num_words_u32 * sizeof( UINT16 ), 2 );
+    face_S->read_end_u16        = FaceTable( header_S, FACE_TABLE_READ_END, num_words_u32 * sizeof( UINT16 ), 2 );
+
+    if( ( face_S->words_S == NULL ) || ( face_S->names_c == NULL ) || ( face_S->pixels_u8 == NULL )
+     || ( face_S->xy_pixel_u8 == NULL ) || ( face_S->pixel_x_u8 == NULL ) || ( face_S->pixel_y_u8 == NULL )
+     || ( face_S->word_masks_S == NULL ) || ( face_S->slot_masks_S == NULL ) || ( face_S->slot_hour_offset_u8 == NULL )
+     || ( face_S->slot_hour_form_u8 == NULL )
+     || ( face_S->hour_masks_S == NULL ) || ( face_S->hash_seed_u16 == NULL ) || ( face_S->hash_slot_u8 == NULL )
+     || ( face_S->trie_S == NULL ) || ( face_S->trie_words_u8 == NULL )
+     || ( face_S->read_start_u16 == NULL ) || ( face_S->read_end_u16 == NULL ) )
+    {
+        return FALSE;
+    }
+
+    /* Words: names terminated inside the name table, LEDs on the chain */
+    if( face_S->names_c[ header_S->names_size_u16 - 1 ] != '\0' )
+    {
+        ESP_LOGE( tag_str, "Face \"%.16s\": unterminated word names", header_S->name_c );
+        return FALSE;
+    }
+    for( UINT32 word = 0; word < num_words_u32; word++ )
+    {
+        const CLOCK_FACE_WORD* word_S = &face_S->words_S[ word ];
+
+        if( ( word_S->name_u16 >= header_S->names_size_u16 ) || ( word_S->length_u8 == 0 )
+         || ( ( word_S->pixels_u16 + word_S->length_u8 ) > header_S->pixels_size_u16 ) )
+        {
+            ESP_LOGE( tag_str, "Face \"%.16s\": invalid word %" PRIu32, header_S->name_c, word );
+            return FALSE;
+        }
+    }
+    for( UINT32 pixel = 0; pixel < header_S->pixels_size_u16; pixel++ )
+    {
+        if( face_S->pixels_u8[ pixel ] >= header_S->led_count_u16 )
+        {
+            ESP_LOGE( tag_str, "Face \"%.16s\": LED index out of range", header_S->name_c );
+            return FALSE;
+        }
+    }
+    for( UINT32 cell = 0; cell < num_cells_u32; cell++ )
+    {
+        if( face_S->xy_pixel_u8[ cell ] >= header_S->led_count_u16 )
+        {
+            ESP_LOGE( tag_str, "Face \"%.16s\": LED index out of range", header_S->name_c );
+            return FALSE;
+        }
+    }
+    for( UINT32 pixel = 0; pixel < header_S->led_count_u16; pixel++ )
+    {
+        if( ( face_S->pixel_x_u8[ pixel ] >= header_S->grid_width_u8 )
+         || ( face_S->pixel_y_u8[ pixel ] >= header_S->grid_height_u8 ) )
+        {
+            ESP_LOGE( tag_str, "Face \"%.16s\": grid position out of range", header_S->name_c );
+            return FALSE;
+        }
+    }
+
+    /* Every slot picks an existing hour word form */
+    for( UINT32 slot = 0; slot < CLOCK_NUM_TIME_SLOTS; slot++ )
+    {
+        if( face_S->slot_hour_form_u8[ slot ] >= header_S->num_hour_forms_u8 )
+        {
+            ESP_LOGE( tag_str, "Face \"%.16s\": invalid hour form", header_S->name_c );
+            return FALSE;
+        }
+    }
+
+    /* Hash and trie only refer to existing words and nodes */
+    for( UINT32 slot = 0; slot < header_S->hash_slots_u16; slot++ )
+    {
+        if( ( face_S->hash_slot_u8[ slot ] != CLOCK_WORD_HASH_EMPTY ) && ( face_S->hash_slot_u8[ slot ] >= num_words_u32 ) )
+        {
+            ESP_LOGE( tag_str, "Face \"%.16s\": invalid hash slot", header_S->name_c );
+            return FALSE;
+        }
+    }
+    for( UINT32 node = 0; node < header_S->trie_nodes_u16; node++ )
+    {
+        const CLOCK_TRIE_NODE* node_S = &face_S->trie_S[ node ];
+
+        if( ( node_S->child_u16 >= header_S->trie_nodes_u16 ) || ( node_S->sibling_u16 >= header_S->trie_nodes_u16 )
+         || ( ( node_S->words_u16 + node_S->num_words_u8 ) > header_S->trie_words_u16 ) )
+        {
+            ESP_LOGE( tag_str, "Face \"%.16s\": invalid trie node", header_S->name_c );
+            return FALSE;
+        }
+    }
+    for( UINT32 entry = 0; entry < header_S->trie_words_u16; entry++ )
+    {
+        if( face_S->trie_words_u8[ entry ] >= num_words_u32 )
+        {
+            ESP_LOGE( tag_str, "Face \"%.16s\": invalid trie word", header_S->name_c );
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_FACE_Init() - "Load the faces of the face partition"
+ *
+ * DESCRIPTION:
+ *      Memory-maps the CLOCK_FACE_PARTITION data partition and checks the
+ *      image (magic, version, size and CRC-32). Every valid face becomes
+ *      available after the built-in face, the tables stay in flash and are
+ *      read through the cache. Faces that do not fit this firmware are
+ *      skipped. The mapping is kept for the lifetime of the firmware.
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      STATUS_OK - image loaded
+ *      STATUS_NO_CHANGE - no face partition or empty partition, built-in face only
+ *      STATUS_ERR - invalid image, built-in face only
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+STATUS_E CLOCK_FACE_Init( void )
+{
+    const CHAR* tag_str = "CLOCK_FACE_Init()";
+    const esp_partition_t* partition_S;
+    const CLOCK_FACE_IMAGE_HEADER* image_S;
+    const UINT32* offsets_u32;
+    const void* mapped_v;
+
+    if( clock_num_faces_u8 > 1 )
+    {
+        return STATUS_OK;
+    }
+
+    partition_S = esp_partition_find_first( ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, CLOCK_FACE_PARTITION );
+    if( partition_S == NULL )
+    {
+        ESP_LOGW( tag_str, "No \"%s\" partition, using the built-in face", CLOCK_FACE_PARTITION );
+        return STATUS_NO_CHANGE;
+    }
+
+    if( esp_partition_mmap( partition_S, 0, partition_S->size, ESP_PARTITION_MMAP_DATA, &mapped_v, &clock_face_mmap_h ) != ESP_OK )
+    {
+        ESP_LOGE( tag_str, "Could not map the \"%s\" partition", CLOCK_FACE_PARTITION );
+        return STATUS_ERR;
+    }
+    image_S = mapped_v;
+
+    /* Erased flash reads 0xFF, nothing was written to the partition */
+    if( memcmp( image_S->magic_c, "WCFC", sizeof( image_S->magic_c ) ) != 0 )
+    {
+        ESP_LOGW( tag_str, "No face image in \"%s\", using the built-in face", CLOCK_FACE_PARTITION );
+        esp_partition_munmap( clock_face_mmap_h );
+        return STATUS_NO_CHANGE;
+    }
+
+    if( ( image_S->version_u16 != CLOCK_FACE_VERSION )
+     || ( image_S->size_u32 < sizeof( CLOCK_FACE_IMAGE_HEADER ) ) || ( image_S->size_u32 > partition_S->size )
+     || ( image_S->num_faces_u16 > ( ( image_S->size_u32 - sizeof( CLOCK_FACE_IMAGE_HEADER ) ) / sizeof( UINT32 ) ) )
+     || ( esp_rom_crc32_le( 0, (const UINT8*)( image_S + 1 ), image_S->size_u32 - sizeof( CLOCK_FACE_IMAGE_HEADER ) )
+          != image_S->crc32_u32 ) )
+    {
+        ESP_LOGE( tag_str, "Invalid face image (version %d, %" PRIu32 " bytes)", image_S->version_u16, image_S->size_u32 );
+        esp_partition_munmap( clock_face_mmap_h );
+        return STATUS_ERR;
+    }
+
+    offsets_u32 = (const UINT32*)( image_S + 1 );
+    for( UINT32 face = 0; ( face < image_S->num_faces_u16 ) && ( clock_num_faces_u8 < CLOCK_FACE_MAX ); face++ )
+    {
+        UINT32 offset_u32 = offsets_u32[ face ];
+        const CLOCK_FACE_HEADER* header_S = (const CLOCK_FACE_HEADER*)( (const UINT8*)image_S + offset_u32 );
+        CLOCK_FACE* face_S = &clock_loaded_faces_S[ clock_num_faces_u8 - 1 ];
+
+        if( ( ( offset_u32 & 7 ) != 0 ) || ( offset_u32 > ( image_S->size_u32 - sizeof( CLOCK_FACE_HEADER ) ) )
+         || ( header_S->size_u32 > ( image_S->size_u32 - offset_u32 ) ) )
+        {
+            ESP_LOGE( tag_str, "Face %" PRIu32 " is outside the image", face );
+            continue;
+        }
+
+        if( FaceLoad( header_S, face_S ) )
+        {
+            clock_faces_S[ clock_num_faces_u8++ ] = face_S;
+            ESP_LOGI( tag_str, "Face %d: \"%s\" (%s), %dx%d, %d words", clock_num_faces_u8 - 1, header_S->name_c,
+                header_S->language_c, header_S->grid_width_u8, header_S->grid_height_u8, header_S->num_words_u8 );
+        }
+    }
+
+    return STATUS_OK;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_FACE_Count() - "Get the number of faces available"
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      (UINT8) faces, the built-in face included
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+UINT8 CLOCK_FACE_Count( void )
+{
+    return clock_num_faces_u8;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_FACE_Get() - "Get a face by index"
+ *
+ * INPUTS:
+ *      index - 0 (CLOCK_FACE_BUILTIN) to CLOCK_FACE_Count() - 1
+ *
+ * OUTPUTS:
+ *      (const CLOCK_FACE*) the face, NULL if there is no such face
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+const CLOCK_FACE* CLOCK_FACE_Get( UINT8 index_u8 )
+{
+    if( index_u8 >= clock_num_faces_u8 )
+    {
+        return NULL;
+    }
+
+    return clock_faces_S[ index_u8 ];
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_FACE_Find() - "Find a face by name"
+ *
+ * DESCRIPTION:
+ *      Faces from the partition are searched first, so a face with the name
+ *      of the built-in face replaces it.
+ *
+ * INPUTS:
+ *      name - name of the face (the "name" setting of its word list)
+ *
+ * OUTPUTS:
+ *      (INT32) index of the face, -1 if not found
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+INT32 CLOCK_FACE_Find( const CHAR* name_str )
+{
+    if( name_str == NULL )
+    {
+        return -1;
+    }
+
+    for( INT32 face = clock_num_faces_u8 - 1; face >= 0; face-- )
+    {
+        if( strncmp( name_str, clock_faces_S[ face ]->header_S->name_c, sizeof( clock_faces_S[ face ]->header_S->name_c ) ) == 0 )
+        {
+            return face;
+        }
+    }
+
+    return -1;
+}
@@ -0,0 +1,150 @@
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * NAME:
+ *      clock_face.h
+ *
+ * PURPOSE:
+ *      This module provides the clock faces (word table, masks and grid maps)
+ *      used by the display task. The face compiled into the firmware is always
+ *      available, more faces are read in place from the "faces" partition.
+ *
+ * DEPENDENCIES:
+ *      cfg_clock_masks.h
+ *      ESP32 partition API
+ *
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*
+ * (C) Andrew Bright 2023, github.com/e5h
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+
+#ifndef WC_CLOCK_FACE_H
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*][ Include Files ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+
+#include "lib_includes.h"
+#include "cfg_clock.h"
+#include "cfg_clock_masks.h"
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*][ GLOBAL : Constants and Types ][~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+
+#define CLOCK_FACE_PARTITION    "faces"     /* Data partition holding the face image */
+#define CLOCK_FACE_VERSION      (2)         /* Image format, see tools/gen_clock_faces.py */
+#define CLOCK_FACE_MAX          (8)         /* Faces available, including the built-in one */
+#define CLOCK_FACE_BUILTIN      (0)         /* Index of the face compiled into the firmware */
+
+/* Tables of a face, in image order */
+typedef enum{
+    FACE_TABLE_WORDS = 0,       /* CLOCK_FACE_WORD per word */
+    FACE_TABLE_NAMES,           /* NUL terminated words */
+    FACE_TABLE_PIXELS,          /* LED indexes of the words */
+    FACE_TABLE_XY_PIXEL,        /* LED index of each cell, [x * height + y] */
+    FACE_TABLE_PIXEL_X,         /* Column of each LED */
+    FACE_TABLE_PIXEL_Y,         /* Row of each LED (0 = bottom) */
+    FACE_TABLE_WORD_MASKS,      /* CLOCK_PIXEL_MASK per word */
+    FACE_TABLE_SLOT_MASKS,      /* CLOCK_PIXEL_MASK per 5-minute slot */
+    FACE_TABLE_SLOT_HOUR_OFFSET,/* Hour offset per 5-minute slot */
+    FACE_TABLE_SLOT_HOUR_FORM,  /* Hour word form per 5-minute slot */
+    FACE_TABLE_HOUR_MASKS,      /* CLOCK_PIXEL_MASK per hour word form and hour */
+    FACE_TABLE_HASH_SEED,       /* Perfect hash seed per bucket */
+    FACE_TABLE_HASH_SLOT,       /* Word index per hash slot */
+    FACE_TABLE_TRIE,            /* CLOCK_TRIE_NODE per trie node */
+    FACE_TABLE_TRIE_WORDS,      /* Words of each trie node */
+    FACE_TABLE_READ_START,      /* First reading position per word */
+    FACE_TABLE_READ_END,        /* Last reading position per word */
+
+    /* Number of tables */
+    NUM_FACE_TABLES,
+} CLOCK_FACE_TABLE_E;
+
+/* Start of the face image */
+typedef struct{
+    CHAR                magic_c[4];                     /* "WCFC" */
+    UINT16              version_u16;                    /* CLOCK_FACE_VERSION */
+    UINT16              num_faces_u16;
+    UINT32              size_u32;                       /* Bytes in the image, header included */
+    UINT32              crc32_u32;                      /* CRC-32 of the bytes after this header */
+    /* Followed by one UINT32 offset per face, from the start of the image */
+} CLOCK_FACE_IMAGE_HEADER;
+
+/* Start of a face in the image, followed by its tables */
+typedef struct{
+    CHAR                name_c[16];                     /* NUL terminated */
+    CHAR                language_c[8];                  /* NUL terminated */
+    UINT32              size_u32;                       /* Bytes in the face, header included */
+    UINT16              led_count_u16;
+    UINT8               grid_width_u8;
+    UINT8               grid_height_u8;
+    UINT8               led_type_u8;                    /* RGB_LED_TYPE_E */
+    UINT8               mask_words_u8;                  /* 64-bit words per CLOCK_PIXEL_MASK */
+    UINT8               num_words_u8;
+    UINT8               num_slots_u8;                   /* CLOCK_NUM_TIME_SLOTS */
+    UINT8               num_hours_u8;                   /* CLOCK_NUM_HOURS */
+    UINT8               num_hour_forms_u8;              /* CLOCK_NUM_HOURS hour masks per form */
+    UINT16              hash_buckets_u16;               /* Power of 2 */
+    UINT16              hash_slots_u16;                 /* Power of 2 */
+    UINT16              trie_nodes_u16;
+    UINT16              trie_words_u16;
+    UINT16              names_size_u16;
+    UINT16              pixels_size_u16;
+    UINT16              reserved_u16;
+    UINT32              table_u32[ NUM_FACE_TABLES ];   /* Offset of each table, from the start of the face */
+} CLOCK_FACE_HEADER;
+
+/**
+ * A clock face ready to draw
+ *
+ * Only the pointers are kept in RAM, they point into the generated tables
+ * of the built-in face or into the memory-mapped partition.
+ */
+typedef struct{
+    const CLOCK_FACE_HEADER*    header_S;
+    const CLOCK_FACE_WORD*      words_S;
+    const CHAR*                 names_c;
+    const UINT8*                pixels_u8;
+    const UINT8*                xy_pixel_u8;
+    const UINT8*                pixel_x_u8;
+    const UINT8*                pixel_y_u8;
+    const CLOCK_PIXEL_MASK*     word_masks_S;
+    const CLOCK_PIXEL_MASK*     slot_masks_S;
+    const UINT8*                slot_hour_offset_u8;
+    const UINT8*                slot_hour_form_u8;
+    const CLOCK_PIXEL_MASK*     hour_masks_S;
+    const UINT16*               hash_seed_u16;
+    const UINT8*                hash_slot_u8;
+    const CLOCK_TRIE_NODE*      trie_S;
+    const UINT8*                trie_words_u8;
+    const UINT16*               read_start_u16;
+    const UINT16*               read_end_u16;
+} CLOCK_FACE;
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*][ GLOBAL : Exportable Variables ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+
+extern const CLOCK_FACE CLOCK_FACE_builtin_S;
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*][ GLOBAL : Exportable Function Prototypes ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+
+extern STATUS_E CLOCK_FACE_Init( void );
+extern UINT8 CLOCK_FACE_Count( void );
+extern const CLOCK_FACE* CLOCK_FACE_Get( UINT8 index_u8 );
+extern INT32 CLOCK_FACE_Find( const CHAR* name_str );
+
+/* Word of a face */
+static inline const CHAR* CLOCK_FACE_WordName( const CLOCK_FACE* face_S, UINT8 word_u8 )
+{
+    return &face_S->names_c[ face_S->words_S[ word_u8 ].name_u16 ];
+}
+
+static inline const UINT8* CLOCK_FACE_WordPixels( const CLOCK_FACE* face_S, UINT8 word_u8 )
+{
+    return &face_S->pixels_u8[ face_S->words_S[ word_u8 ].pixels_u16 ];
+}
+
+/* End */
+#define WC_CLOCK_FACE_H
+#endif
@@ -19,15 +19,39 @@
 
 #include "lib_includes.h"
 
+#include "esp_timer.h"
+
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ LOCAL : Constants and Types ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 
+#define TIMER_WHEEL_BITS        (6)                             /* Slots per level = 2^bits */
+#define TIMER_WHEEL_SLOTS       (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS      (4)                             /* Level n slots are 64^n ms wide */
+#define TIMER_WHEEL_SPAN_MS     ( (UINT64)1 << ( TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS ) )  /* ~4.6h, longer waits go round again */
+#define TIMER_WHEEL_NONE        (UINT64_MAX)                    /* No deadline */
+
+#if TIMER_IDLE_BENCHMARK == 1
+#define TIMER_BENCH_WINDOW_MS   (5000)  /* Length of each idle measurement */
+#endif
+
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ LOCAL : Variables ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 
-static volatile UINT64 tick_ms_u64 = 0;
+/* Hierarchical timer wheel, level 0 holds the deadlines of the next 64 ms one per slot */
+static TIMER_DEADLINE* wheel_slot_p[ TIMER_WHEEL_LEVELS ][ TIMER_WHEEL_SLOTS ];
+static UINT64 wheel_occupied_u64[ TIMER_WHEEL_LEVELS ];         /* Bit per non-empty slot */
+static UINT64 wheel_ms_u64 = 0;                                 /* First millisecond not processed yet */
+static UINT64 wheel_armed_ms_u64 = TIMER_WHEEL_NONE;            /* Expiry the hardware timer is set for */
+static BOOL wheel_busy_b = FALSE;                               /* Expiring deadlines, arm once done */
+static SemaphoreHandle_t wheel_mutex_h = NULL;                  /* Recursive, callbacks may restart deadlines */
+static esp_timer_handle_t wheel_timer_h = NULL;
+
+#if TIMER_IDLE_BENCHMARK == 1
+static volatile UINT64 bench_tick_ms_u64 = 0;   /* Counter of the old 1 ms tick, rebuilt for comparison */
+static volatile UINT32 bench_wakeups_u32 = 0;   /* Timer wheel expiry passes */
+#endif
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ LOCAL : Function Prototypes ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
@@ -38,21 +62,296 @@ static volatile UINT64 tick_ms_u64 = 0;
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * NAME IN ENGLISH:
+ *      "Get the time since boot in microseconds"
+ *
  * DESCRIPTION:
- *      Adds one millisecond to the tick_ms_u64 variable.
+ *      Reads the 64-bit hardware system timer through esp_timer, which
+ *      latches both halves together, so the value is never torn. No
+ *      interrupt keeps the time, and it keeps counting through light-sleep.
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      (UINT64) microseconds since boot, monotonic
  *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
-extern void TIMER_TickMsUpdate()
+extern UINT64 TIMER_GetTimeUs()
 {
-    tick_ms_u64++;
+    return (UINT64)esp_timer_get_time();
 }
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
  * DESCRIPTION:
- *      Returns the static timer tick variable.
+ *      Returns the time since boot in milliseconds, from the system timer.
  *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 extern UINT64 TIMER_GetTickMs()
 {
-    return tick_ms_u64;
+    return TIMER_GetTimeUs() / 1000;
+}
+
+/* Local helper, put a deadline in the wheel slot for its expiry, the wheel lock is held */
+static void TIMER_wheel_link( TIMER_DEADLINE* deadline_S )
+{
+    UINT64 slot_ms_u64;
+    INT32 level = 0;
+
+    /* Anything already due expires on the next pass */
+    if( deadline_S->expiry_ms_u64 < wheel_ms_u64 )
+    {
+        deadline_S->expiry_ms_u64 = wheel_ms_u64;
+    }
+
+    /* Out of reach, park in the last top level slot and go round again from there */
+    slot_ms_u64 = deadline_S->expiry_ms_u64;
+    if( slot_ms_u64 - wheel_ms_u64 >= TIMER_WHEEL_SPAN_MS )
+    {
+        slot_ms_u64 = wheel_ms_u64 + TIMER_WHEEL_SPAN_MS - 1;
+    }
+
+    /* Lowest level that reaches the expiry within one turn */
+    while( ( slot_ms_u64 - wheel_ms_u64 ) >> ( TIMER_WHEEL_BITS * ( level + 1 ) ) )
+    {
+        level++;
+    }
+
+    deadline_S->level_u8 = level;
+    deadline_S->slot_u8 = ( slot_ms_u64 >> ( TIMER_WHEEL_BITS * level ) ) & ( TIMER_WHEEL_SLOTS - 1 );
+
+    deadline_S->next_p = wheel_slot_p[ level ][ deadline_S->slot_u8 ];
+    if( deadline_S->next_p != NULL )
+    {
+        deadline_S->next_p->prev_pp = &deadline_S->next_p;
+    }
+    deadline_S->prev_pp = &wheel_slot_p[ level ][ deadline_S->slot_u8 ];
+    *deadline_S->prev_pp = deadline_S;
+    wheel_occupied_u64[ level ] |= (UINT64)1 << deadline_S->slot_u8;
+}
+
+/* Local helper, take a deadline out of its slot (or an expiring list), the wheel lock is held */
+static void TIMER_wheel_unlink( TIMER_DEADLINE* deadline_S )
+{
+    if( deadline_S->prev_pp == NULL )
+    {
+        return;
+    }
+
+    *deadline_S->prev_pp = deadline_S->next_p;
+    if( deadline_S->next_p != NULL )
+    {
+        deadline_S->next_p->prev_pp = deadline_S->prev_pp;
+    }
+    deadline_S->next_p = NULL;
+    deadline_S->prev_pp = NULL;
+
+    if( wheel_slot_p[ deadline_S->level_u8 ][ deadline_S->slot_u8 ] == NULL )
+    {
+        wheel_occupied_u64[ deadline_S->level_u8 ] &= ~( (UINT64)1 << deadline_S->slot_u8 );
+    }
+}
+
+/* Local helper, move a whole slot out of the wheel into a list, the wheel lock is held */
+static TIMER_DEADLINE* TIMER_wheel_detach( INT32 level, INT32 slot, TIMER_DEADLINE** list_pp )
+{
+    TIMER_DEADLINE* list_p = wheel_slot_p[ level ][ slot ];
+
+    wheel_slot_p[ level ][ slot ] = NULL;
+    wheel_occupied_u64[ level ] &= ~( (UINT64)1 << slot );
+
+    *list_pp = list_p;
+    if( list_p != NULL )
+    {
+        list_p->prev_pp = list_pp;
+    }
+    return list_p;
+}
+
+/**
+ * Local helper, first occupied slot of a level, counting from the slot at
+ * or after wheel_ms_u64. Returns the millisecond the slot range starts,
+ * when a level 0 slot expires or a higher level slot moves down.
+ */
+static UINT64 TIMER_wheel_first_slot( INT32 level, INT32* slot_i32 )
+{
+    INT32 shift = TIMER_WHEEL_BITS * level;
+    UINT64 occupied_u64 = wheel_occupied_u64[ level ];
+    UINT64 first_u64;
+    UINT32 skip_u32;
+
+    if( occupied_u64 == 0 )
+    {
+        return TIMER_WHEEL_NONE;
+    }
+
+    /* Slot boundary not processed yet, then the occupied slots rotated to start from it */
+    first_u64 = ( wheel_ms_u64 + ( (UINT64)1 << shift ) - 1 ) >> shift;
+    skip_u32 = first_u64 & ( TIMER_WHEEL_SLOTS - 1 );
+    if( skip_u32 != 0 )
+    {
+        occupied_u64 = ( occupied_u64 >> skip_u32 ) | ( occupied_u64 << ( TIMER_WHEEL_SLOTS - skip_u32 ) );
+    }
+    first_u64 += __builtin_ctzll( occupied_u64 );
+
+    *slot_i32 = first_u64 & ( TIMER_WHEEL_SLOTS - 1 );
+    return first_u64 << shift;
+}
+
+/* Local helper, first millisecond with work for the wheel, all levels */
+static UINT64 TIMER_wheel_next_event( void )
+{
+    UINT64 event_ms_u64 = TIMER_WHEEL_NONE;
+    INT32 slot;
+
+    for( INT32 level = 0; level < TIMER_WHEEL_LEVELS; level++ )
+    {
+        UINT64 first_ms_u64 = TIMER_wheel_first_slot( level, &slot );
+
+        if( first_ms_u64 < event_ms_u64 )
+        {
+            event_ms_u64 = first_ms_u64;
+        }
+    }
+
+    return event_ms_u64;
+}
+
+/**
+ * Local helper, earliest expiry in the wheel. Only the first occupied slot
+ * of each level has to be searched, later slots cover later times.
+ */
+static UINT64 TIMER_wheel_next_expiry( void )
+{
+    UINT64 expiry_ms_u64 = TIMER_WHEEL_NONE;
+    INT32 slot;
+
+    for( INT32 level = 0; level < TIMER_WHEEL_LEVELS; level++ )
+    {
+        if( TIMER_wheel_first_slot( level, &slot ) == TIMER_WHEEL_NONE )
+        {
+            continue;
+        }
+
+        for( TIMER_DEADLINE* deadline_S = wheel_slot_p[ level ][ slot ]; deadline_S != NULL; deadline_S = deadline_S->next_p )
+        {
+            if( deadline_S->expiry_ms_u64 < expiry_ms_u64 )
+            {
+                expiry_ms_u64 = deadline_S->expiry_ms_u64;
+            }
+        }
+    }
+
+    return expiry_ms_u64;
+}
+
+/* Local helper, set the hardware timer for the earliest expiry, the wheel lock is held */
+static void TIMER_wheel_arm( void )
+{
+    UINT64 expiry_ms_u64;
+    INT64 wait_us_i64;
+
+    if( wheel_busy_b )
+    {
+        return;
+    }
+
+    expiry_ms_u64 = TIMER_wheel_next_expiry();
+    if( expiry_ms_u64 == wheel_armed_ms_u64 )
+    {
+        return;
+    }
+
+    esp_timer_stop( wheel_timer_h );    /* Fails harmlessly when not running */
+    wheel_armed_ms_u64 = expiry_ms_u64;
+
+    if( expiry_ms_u64 != TIMER_WHEEL_NONE )
+    {
+        wait_us_i64 = (INT64)( expiry_ms_u64 * 1000 ) - esp_timer_get_time();
+        esp_timer_start_once( wheel_timer_h, ( wait_us_i64 > 0 ) ? wait_us_i64 : 0 );
+    }
+}
+
+/**
+ * Local callback of the wheel hardware timer (esp_timer task). Works through
+ * the wheel up to the current millisecond, jumping straight from one slot
+ * with work to the next, then sets the hardware timer for the next expiry.
+ */
+static void TIMER_wheel_expire( void* param )
+{
+    UINT64 now_ms_u64 = TIMER_GetTickMs();
+    TIMER_DEADLINE* list_p;
+    UINT64 event_ms_u64;
+
+    xSemaphoreTakeRecursive( wheel_mutex_h, portMAX_DELAY );
+    wheel_busy_b = TRUE;
+    wheel_armed_ms_u64 = TIMER_WHEEL_NONE;
+#if TIMER_IDLE_BENCHMARK == 1
+    bench_wakeups_u32++;
+#endif
+
+    while( ( event_ms_u64 = TIMER_wheel_next_event() ) <= now_ms_u64 )
+    {
+        wheel_ms_u64 = event_ms_u64;
+
+        /* Slots reaching the start of their range move down a level, lowest level first */
+        for( INT32 level = 1; level < TIMER_WHEEL_LEVELS; level++ )
+        {
+            if( ( event_ms_u64 & ( ( (UINT64)1 << ( TIMER_WHEEL_BITS * level ) ) - 1 ) ) != 0 )
+            {
+                break;
+            }
+
+            TIMER_wheel_detach( level, ( event_ms_u64 >> ( TIMER_WHEEL_BITS * level ) ) & ( TIMER_WHEEL_SLOTS - 1 ), &list_p );
+            while( list_p != NULL )
+            {
+                TIMER_DEADLINE* deadline_S = list_p;
+
+                TIMER_wheel_unlink( deadline_S );
+                TIMER_wheel_link( deadline_S );
+            }
+        }
+
+        /* Deadlines started from the callbacks are due from the next millisecond on */
+        TIMER_wheel_detach( 0, event_ms_u64 & ( TIMER_WHEEL_SLOTS - 1 ), &list_p );
+        wheel_ms_u64 = event_ms_u64 + 1;
+
+        while( list_p != NULL )
+        {
+            TIMER_DEADLINE* deadline_S = list_p;
+
+            TIMER_wheel_unlink( deadline_S );
+
+            /* Periodic deadlines keep their phase, periods already missed are dropped */
+            if( deadline_S->period_ms_u32 != 0 )
+            {
+                deadline_S->expiry_ms_u64 += deadline_S->period_ms_u32;
+                if( deadline_S->expiry_ms_u64 <= now_ms_u64 )
+                {
+                    deadline_S->expiry_ms_u64 += ( ( now_ms_u64 - deadline_S->expiry_ms_u64 ) / deadline_S->period_ms_u32 + 1 )
+                                               * deadline_S->period_ms_u32;
+                }
+                TIMER_wheel_link( deadline_S );
+            }
+
+            if( deadline_S->notify_task_h != NULL )
+            {
+                xTaskNotify( deadline_S->notify_task_h, deadline_S->notify_bits_u32, eSetBits );
+            }
+            if( deadline_S->callback != NULL )
+            {
+                deadline_S->callback( deadline_S->param );
+            }
+        }
+    }
+
+    /* Nothing left before now, later deadlines are placed from here */
+    if( wheel_ms_u64 <= now_ms_u64 )
+    {
+        wheel_ms_u64 = now_ms_u64 + 1;
+    }
+
+    wheel_busy_b = FALSE;
+    TIMER_wheel_arm();
+    xSemaphoreGiveRecursive( wheel_mutex_h );
 }
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
@@ -74,7 +373,7 @@ extern UINT64 TIMER_TimerStartMs( UINT64 duration_ms_u64 )
 {
     UINT64 current_ms_u64;
 
-    current_ms_u64 = tick_ms_u64;
+    current_ms_u64 = TIMER_GetTickMs();
 
     return ( current_ms_u64 + duration_ms_u64 );
 }
@@ -97,7 +396,7 @@ extern BOOL TIMER_TimerHasExpiredMs( UINT64 timestamp_ms_u64 )
 {
     UINT64 current_ms_u64;
 
-    current_ms_u64 = tick_ms_u64;
+    current_ms_u64 = TIMER_GetTickMs();
 
     if( ( current_ms_u64 < timestamp_ms_u64 ) )
     {
@@ -107,4 +406,238 @@ extern BOOL TIMER_TimerHasExpiredMs( UINT64 timestamp_ms_u64 )
     {
         return TRUE;    /* Timer has expired */
     }
-}
\ No newline at end of file
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * NAME IN ENGLISH:
+ *      "Create a countdown timer with microsecond resolution"
+ *
+ * DESCRIPTION:
+ *      Same as TIMER_TimerStartMs(), in microseconds.
+ *
+ * INPUTS:
+ *      (UINT64) duration of the timer in microseconds
+ *
+ * OUTPUTS:
+ *      (UINT64) current timestamp + duration in microseconds
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+extern UINT64 TIMER_TimerStartUs( UINT64 duration_us_u64 )
+{
+    return ( TIMER_GetTimeUs() + duration_us_u64 );
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * NAME IN ENGLISH:
+ *      "Check if a microsecond countdown timer has expired"
+ *
+ * INPUTS:
+ *      (UINT64) timestamp created by "TIMER_TimerStartUs"
+ *
+ * OUTPUTS:
+ *      (BOOL) whether the timer has expired or not
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+extern BOOL TIMER_TimerHasExpiredUs( UINT64 timestamp_us_u64 )
+{
+    return ( TIMER_GetTimeUs() >= timestamp_us_u64 );
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * NAME IN ENGLISH:
+ *      "Start the timer wheel"
+ *
+ * DESCRIPTION:
+ *      Deadlines are kept in a hierarchical timer wheel of 4 levels of 64
+ *      slots: level 0 slots are 1 ms wide, level 1 slots 64 ms, and so on
+ *      up to ~4.6 hours, longer deadlines go round the top level again.
+ *      Starting or stopping a deadline takes constant time. A slot moves
+ *      down a level when its range is reached.
+ *
+ *      A single one-shot esp_timer is set for the earliest expiry, so the
+ *      CPU only wakes when a deadline is due (or a slot has to move down),
+ *      never at a fixed rate. Callbacks and notifications run from the
+ *      esp_timer task, and should be short.
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      STATUS_OK - deadlines can be started
+ *      STATUS_ERR - no memory for the lock or the hardware timer
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+extern STATUS_E TIMER_WheelInit()
+{
+    const esp_timer_create_args_t wheel_timer_args = {
+        .callback = &TIMER_wheel_expire,
+        .name = "timer wheel"
+    };
+
+    wheel_mutex_h = xSemaphoreCreateRecursiveMutex();
+    if( ( wheel_mutex_h == NULL )
+     || ( esp_timer_create( &wheel_timer_args, &wheel_timer_h ) != ESP_OK ) )
+    {
+        ESP_LOGE("TIMER_WheelInit()", "Could not create the timer wheel");
+        return STATUS_ERR;
+    }
+
+    wheel_ms_u64 = TIMER_GetTickMs();
+
+    return STATUS_OK;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * NAME IN ENGLISH:
+ *      "Set up a deadline"
+ *
+ * DESCRIPTION:
+ *      Prepares a stopped deadline. On expiry the task is notified (bits
+ *      set in its notification value, xTaskNotify eSetBits) and then the
+ *      callback is called, either can be left out.
+ *
+ * INPUTS:
+ *      (TIMER_DEADLINE*) deadline, kept by the caller while in use
+ *      (TIMER_CALLBACK) function to call, or NULL
+ *      (void*) parameter of the callback
+ *      (TaskHandle_t) task to notify, or NULL
+ *      (UINT32) notification bits to set in that task
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+extern void TIMER_DeadlineInit( TIMER_DEADLINE* deadline_S, TIMER_CALLBACK callback, void* param,
+                                TaskHandle_t notify_task_h, UINT32 notify_bits_u32 )
+{
+    memset( deadline_S, 0, sizeof(TIMER_DEADLINE) );
+    deadline_S->callback = callback;
+    deadline_S->param = param;
+    deadline_S->notify_task_h = notify_task_h;
+    deadline_S->notify_bits_u32 = notify_bits_u32;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * NAME IN ENGLISH:
+ *      "Start a deadline"
+ *
+ * DESCRIPTION:
+ *      (Re)starts a deadline to expire after the delay, and then every
+ *      period if one is given. Can be called from tasks and from deadline
+ *      callbacks, not from interrupts.
+ *
+ * INPUTS:
+ *      (TIMER_DEADLINE*) deadline set up by TIMER_DeadlineInit()
+ *      (UINT32) delay in milliseconds
+ *      (UINT32) period in milliseconds, 0 = one-shot
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+extern void TIMER_DeadlineStart( TIMER_DEADLINE* deadline_S, UINT32 delay_ms_u32, UINT32 period_ms_u32 )
+{
+    xSemaphoreTakeRecursive( wheel_mutex_h, portMAX_DELAY );
+
+    TIMER_wheel_unlink( deadline_S );
+    deadline_S->expiry_ms_u64 = TIMER_GetTickMs() + delay_ms_u32;
+    deadline_S->period_ms_u32 = period_ms_u32;
+    TIMER_wheel_link( deadline_S );
+    TIMER_wheel_arm();
+
+    xSemaphoreGiveRecursive( wheel_mutex_h );
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * NAME IN ENGLISH:
+ *      "Stop a deadline"
+ *
+ * DESCRIPTION:
+ *      Removes the deadline from the wheel, it does not expire until it is
+ *      started again. Stopping a stopped deadline does nothing.
+ *
+ * INPUTS:
+ *      (TIMER_DEADLINE*) deadline set up by TIMER_DeadlineInit()
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+extern void TIMER_DeadlineStop( TIMER_DEADLINE* deadline_S )
+{
+    xSemaphoreTakeRecursive( wheel_mutex_h, portMAX_DELAY );
+
+    TIMER_wheel_unlink( deadline_S );
+    TIMER_wheel_arm();
+
+    xSemaphoreGiveRecursive( wheel_mutex_h );
+}
+
+#if TIMER_IDLE_BENCHMARK == 1
+/* Local benchmark callback, the work of the old 1 kHz tick */
+static void TIMER_bench_tick( void* param )
+{
+    bench_tick_ms_u64++;
+}
+
+/* Local benchmark helper, share of the CPU time (0.01%) spent in the idle task over one window */
+static UINT32 TIMER_bench_idle( void )
+{
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    UINT32 idle_start_u32 = ulTaskGetIdleRunTimeCounter();
+    UINT32 total_start_u32 = portGET_RUN_TIME_COUNTER_VALUE();
+
+    vTaskDelay( pdMS_TO_TICKS( TIMER_BENCH_WINDOW_MS ) );
+
+    return (UINT64)( ulTaskGetIdleRunTimeCounter() - idle_start_u32 ) * 10000
+         / (UINT32)( portGET_RUN_TIME_COUNTER_VALUE() - total_start_u32 );
+#else
+    return 0;
+#endif
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * NAME IN ENGLISH:
+ *      "Measure the idle time with and without a 1 ms tick"
+ *
+ * DESCRIPTION:
+ *      Logs the share of CPU time spent in the idle task over a window, as
+ *      the firmware runs now (time read from the system timer), then again
+ *      with a 1 kHz esp_timer counting milliseconds the way the time was
+ *      kept before. Also logs how often the timer wheel woke up in the
+ *      first window. Call it from a task once the other tasks are running.
+ *
+ *      Needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS in the sdkconfig.
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+extern void TIMER_IdleBenchmark()
+{
+    esp_timer_handle_t tick_timer_h;
+    UINT32 idle_tickless_u32;
+    UINT32 idle_tick_u32;
+    UINT32 wakeups_u32;
+
+    const esp_timer_create_args_t tick_timer_args = {
+        .callback = &TIMER_bench_tick,
+        .name = "bench 1 ms"
+    };
+
+#if !CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    ESP_LOGE("TIMER_IdleBenchmark()", "Enable CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS");
+    return;
+#endif
+
+    wakeups_u32 = bench_wakeups_u32;
+    idle_tickless_u32 = TIMER_bench_idle();
+    wakeups_u32 = bench_wakeups_u32 - wakeups_u32;
+
+    ESP_ERROR_CHECK(esp_timer_create(&tick_timer_args, &tick_timer_h));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(tick_timer_h, 1000));
+    idle_tick_u32 = TIMER_bench_idle();
+    ESP_ERROR_CHECK(esp_timer_stop(tick_timer_h));
+    ESP_ERROR_CHECK(esp_timer_delete(tick_timer_h));
+
+    ESP_LOGI("TIMER_IdleBenchmark()", "Idle over %d ms: system timer %" PRIu32 ".%02" PRIu32 "%%, 1 ms tick %" PRIu32 ".%02" PRIu32 "%%",
+        TIMER_BENCH_WINDOW_MS, idle_tickless_u32 / 100, idle_tickless_u32 % 100, idle_tick_u32 / 100, idle_tick_u32 % 100);
+    ESP_LOGI("TIMER_IdleBenchmark()", "Timer wheel woke %" PRIu32 " times in %d ms", wakeups_u32, TIMER_BENCH_WINDOW_MS);
+}
+#endif
@@ -17,6 +17,12 @@
 
 #ifndef WC_LIB_TIMER_H
 
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*][ Feature Switches ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+
+#define TIMER_IDLE_BENCHMARK    (0) /* 1 = build TIMER_IdleBenchmark(), 0 = unused */
+
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ Include Files ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
@@ -25,6 +31,28 @@
 /*][ GLOBAL : Constants and Types ][~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 
+/* Function called when a deadline expires */
+typedef void (*TIMER_CALLBACK)( void* param );
+
+/**
+ * Deadline in the timer wheel
+ *
+ * Owned by the caller, set up once with TIMER_DeadlineInit() and then
+ * started and stopped as needed. The fields are private to lib_timer.
+ */
+typedef struct TIMER_DEADLINE{
+    struct TIMER_DEADLINE*  next_p;             /* Next deadline in the same wheel slot */
+    struct TIMER_DEADLINE** prev_pp;            /* Link pointing to this deadline, NULL = stopped */
+    UINT64                  expiry_ms_u64;      /* Time to expire, see TIMER_GetTickMs() */
+    UINT32                  period_ms_u32;      /* Restarted with this period, 0 = one-shot */
+    UINT8                   level_u8;           /* Wheel level and slot holding the deadline */
+    UINT8                   slot_u8;
+    TIMER_CALLBACK          callback;           /* Called on expiry, or NULL */
+    void*                   param;
+    TaskHandle_t            notify_task_h;      /* Task notified on expiry, or NULL */
+    UINT32                  notify_bits_u32;    /* Notification value bits set in that task */
+} TIMER_DEADLINE;
+
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ GLOBAL : Exportable Variables ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
@@ -33,10 +61,22 @@
 /*][ GLOBAL : Exportable Function Prototypes ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 
-extern void     TIMER_TickMsUpdate();
 extern UINT64   TIMER_GetTickMs();
+extern UINT64   TIMER_GetTimeUs();
 extern UINT64   TIMER_TimerStartMs( UINT64 duration_ms_u64 );
 extern BOOL     TIMER_TimerHasExpiredMs( UINT64 timestamp_ms_u64 );
+extern UINT64   TIMER_TimerStartUs( UINT64 duration_us_u64 );
+extern BOOL     TIMER_TimerHasExpiredUs( UINT64 timestamp_us_u64 );
+
+extern STATUS_E TIMER_WheelInit();
+extern void     TIMER_DeadlineInit( TIMER_DEADLINE* deadline_S, TIMER_CALLBACK callback, void* param,
+                                    TaskHandle_t notify_task_h, UINT32 notify_bits_u32 );
+extern void     TIMER_DeadlineStart( TIMER_DEADLINE* deadline_S, UINT32 delay_ms_u32, UINT32 period_ms_u32 );
+extern void     TIMER_DeadlineStop( TIMER_DEADLINE* deadline_S );
+
+#if TIMER_IDLE_BENCHMARK == 1
+extern void     TIMER_IdleBenchmark();
+#endif
 
 /* End */
 #define WC_LIB_TIMER_H
@@ -69,6 +69,7 @@ typedef double      FLOAT64;    /* ( _f64 ) */
 
 typedef enum{
     /* Failure codes */
+    STATUS_BUSY         = -5,   // Resource busy, try again later
     STATUS_ERR_PARAM    = -4,   // Error with passed parameters
     STATUS_NULL_PTR     = -3,   // Null pointer error
     STATUS_QUEUE_ERROR  = -2,   // Error writing to queue
@@ -25,21 +25,22 @@
 #include "rtc.h"
 
 #include "task_display.h"
+#include "clock_face.h"
 // task device
 // task network
 
-#include "esp_timer.h"
 #include "nvs_flash.h"
+#include "esp_pm.h"
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ LOCAL : Constants and Types ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 
 typedef enum{
-    FLAG_1_MS           = 0x01, /* Flag set on 1ms timer callback */
-    FLAG_10_MS          = 0x02, /* Flag set on 10ms timer callback */
     FLAG_100_MS         = 0x04, /* Flag set on 100ms timer callback */
     FLAG_1_SEC          = 0x08, /* Flag set on 1s timer callback */
+    FLAG_RTC_EVENT      = 0x10, /* Flag set by the RTC interrupt (minute rollover) */
+    FLAG_RTC_SYNC       = 0x20, /* Flag set when the cached time is due a resync */
 } E_THREAD_FLAG;
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
@@ -49,11 +50,10 @@ typedef enum{
 /* ESP event groups (flags) */
 EventGroupHandle_t heartbeat_flags;
 
-/* ESP timer handles */
-esp_timer_handle_t timer_handle_1ms;
-esp_timer_handle_t timer_handle_10ms;
-esp_timer_handle_t timer_handle_100ms;
-esp_timer_handle_t timer_handle_1sec;
+/* Timer wheel deadlines */
+static TIMER_DEADLINE deadline_100ms_s;
+static TIMER_DEADLINE deadline_1sec_s;
+static TIMER_DEADLINE deadline_rtc_sync_s;
 
 /* FreeRTOS task handles */
 TaskHandle_t h_task_heartbeat;
@@ -64,6 +64,19 @@ QueueHandle_t q_heartbeat_task;
 // Clock configuration
 static CLOCK_CONFIG clock_config_s;
 
+/* LED grid of the compiled-in face, see the [settings] of cfg_clock_words.txt */
+static const RGB_LED_GEOMETRY led_geometry_s = {
+    .width_u16          = CLOCK_GRID_WIDTH,
+    .height_u16         = CLOCK_GRID_HEIGHT,
+    .leds_per_cell_u8   = WC_RGB_LEDS_PER_CELL,
+    .map_E              = WC_RGB_LED_MAP,
+    .columns_b          = WC_RGB_LED_COLUMNS,
+    .start_right_b      = WC_RGB_LED_START_RIGHT,
+    .start_top_b        = WC_RGB_LED_START_TOP,
+    .num_strips_u8      = WC_RGB_LED_STRIPS,
+    .strip_gpio_u8      = WC_RGB_LED_STRIP_PINS,
+};
+
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ LOCAL : Function Prototypes ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
@@ -187,52 +200,66 @@ static STATUS_E nvs_load_clock_config( CLOCK_CONFIG* new_config_s )
 }
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
- * Timer callback - 1 ms
+ * Timer callback - 100 ms
  *
  * DESCRIPTION:
- *      This function is called every 1 millisecond. The purpose is to wake
+ *      This function is called every 100 milliseconds. The purpose is to wake
  *      certain tasks periodically by setting their task notification bits.
  *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
-void timer_1ms_callback(void *param)
+void timer_100ms_callback(void *param)
 {
-    TIMER_TickMsUpdate(); /* Updates the 1ms tick inside lib_timer */
-    //xEventGroupSetBits( heartbeat_flags, FLAG_1_MS );
+    xEventGroupSetBits(heartbeat_flags, FLAG_100_MS );
 }
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
- * Timer callback - 10 ms
+ * Timer callback - 1 sec
  *
  * DESCRIPTION:
- *      This function is called every 10 milliseconds. The purpose is to wake
- *      certain tasks periodically by setting their task notification bits.
+ *      This function is called on every second edge of the RTC. The purpose
+ *      is to wake certain tasks periodically by setting their task
+ *      notification bits.
  *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
-void timer_10ms_callback(void *param)
+void timer_1sec_callback(void *param)
 {
-    // Set event group bits
+    xEventGroupSetBits(heartbeat_flags, FLAG_1_SEC );
 }
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
- * Timer callback - 100 ms
+ * Start a deadline on an RTC edge
  *
  * DESCRIPTION:
- *      This function is called every 100 milliseconds. The purpose is to wake
- *      certain tasks periodically by setting their task notification bits.
+ *      One shot, expires on the next multiple of period_s_u32 seconds of the
+ *      RTC (see RTC_get_next_edge()). Restarted on every expiry, a periodic
+ *      deadline would slip against the RTC. Runs a plain period until the
+ *      time was read.
  *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
-void timer_100ms_callback(void *param)
+static void deadline_start_on_rtc_edge(TIMER_DEADLINE* deadline_S, UINT32 period_s_u32)
 {
-    xEventGroupSetBits(heartbeat_flags, FLAG_100_MS );
+    UINT64 edge_us_u64;
+    UINT32 delay_ms_u32 = period_s_u32 * 1000;
+
+    if(RTC_get_next_edge(period_s_u32, &edge_us_u64) >= STATUS_OK)
+    {
+        /* Deadlines expire on whole milliseconds, the first one at or after the edge */
+        INT64 delay_ms_i64 = (INT64)((edge_us_u64 + 999) / 1000) - (INT64)TIMER_GetTickMs();
+
+        /* Preempted past the edge, expire right away */
+        delay_ms_u32 = (delay_ms_i64 > 0) ? (UINT32)delay_ms_i64 : 0;
+    }
+
+    TIMER_DeadlineStart(deadline_S, delay_ms_u32, 0);
 }
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
- * Timer callback - 1 sec
+ * Timer callback - RTC resync
  *
  * DESCRIPTION:
- *      This function is called every 1 second. The purpose is to wake
- *      certain tasks periodically by setting their task notification bits.
+ *      One shot, restarted with the interval returned by RTC_sync(). The
+ *      interval grows while the cached time agrees with the RTC.
  *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
-void timer_1sec_callback(void *param)
+void timer_rtc_sync_callback(void *param)
 {
-    xEventGroupSetBits(heartbeat_flags, FLAG_1_SEC );
+    xEventGroupSetBits(heartbeat_flags, FLAG_RTC_SYNC );
 }
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
@@ -256,12 +283,11 @@ void task_heartbeat(void* params )
     };
 
     EventBits_t flags_to_wait;
-    flags_to_wait = FLAG_100_MS | FLAG_1_SEC | new_msg_flag_s;
+    flags_to_wait = FLAG_100_MS | FLAG_1_SEC | FLAG_RTC_EVENT | FLAG_RTC_SYNC | new_msg_flag_s;
 
     UINT8 active_leds[10] = {0}; // Index of which LEDs are active
     
     UINT8 colorIndex_UC = COLOR_Cyan;
-    RGB_COLOR_PCT led_color = RGB_LED_default_colors_S[ colorIndex_UC ];
 
     MESSAGING_subscribe_to_topic(MSG_BUTTONS, &inbox);
 
@@ -334,24 +360,47 @@ void task_heartbeat(void* params )
         if(xEventGroupGetBits(heartbeat_flags ) & FLAG_1_SEC )
         {
             static UINT32 sec_count = 0;
+            static INT32 shown_min_i32 = -1;
+            struct tm now_s;
 
-            led_color = RGB_LED_default_colors_S[ colorIndex_UC ];
-
-            CLOCK_TestWords( led_color );
+            /* Next tick on the next second edge of the RTC */
+            deadline_start_on_rtc_edge(&deadline_1sec_s, 1);
 
-            if( ++colorIndex_UC >= NUM_DEFAULT_COLORS )
+            /* This tick is the edge of a new minute, show it right away */
+            if((RTC_get_time(&now_s) >= STATUS_OK) && (now_s.tm_min != shown_min_i32))
             {
-                colorIndex_UC = 0;
-                CLOCK_UpdateTime(); // test a phrase
+                shown_min_i32 = now_s.tm_min;
+                CLOCK_UpdateTime(&now_s);
+            }
+            else
+            {
+                CLOCK_TestWords( colorIndex_UC );
+
+                if( ++colorIndex_UC >= NUM_DEFAULT_COLORS )
+                {
+                    struct tm rtc_time_s;
+
+                    colorIndex_UC = 0;
+                    if(RTC_get_time(&rtc_time_s) >= STATUS_OK)
+                    {
+                        CLOCK_UpdateTime(&rtc_time_s); // test the time display
+                    }
+                }
             }
 
             sec_count++;
             if(sec_count % 10 == 0)
             {
                 struct tm rtc_time_s;
+                RTC_SYNC_STATS rtc_stats_s;
                 if(RTC_get_time(&rtc_time_s) >= STATUS_OK)
                 {
+                    RTC_get_sync_stats(&rtc_stats_s);
                     ESP_LOGI(LOG_TAG, "Retrieved RTC time: %s", asctime(&rtc_time_s));
+                    ESP_LOGI(LOG_TAG, "RTC drift %ld ppb, last correction %ld us, %lu resyncs (%lu steps), next in %lu s",
+                             (long)rtc_stats_s.drift_ppb_i32, (long)rtc_stats_s.last_error_us_i32,
+                             (unsigned long)rtc_stats_s.resyncs_u32, (unsigned long)rtc_stats_s.steps_u32,
+                             (unsigned long)rtc_stats_s.sync_interval_s_u32);
                 }
                 else
                 {
@@ -362,6 +411,58 @@ void task_heartbeat(void* params )
             /* Clear FLAG_1_SEC */
             xEventGroupClearBits(heartbeat_flags, FLAG_1_SEC );
         }
+
+        /* FLAG_RTC_SYNC - update */
+        if(xEventGroupGetBits(heartbeat_flags ) & FLAG_RTC_SYNC )
+        {
+            UINT32 next_sync_ms_u32;
+
+            if(RTC_sync(&next_sync_ms_u32) < STATUS_OK)
+            {
+                ESP_LOGE(LOG_TAG, "Failed to resync the time from RTC.");
+            }
+            TIMER_DeadlineStart(&deadline_rtc_sync_s, next_sync_ms_u32, 0);
+
+            /* Clear FLAG_RTC_SYNC */
+            xEventGroupClearBits(heartbeat_flags, FLAG_RTC_SYNC );
+        }
+
+        /* FLAG_RTC_EVENT - update */
+        if(xEventGroupGetBits(heartbeat_flags ) & FLAG_RTC_EVENT )
+        {
+            UINT8 rtc_events_u8 = RTC_EVENT_NONE;
+            struct tm rtc_time_s;
+
+            /* Clear FLAG_RTC_EVENT first, an event after the RTC flags are read sets it again */
+            xEventGroupClearBits(heartbeat_flags, FLAG_RTC_EVENT );
+
+            if(RTC_clear_events(&rtc_events_u8) < STATUS_OK)
+            {
+                ESP_LOGE(LOG_TAG, "Failed to clear the RTC events.");
+            }
+
+            /* The cached time may be short of the edge that raised the event, then resync on it */
+            BOOL time_read_b = (RTC_get_time(&rtc_time_s) >= STATUS_OK) ? TRUE : FALSE;
+            if((rtc_events_u8 & RTC_EVENT_MINUTE) && (time_read_b != TRUE || rtc_time_s.tm_sec != 0))
+            {
+                UINT32 next_sync_ms_u32;
+
+                if(RTC_sync(&next_sync_ms_u32) >= STATUS_OK)
+                {
+                    TIMER_DeadlineStart(&deadline_rtc_sync_s, next_sync_ms_u32, 0);
+                }
+                time_read_b = (RTC_get_time(&rtc_time_s) >= STATUS_OK) ? TRUE : FALSE;
+            }
+
+            if(time_read_b == TRUE)
+            {
+                CLOCK_UpdateTime(&rtc_time_s);
+            }
+            else
+            {
+                ESP_LOGE(LOG_TAG, "Failed to get time from RTC.");
+            }
+        }
     }
 }
 
@@ -383,46 +484,51 @@ void app_main(void)
     q_heartbeat_task = xQueueCreate( 10, sizeof(MESSAGE_CONTENT_T) );
 
     /* Set up other peripherals */
-    RGB_LED_Init();
+    RGB_LED_Init( &led_geometry_s, WC_RGB_LED_BACKEND );
+    RGB_LED_SetPowerBudget( WC_RGB_LED_POWER_MA );
+#if RGB_LED_BENCHMARK == 1
+    RGB_LED_Benchmark();
+#endif
+    CLOCK_FACE_Init();
+    CLOCK_Init();
+#if CLOCK_EFFECT_BENCHMARK == 1
+    CLOCK_EffectBenchmark();
+#endif
     RTC_init(PCF85263A_ADDR_7BIT);
 
     /* Initialize I2C driver */
 
 
-    /* Set up timers */
-    /* 1 ms timer */
-    const esp_timer_create_args_t timer_args_1ms = {
-        .callback = &timer_1ms_callback,
-        .name = "1 ms timer"
+    /* Set up timers, all periodic work is a deadline in the lib_timer wheel */
+    TIMER_WheelInit();
+
+    /* 100ms deadline */
+    TIMER_DeadlineInit(&deadline_100ms_s, &timer_100ms_callback, NULL, NULL, 0);
+    TIMER_DeadlineStart(&deadline_100ms_s, 100, 100);
+
+    /* RTC resync deadline, RTC_init() read the time once */
+    TIMER_DeadlineInit(&deadline_rtc_sync_s, &timer_rtc_sync_callback, NULL, NULL, 0);
+    TIMER_DeadlineStart(&deadline_rtc_sync_s, RTC_SYNC_MIN_S * 1000, 0);
+
+#if WC_RTC_INT_PIN >= 0
+    /* Set up interrupts, the RTC wakes the heartbeat on every minute rollover */
+    RTC_enable_events(WC_RTC_INT_PIN, RTC_EVENT_MINUTE, heartbeat_flags, FLAG_RTC_EVENT);
+    xEventGroupSetBits(heartbeat_flags, FLAG_RTC_EVENT ); // Show the time now, not at the next minute
+#else
+    /* 1sec deadline on the second edges of the RTC, polls the time when ~INTA is not wired */
+    TIMER_DeadlineInit(&deadline_1sec_s, &timer_1sec_callback, NULL, NULL, 0);
+    deadline_start_on_rtc_edge(&deadline_1sec_s, 1);
+#endif
+
+#if CONFIG_PM_ENABLE && CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    /* Light sleep whenever every task is blocked, the timer wheel and the RTC interrupt wake the chip */
+    esp_pm_config_t pm_config_s = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_XTAL_FREQ,
+        .light_sleep_enable = true,
     };
-    ESP_ERROR_CHECK(esp_timer_create(&timer_args_1ms, &timer_handle_1ms));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(timer_handle_1ms, 1000));
-
-    /* 10ms timer */
-    const esp_timer_create_args_t timer_args_10ms = {
-        .callback = &timer_10ms_callback,
-        .name = "10 ms timer"
-    };
-    ESP_ERROR_CHECK(esp_timer_create(&timer_args_10ms, &timer_handle_10ms));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(timer_handle_10ms, 10000));
-
-    /* 100ms timer */
-    const esp_timer_create_args_t timer_args_100ms = {
-        .callback = &timer_100ms_callback,
-        .name = "100 ms timer"
-    };
-    ESP_ERROR_CHECK(esp_timer_create(&timer_args_100ms, &timer_handle_100ms));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(timer_handle_100ms, 100000));
-
-    /* 1sec timer */
-    const esp_timer_create_args_t timer_args_1sec = {
-        .callback = &timer_1sec_callback,
-        .name = "1 sec timer"
-    };
-    ESP_ERROR_CHECK(esp_timer_create(&timer_args_1sec, &timer_handle_1sec));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(timer_handle_1sec, 1000000));
-
-    /* Set up interrupts */
+    ESP_ERROR_CHECK(esp_pm_configure(&pm_config_s));
+#endif
 
     /* Set up tasks */
     xTaskCreate(&task_heartbeat, "RGB Led Task", 4096, NULL, 2, &h_task_heartbeat );
@@ -430,4 +536,8 @@ void app_main(void)
     /* GPIO settings */
     gpio_set_direction(GPIO_NUM_8, GPIO_MODE_INPUT_OUTPUT);
     gpio_set_direction(GPIO_NUM_10, GPIO_MODE_INPUT_OUTPUT);
+
+#if TIMER_IDLE_BENCHMARK == 1
+    TIMER_IdleBenchmark();
+#endif
 }
@@ -4,7 +4,7 @@
  *
  * PURPOSE:
  *      This module is designed to provide simple functions to control RGB leds
- *      using the RMT peripheral of the ESP32.
+ *      using the RMT peripheral of the ESP32, or the SPI peripheral with DMA.
  *
  * DEPENDENCIES:
  *      ---
@@ -19,15 +19,29 @@
 
 #include "rgb_rmt.h"
 #include "cfg_clock.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "driver/spi_master.h"
+
+#if RGB_LED_BENCHMARK == 1
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#endif
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ LOCAL : Constants and Types ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 
 #define RGB_LED_PIN         WC_RGB_LED_PIN
-#define RGB_LED_COUNT       WC_RGB_LED_COUNT
 #define RGB_LED_TYPE        WC_RGB_LED_TYPE
 
+/* Wire format of the LED type, constant so the packing folds to one channel order */
+#define RGB_LED_PIXEL_BYTES (RGB_LED_all_params_S[ RGB_LED_TYPE ].pixel_sz_bytes)
+#define RGB_LED_ORDER       (RGB_LED_all_params_S[ RGB_LED_TYPE ].order_E)
+
+#define RGB_SPI_HOST        (SPI2_HOST) /* General purpose SPI, SPI0/1 belong to the flash */
+#define RGB_SPI_SLOTS       (4)         /* SPI bits per LED bit, so one LED byte is 4 SPI bytes */
+
 /* Struct for an RGBLED encoder */
 typedef struct{
     rmt_encoder_t       base;
@@ -35,14 +49,59 @@ typedef struct{
     rmt_encoder_t       *copy_encoder;
     rmt_symbol_word_t   reset_code;
     INT32               encoder_state;
+    INT32               pixel_index_i32;        /* Pixel currently being encoded */
+    UINT8               led_repeat_u8;          /* LEDs of the current cell already sent */
+    BOOL                pixel_loaded_b;         /* pixel_bytes_u8 holds the current pixel */
+    UINT8               pixel_bytes_u8[ RGB_LED_MAX_PIXEL_BYTES ];  /* Wire bytes of the current pixel */
 } RGB_LED_ENCODER;
 
-/* Struct to hold a 24-bit RGB encoded color */
-typedef struct __attribute__ ((packed)){
-    UINT8 red_U8;
-    UINT8 green_U8;
-    UINT8 blue_U8;
-} RGB_COLOR_24BIT;
+/* One LED chain on its own RMT TX channel, sending a run of the pixels */
+typedef struct{
+    rmt_channel_handle_t    channel_h;
+    rmt_encoder_handle_t    encoder_h;          /* Own RGB_LED_ENCODER, encoders keep per-transmission state */
+    INT32                   first_pixel_i32;    /* First pixel of the strip */
+    INT32                   num_pixels_i32;     /* Pixels on the strip */
+    volatile UINT32         frames_done_u32;    /* Transmissions completed, counted by the ISR */
+} RGB_LED_STRIP;
+
+/**
+ * LED output backend
+ *
+ * The pixel store, dithering and frame accounting are shared, a backend
+ * only turns the first pixels of the store into a transmission. init()
+ * reads rgb_geometry_S and the strips, transmit() is called with a free
+ * frame slot and calls RGB_LED_FrameDoneFromISR() when the frame is out.
+ */
+typedef struct{
+    STRING              name_str;
+    STATUS_E            (*init)( void );
+    void                (*deinit)( void );                  /* Only when no frame is in flight */
+    INT32               (*transmit)( INT32 num_pixels_i32 ); /* Queue a frame, returns the pixels sent */
+    void                (*wait_done)( void );               /* Block until every queued frame is out */
+    void                (*idle)( void );                    /* Optional, release the peripheral until the next transmit(), nothing in flight */
+} RGB_LED_BACKEND;
+
+/* Channels of a stored pixel */
+enum{
+    PIXEL_RED = 0,
+    PIXEL_GREEN,
+    PIXEL_BLUE,
+    PIXEL_LEVEL,
+    PIXEL_WHITE = PIXEL_LEVEL,  /* Wire bytes only, white output of an RGBW pixel */
+};
+
+/**
+ * Stored state of a single pixel
+ *
+ * The color (0 - 255 per channel) and brightness (0 - 100) are kept as they
+ * were set, gamma and global brightness are applied by the encoder. The
+ * store is only touched in task context, a backend encodes in the ISR from
+ * its own copy of the frame taken at transmit().
+ */
+typedef union{
+    UINT8   channel_u8[4];
+    UINT32  word_u32;
+} RGB_PIXEL;
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ LOCAL : Variables ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
@@ -59,48 +118,284 @@ static const UINT8 gamma_lut[101] = {
    167, 171, 175, 179, 184, 188, 192, 197, 201, 206, 211, 215, 220, 225, 230, 235,
    240, 245, 250, 255, 255 };
 
-/* All known timing parameters for common RGB LEDs */
+/* All known timing and current (worst case, per LED) parameters for common RGB LEDs */
 static const RGB_LED_TYPE_PARAMS RGB_LED_all_params_S[] = {
-    [LED_WS2812_V1]   = { .pixel_sz_bytes = 3, .T0H = 0.35, .T1H = 0.70, .T0L = 0.80, .T1L = 0.60, .TRS =  50.0},
-    [LED_WS2812B_V1]  = { .pixel_sz_bytes = 3, .T0H = 0.35, .T1H = 0.90, .T0L = 0.90, .T1L = 0.35, .TRS =  50.0},
-    [LED_WS2812B_V2]  = { .pixel_sz_bytes = 3, .T0H = 0.40, .T1H = 0.85, .T0L = 0.85, .T1L = 0.40, .TRS =  50.0},
-    [LED_WS2812B_V3]  = { .pixel_sz_bytes = 3, .T0H = 0.45, .T1H = 0.85, .T0L = 0.85, .T1L = 0.45, .TRS =  50.0},
-    [LED_WS2813_V1]   = { .pixel_sz_bytes = 3, .T0H = 0.35, .T1H = 0.80, .T0L = 0.35, .T1L = 0.35, .TRS = 300.0},
-    [LED_WS2813_V2]   = { .pixel_sz_bytes = 3, .T0H = 0.27, .T1H = 0.80, .T0L = 0.80, .T1L = 0.27, .TRS = 300.0},
-    [LED_WS2813_V3]   = { .pixel_sz_bytes = 3, .T0H = 0.27, .T1H = 0.63, .T0L = 0.63, .T1L = 0.27, .TRS = 300.0},
-    [LED_SK6812_V1]   = { .pixel_sz_bytes = 3, .T0H = 0.30, .T1H = 0.60, .T0L = 0.90, .T1L = 0.60, .TRS =  80.0},
-    [LED_PI554FCH]    = { .pixel_sz_bytes = 3, .T0H = 0.30, .T1H = 0.60, .T0L = 0.90, .T1L = 0.60, .TRS =  80.0},
+    [LED_WS2812_V1]      = { .pixel_sz_bytes = 3, .order_E = LED_ORDER_GRB,  .T0H = 0.35, .T1H = 0.70, .T0L = 0.80, .T1L = 0.60, .TRS =  50.0, .mA_R = 20.0, .mA_G = 20.0, .mA_B = 20.0, .mA_W =  0.0, .mA_Q = 1.0},
+    [LED_WS2812B_V1]     = { .pixel_sz_bytes = 3, .order_E = LED_ORDER_GRB,  .T0H = 0.35, .T1H = 0.90, .T0L = 0.90, .T1L = 0.35, .TRS =  50.0, .mA_R = 20.0, .mA_G = 20.0, .mA_B = 20.0, .mA_W =  0.0, .mA_Q = 1.0},
+    [LED_WS2812B_V2]     = { .pixel_sz_bytes = 3, .order_E = LED_ORDER_GRB,  .T0H = 0.40, .T1H = 0.85, .T0L = 0.85, .T1L = 0.40, .TRS =  50.0, .mA_R = 20.0, .mA_G = 20.0, .mA_B = 20.0, .mA_W =  0.0, .mA_Q = 1.0},
+    [LED_WS2812B_V3]     = { .pixel_sz_bytes = 3, .order_E = LED_ORDER_GRB,  .T0H = 0.45, .T1H = 0.85, .T0L = 0.85, .T1L = 0.45, .TRS =  50.0, .mA_R = 20.0, .mA_G = 20.0, .mA_B = 20.0, .mA_W =  0.0, .mA_Q = 1.0},
+    [LED_WS2813_V1]      = { .pixel_sz_bytes = 3, .order_E = LED_ORDER_GRB,  .T0H = 0.35, .T1H = 0.80, .T0L = 0.35, .T1L = 0.35, .TRS = 300.0, .mA_R = 20.0, .mA_G = 20.0, .mA_B = 20.0, .mA_W =  0.0, .mA_Q = 1.0},
+    [LED_WS2813_V2]      = { .pixel_sz_bytes = 3, .order_E = LED_ORDER_GRB,  .T0H = 0.27, .T1H = 0.80, .T0L = 0.80, .T1L = 0.27, .TRS = 300.0, .mA_R = 20.0, .mA_G = 20.0, .mA_B = 20.0, .mA_W =  0.0, .mA_Q = 1.0},
+    [LED_WS2813_V3]      = { .pixel_sz_bytes = 3, .order_E = LED_ORDER_GRB,  .T0H = 0.27, .T1H = 0.63, .T0L = 0.63, .T1L = 0.27, .TRS = 300.0, .mA_R = 20.0, .mA_G = 20.0, .mA_B = 20.0, .mA_W =  0.0, .mA_Q = 1.0},
+    [LED_SK6812_V1]      = { .pixel_sz_bytes = 3, .order_E = LED_ORDER_GRB,  .T0H = 0.30, .T1H = 0.60, .T0L = 0.90, .T1L = 0.60, .TRS =  80.0, .mA_R = 20.0, .mA_G = 20.0, .mA_B = 20.0, .mA_W =  0.0, .mA_Q = 1.0},
+    [LED_PI554FCH]       = { .pixel_sz_bytes = 3, .order_E = LED_ORDER_GRB,  .T0H = 0.30, .T1H = 0.60, .T0L = 0.90, .T1L = 0.60, .TRS =  80.0, .mA_R = 20.0, .mA_G = 20.0, .mA_B = 20.0, .mA_W =  0.0, .mA_Q = 1.0},
+    [LED_SK6812_RGBW_V1] = { .pixel_sz_bytes = 4, .order_E = LED_ORDER_GRBW, .T0H = 0.30, .T1H = 0.60, .T0L = 0.90, .T1L = 0.60, .TRS =  80.0, .mA_R = 20.0, .mA_G = 20.0, .mA_B = 20.0, .mA_W = 20.0, .mA_Q = 1.0},
+    [LED_WS2811_V1]      = { .pixel_sz_bytes = 3, .order_E = LED_ORDER_RGB,  .T0H = 0.25, .T1H = 0.60, .T0L = 1.00, .T1L = 0.65, .TRS = 280.0, .mA_R = 18.5, .mA_G = 18.5, .mA_B = 18.5, .mA_W =  0.0, .mA_Q = 1.0},
 };
 
-/* Definitions for default colors, (0.0 - 1.0) = (0 - 255) */
-const RGB_COLOR_PCT RGB_LED_default_colors_S[] = {
-    {.r = 1.0, .g = 0.0, .b = 0.0}, /* COLOR_Red */
-    {.r = 1.0, .g = 0.5, .b = 0.0}, /* COLOR_Orange */
-    {.r = 1.0, .g = 1.0, .b = 0.0}, /* COLOR_Yellow */
-    {.r = 0.5, .g = 1.0, .b = 0.0}, /* COLOR_Lime */
-    {.r = 0.0, .g = 1.0, .b = 0.0}, /* COLOR_Green */
-    {.r = 0.0, .g = 1.0, .b = 0.5}, /* COLOR_Mint */
-    {.r = 0.0, .g = 1.0, .b = 1.0}, /* COLOR_Cyan */
-    {.r = 0.0, .g = 0.5, .b = 1.0}, /* COLOR_Azure */
-    {.r = 0.0, .g = 0.0, .b = 1.0}, /* COLOR_Blue */
-    {.r = 0.5, .g = 0.0, .b = 1.0}, /* COLOR_Purple */
-    {.r = 1.0, .g = 0.0, .b = 1.0}, /* COLOR_Pink */
-    {.r = 1.0, .g = 0.0, .b = 0.5}  /* COLOR_Rose */
+/* Definitions for default colors, (0 - 255) = (0 - 100%) */
+const RGB_COLOR RGB_LED_default_colors_S[] = {
+    {.r = 255, .g =   0, .b =   0}, /* COLOR_Red */
+    {.r = 255, .g = 128, .b =   0}, /* COLOR_Orange */
+    {.r = 255, .g = 255, .b =   0}, /* COLOR_Yellow */
+    {.r = 128, .g = 255, .b =   0}, /* COLOR_Lime */
+    {.r =   0, .g = 255, .b =   0}, /* COLOR_Green */
+    {.r =   0, .g = 255, .b = 128}, /* COLOR_Mint */
+    {.r =   0, .g = 255, .b = 255}, /* COLOR_Cyan */
+    {.r =   0, .g = 128, .b = 255}, /* COLOR_Azure */
+    {.r =   0, .g =   0, .b = 255}, /* COLOR_Blue */
+    {.r = 128, .g =   0, .b = 255}, /* COLOR_Purple */
+    {.r = 255, .g =   0, .b = 255}, /* COLOR_Pink */
+    {.r = 255, .g =   0, .b = 128}  /* COLOR_Rose */
 };
 
-static RGB_COLOR_PCT pixel_colors_pct_S[ RGB_LED_COUNT ];       /* Saved color for each pixel */
-static RGB_COLOR_24BIT pixel_colors_24bit_S[ RGB_LED_COUNT ];   /* Converted color for each pixel */
-static UINT8 pixel_tx_buffer_u8[ RGB_LED_COUNT * 3 ];           /* Entire LED pixel buffer to send */
+static RGB_LED_GEOMETRY rgb_geometry_S;                         /* Grid and chain layout given at init */
+static INT32 rgb_num_pixels_i32 = 0;                            /* Cells of the grid, width * height */
+static void* rgb_arena_p = NULL;                                /* Single allocation behind the buffers below */
+
+static RGB_PIXEL* pixel_store_S = NULL;                         /* Color and brightness of each pixel */
+static volatile UINT8 global_brightness_u8 = 100;               /* Set by RGB_LED_SetGlobalBrightness() */
+static volatile UINT8 tx_brightness_u8 = 100;                   /* Global brightness within the power budget, applied while encoding */
+static SemaphoreHandle_t tx_slots_free_s = NULL;                /* Count of transmissions not in flight */
+static TaskHandle_t tx_notify_task_h = NULL;                    /* Task to notify when a frame is sent */
 
-static rmt_channel_handle_t RGB_channel_handle = NULL;
-static rmt_encoder_handle_t RGB_encoder_handle = NULL;
+static RGB_LED_STRIP rgb_strips_S[ RGB_LED_MAX_STRIPS ];        /* Strips in pixel order */
+static INT32 rgb_num_strips_i32 = 1;
+static UINT32 tx_frames_done_u32 = 0;                           /* Frames completed on every strip, ISR only */
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+static rmt_sync_manager_handle_t RGB_sync_handle = NULL;        /* Starts the strips together, NULL = one strip */
+#endif
+static BOOL rgb_rmt_enabled_b = FALSE;                          /* RMT channels enabled, each holds a power management lock */
 
 static RGB_LED_TYPE_PARAMS RGB_LED_params_S;
+static const RGB_LED_BACKEND* rgb_backend_S = NULL;
+
+/* Channel sent in each wire byte, per RGB_LED_ORDER_E */
+static const UINT8 rgb_wire_order_u8[][ RGB_LED_MAX_PIXEL_BYTES ] = {
+    [LED_ORDER_GRB]  = { PIXEL_GREEN, PIXEL_RED,   PIXEL_BLUE },
+    [LED_ORDER_RGB]  = { PIXEL_RED,   PIXEL_GREEN, PIXEL_BLUE },
+    [LED_ORDER_GRBW] = { PIXEL_GREEN, PIXEL_RED,   PIXEL_BLUE, PIXEL_WHITE },
+};
+
+static RGB_PIXEL* rmt_frames_S = NULL;                          /* Copy of the pixels of each frame slot, rgb_num_pixels_i32 each */
+static volatile UINT8 rmt_frame_brightness_u8[ RGB_LED_TX_IN_FLIGHT ];  /* tx_brightness_u8 of each frame slot */
+static INT32 rmt_next_frame_i32 = 0;
+
+static spi_device_handle_t RGB_spi_handle = NULL;
+static UINT8* spi_buffer_u8[ RGB_LED_TX_IN_FLIGHT ] = { NULL };  /* DMA buffers, used in turn */
+static spi_transaction_t spi_transaction_S[ RGB_LED_TX_IN_FLIGHT ];
+static INT32 spi_next_buffer_i32 = 0;
+static INT32 spi_reset_bytes_i32 = 0;                           /* Low SPI bytes for the LED reset */
+static UINT32 spi_byte_lut_u32[ 256 ];                          /* SPI bits of each LED byte, MSB first */
+
+#if RGB_LED_BENCHMARK == 1
+static volatile UINT32 bench_isr_count_u32 = 0;                 /* Refill / completion interrupts */
+static volatile UINT32 bench_isr_cycles_u32 = 0;                /* CPU cycles spent encoding in them */
+#endif
+
+static INT32 pixel_dirty_max_i32 = -1;      /* Highest pixel changed since the last latch, -1 = none */
+static UINT64 tx_bytes_saved_u64 = 0;       /* Bytes not sent thanks to prefix truncation */
+
+static UINT32 power_step_uA_u32[ RGB_LED_MAX_PIXEL_BYTES ];     /* Current of one gamma_lut step, red, green, blue, white */
+static UINT32 power_idle_uA_u32 = 0;                            /* Current of a dark LED */
+static UINT32 power_cells_uA_u32 = 0;                           /* Estimate of the lit pixels at 100% global brightness, one LED each */
+static UINT32 power_budget_mA_u32 = 0;                          /* LED supply budget, 0 = unlimited */
+static UINT32 power_frame_mA_u32 = 0;                           /* Estimate of the last frame sent */
+static UINT32 power_limited_frames_u32 = 0;                     /* Frames dimmed to stay within the budget */
+
+static volatile BOOL dither_enabled_b = FALSE;                  /* Temporal dithering of the wire bytes */
+static UINT8 (*dither_error_u8)[ RGB_LED_MAX_PIXEL_BYTES ] = NULL;  /* Fraction carried to the next frame, per wire byte */
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ Function Definitions ][~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 
+/* Local helper, scale a 0 - 255 channel by a 0 - 100 brightness into a LUT index */
+static inline UINT8 RGB_LED_LutIndex( UINT8 channel_u8, UINT8 brightness_u8 )
+{
+    return (UINT8)( ( ( (UINT32)channel_u8 * brightness_u8 ) + 127u ) / 255u );
+}
+
+/*
+ * Local helper, 8.8 fixed point output level for a 0 - 255 channel at a
+ * 0 - 10000 combined brightness (pixel level * global level).
+ *
+ * Same curve as gamma_lut (255 * (x / 99)^2) but without the 1% input steps
+ * and with 8 fractional bits, the fraction is what dithering spreads over
+ * the following frames.
+ */
+static inline UINT32 RGB_LED_GammaQ8( UINT8 channel_u8, UINT32 level_u32 )
+{
+    /* Channel * level scaled so 99% of full scale = 65535 (851 / 2^15 ~= 65535 / (255 * 9900)) */
+    UINT32 linear_u32 = ( (UINT32)channel_u8 * level_u32 * 851u ) >> 15;
+
+    if( linear_u32 > 0xFFFF )
+    {
+        linear_u32 = 0xFFFF;
+    }
+
+    /* Square for gamma 2.0, then scale 0 - 65535 to 0 - 255.255 */
+    return ( ( ( linear_u32 * linear_u32 ) >> 16 ) * 255u ) >> 8;
+}
+
+/* Local helper, RGBW: the light all three channels share comes from the white LED instead */
+static inline void RGB_LED_SplitWhite( UINT32* output_u32 )
+{
+    if( RGB_LED_ORDER == LED_ORDER_GRBW )
+    {
+        UINT32 white_u32 = output_u32[ PIXEL_RED ];
+
+        if( output_u32[ PIXEL_GREEN ] < white_u32 ) white_u32 = output_u32[ PIXEL_GREEN ];
+        if( output_u32[ PIXEL_BLUE ] < white_u32 )  white_u32 = output_u32[ PIXEL_BLUE ];
+
+        output_u32[ PIXEL_RED ] -= white_u32;
+        output_u32[ PIXEL_GREEN ] -= white_u32;
+        output_u32[ PIXEL_BLUE ] -= white_u32;
+        output_u32[ PIXEL_WHITE ] = white_u32;
+    }
+}
+
+/**
+ * Local helper, estimated current (uA) of one LED showing a stored pixel at
+ * 100% global brightness, above the dark LED current. Uses the same gamma
+ * curve as the wire bytes, so the current is linear in the output steps.
+ */
+static UINT32 RGB_LED_PixelCurrent( RGB_PIXEL pixel )
+{
+    UINT32 output_u32[ RGB_LED_MAX_PIXEL_BYTES ];
+    UINT32 current_u32 = 0;
+
+    for( INT32 channel = PIXEL_RED; channel <= PIXEL_BLUE; channel++ )
+    {
+        output_u32[ channel ] = gamma_lut[ RGB_LED_LutIndex( pixel.channel_u8[ channel ], pixel.channel_u8[ PIXEL_LEVEL ] ) ];
+    }
+
+    RGB_LED_SplitWhite( output_u32 );
+
+    for( INT32 channel = 0; channel < RGB_LED_PIXEL_BYTES; channel++ )
+    {
+        current_u32 += output_u32[ channel ] * power_step_uA_u32[ channel ];
+    }
+
+    return current_u32;
+}
+
+/**
+ * Local helper, global brightness for the next frame. The pixel current
+ * goes with the square of the global brightness (gamma 2.0), so when the
+ * estimate is over the budget the brightness is scaled down by the square
+ * root of budget / estimate, which brings the frame back to the budget.
+ */
+static UINT8 RGB_LED_PowerLimit( void )
+{
+    UINT32 brightness_u32 = global_brightness_u8;
+    UINT32 num_leds_u32 = rgb_num_pixels_i32 * rgb_geometry_S.leds_per_cell_u8;
+    UINT64 idle_uA_u64 = (UINT64)num_leds_u32 * power_idle_uA_u32;
+    UINT64 full_uA_u64 = (UINT64)power_cells_uA_u32 * rgb_geometry_S.leds_per_cell_u8;
+    UINT64 budget_uA_u64 = (UINT64)power_budget_mA_u32 * 1000;
+    UINT64 lit_uA_u64 = full_uA_u64 * brightness_u32 * brightness_u32 / 10000;
+
+    if( ( power_budget_mA_u32 != 0 )
+     && ( idle_uA_u64 + lit_uA_u64 > budget_uA_u64 ) )
+    {
+        /* Lit current allowed, as 0 - 10000 of the current at 100%, always below brightness^2 here */
+        UINT32 ratio_u32 = ( budget_uA_u64 > idle_uA_u64 ) ? ( budget_uA_u64 - idle_uA_u64 ) * 10000 / full_uA_u64 : 0;
+
+        while( brightness_u32 * brightness_u32 > ratio_u32 )
+        {
+            brightness_u32--;
+        }
+        lit_uA_u64 = full_uA_u64 * brightness_u32 * brightness_u32 / 10000;
+    }
+
+    power_frame_mA_u32 = ( idle_uA_u64 + lit_uA_u64 + 500 ) / 1000;
+
+    return brightness_u32;
+}
+
+/**
+ * Local helper, converts one stored pixel to its wire bytes (shared by the
+ * backends).
+ *
+ * RGB_LED_PIXEL_BYTES and RGB_LED_ORDER are constants of the LED type, so
+ * the loops and the white extraction fold to the one wire format in use.
+ */
+static void RGB_LED_WireBytes( RGB_PIXEL pixel, INT32 index_i32, UINT8 brightness_u8, UINT8* bytes_u8 )
+{
+    const UINT8* order_u8 = rgb_wire_order_u8[ RGB_LED_ORDER ];
+    UINT32 output_u32[ RGB_LED_MAX_PIXEL_BYTES ];   /* 8.8 fixed point output of each channel */
+
+    if( dither_enabled_b )
+    {
+        UINT32 level_u32 = pixel.channel_u8[ PIXEL_LEVEL ] * brightness_u8;
+
+        for( INT32 channel = PIXEL_RED; channel <= PIXEL_BLUE; channel++ )
+        {
+            output_u32[ channel ] = RGB_LED_GammaQ8( pixel.channel_u8[ channel ], level_u32 );
+        }
+    }
+    else
+    {
+        UINT8 level_u8 = ( ( pixel.channel_u8[ PIXEL_LEVEL ] * brightness_u8 ) + 50 ) / 100;
+
+        for( INT32 channel = PIXEL_RED; channel <= PIXEL_BLUE; channel++ )
+        {
+            output_u32[ channel ] = (UINT32)gamma_lut[ RGB_LED_LutIndex( pixel.channel_u8[ channel ], level_u8 ) ] << 8;
+        }
+    }
+
+    RGB_LED_SplitWhite( output_u32 );
+
+    if( dither_enabled_b )
+    {
+        /* First order error diffusion in time: send the integer part, carry the fraction */
+        for( INT32 byte = 0; byte < RGB_LED_PIXEL_BYTES; byte++ )
+        {
+            UINT32 target_u32 = output_u32[ order_u8[ byte ] ] + dither_error_u8[ index_i32 ][ byte ];
+
+            bytes_u8[ byte ] = target_u32 >> 8;
+            dither_error_u8[ index_i32 ][ byte ] = target_u32 & 0xFF;
+        }
+    }
+    else
+    {
+        for( INT32 byte = 0; byte < RGB_LED_PIXEL_BYTES; byte++ )
+        {
+            bytes_u8[ byte ] = output_u32[ order_u8[ byte ] ] >> 8;
+        }
+    }
+}
+
+/*
+ * Local helper, releases a frame slot once a frame is out, called from ISR
+ * context by the backends.
+ */
+static IRAM_ATTR void RGB_LED_FrameDoneFromISR( BaseType_t* task_woken )
+{
+    /* Another transmission may be queued */
+    xSemaphoreGiveFromISR( tx_slots_free_s, task_woken );
+
+    if( tx_notify_task_h != NULL )
+    {
+        vTaskNotifyGiveFromISR( tx_notify_task_h, task_woken );
+    }
+}
+
+/*
+ * Local helper, fill pixel_bytes_u8 with the wire bytes of the next pixel.
+ * pixels_S is the start of the strip being sent, inside a frame slot of
+ * rmt_frames_S, which gives the pixel index and the brightness of the frame.
+ */
+static void RGB_RMT_load_pixel( RGB_LED_ENCODER* RGB_encoder, const RGB_PIXEL* pixels_S )
+{
+    INT32 offset_i32 = ( pixels_S - rmt_frames_S ) + RGB_encoder->pixel_index_i32;
+    INT32 frame_i32 = offset_i32 / rgb_num_pixels_i32;
+
+    RGB_LED_WireBytes( rmt_frames_S[ offset_i32 ], offset_i32 - frame_i32 * rgb_num_pixels_i32,
+        rmt_frame_brightness_u8[ frame_i32 ], RGB_encoder->pixel_bytes_u8 );
+    RGB_encoder->pixel_loaded_b = TRUE;
+}
+
 /* Local encoder function */
 static size_t RGB_RMT_encode(rmt_encoder_t *encoder, rmt_channel_handle_t channel,
     const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
@@ -118,25 +413,53 @@ static size_t RGB_RMT_encode(rmt_encoder_t *encoder, rmt_channel_handle_t channe
     /* Record number of encoded symbols */
     size_t encoded_symbols = 0;
 
+    /* Primary data is the run of a frame slot on this strip, one RGB_PIXEL per cell */
+    const RGB_PIXEL* pixels_S = primary_data;
+    INT32 num_pixels_i32 = data_size / sizeof(RGB_PIXEL);
+
+#if RGB_LED_BENCHMARK == 1
+    UINT32 bench_start_u32 = esp_cpu_get_cycle_count();
+    bench_isr_count_u32++;
+#endif
+
     /* Behaviour based on encoder state */
     switch( RGB_encoder->encoder_state )
     {
-        case 0: /* Send the RGB data */
-            encoded_symbols += byte_encoder->encode(byte_encoder, channel,
-                primary_data, data_size, &session_state);
-
-            /* Switch to the reset state when the current encoding completes */
-            if( session_state & RMT_ENCODING_COMPLETE )
-            {
-                RGB_encoder->encoder_state = 1;
-            }
-            /* Yield if there is no more space */
-            if( session_state & RMT_ENCODING_MEM_FULL )
+        case 0: /* Send the RGB data, one pixel at a time */
+            while( RGB_encoder->pixel_index_i32 < num_pixels_i32 )
             {
-                state |= RMT_ENCODING_MEM_FULL;
-                *ret_state = state;
-                return encoded_symbols;
+                /* Gamma, brightness and channel order are applied here */
+                if( RGB_encoder->pixel_loaded_b == FALSE )
+                {
+                    RGB_RMT_load_pixel( RGB_encoder, pixels_S );
+                }
+
+                encoded_symbols += byte_encoder->encode(byte_encoder, channel,
+                    RGB_encoder->pixel_bytes_u8, RGB_LED_PIXEL_BYTES, &session_state);
+
+                /* Repeat the bytes for every LED of the cell, then move to the next pixel */
+                if( ( session_state & RMT_ENCODING_COMPLETE )
+                 && ( ++RGB_encoder->led_repeat_u8 >= rgb_geometry_S.leds_per_cell_u8 ) )
+                {
+                    RGB_encoder->led_repeat_u8 = 0;
+                    RGB_encoder->pixel_index_i32++;
+                    RGB_encoder->pixel_loaded_b = FALSE;
+                }
+                /* Yield if there is no more space */
+                if( session_state & RMT_ENCODING_MEM_FULL )
+                {
+                    state |= RMT_ENCODING_MEM_FULL;
+                    *ret_state = state;
+#if RGB_LED_BENCHMARK == 1
+                    bench_isr_cycles_u32 += esp_cpu_get_cycle_count() - bench_start_u32;
+#endif
+                    return encoded_symbols;
+                }
             }
+
+            /* Switch to the reset state when every pixel is encoded */
+            RGB_encoder->pixel_index_i32 = 0;
+            RGB_encoder->encoder_state = 1;
         /* Fall through... */
         case 1: /* Send the reset code */
             encoded_symbols += copy_encoder->encode(copy_encoder, channel,
@@ -153,11 +476,17 @@ static size_t RGB_RMT_encode(rmt_encoder_t *encoder, rmt_channel_handle_t channe
             {
                 state |= RMT_ENCODING_MEM_FULL;
                 *ret_state = state;
+#if RGB_LED_BENCHMARK == 1
+                bench_isr_cycles_u32 += esp_cpu_get_cycle_count() - bench_start_u32;
+#endif
                 return encoded_symbols;
             }
     }
 
     *ret_state = state;
+#if RGB_LED_BENCHMARK == 1
+    bench_isr_cycles_u32 += esp_cpu_get_cycle_count() - bench_start_u32;
+#endif
     return encoded_symbols;
 }
 
@@ -178,9 +507,45 @@ static esp_err_t RGB_RMT_reset( rmt_encoder_t* encoder )
     rmt_encoder_reset( RGB_encoder->byte_encoder );
     rmt_encoder_reset( RGB_encoder->copy_encoder );
     RGB_encoder->encoder_state = 0;
+    RGB_encoder->pixel_index_i32 = 0;
+    RGB_encoder->led_repeat_u8 = 0;
+    RGB_encoder->pixel_loaded_b = FALSE;
     return ESP_OK;
 }
 
+/*
+ * Local RMT callback, runs in ISR context when a strip completes a transmission.
+ *
+ * Every frame is one transmission per strip, and each channel sends its
+ * transmissions in order, so a frame is done once the slowest strip has
+ * completed it. The RMT interrupt serves all channels, calls never overlap.
+ */
+static IRAM_ATTR bool RGB_RMT_tx_done( rmt_channel_handle_t channel, const rmt_tx_done_event_data_t* event_data, void* user_ctx )
+{
+    RGB_LED_STRIP* strip_S = user_ctx;
+    BaseType_t task_woken = pdFALSE;
+    UINT32 frames_done_u32;
+
+    strip_S->frames_done_u32++;
+
+    frames_done_u32 = strip_S->frames_done_u32;
+    for( INT32 strip = 0; strip < rgb_num_strips_i32; strip++ )
+    {
+        if( (INT32)( rgb_strips_S[ strip ].frames_done_u32 - frames_done_u32 ) < 0 )
+        {
+            frames_done_u32 = rgb_strips_S[ strip ].frames_done_u32;
+        }
+    }
+
+    while( tx_frames_done_u32 != frames_done_u32 )
+    {
+        tx_frames_done_u32++;
+        RGB_LED_FrameDoneFromISR( &task_woken );
+    }
+
+    return ( task_woken == pdTRUE );
+}
+
 /* Local encoder function */
 static esp_err_t RGB_RMT_setup_encoder( RGB_LED_TYPE_PARAMS* params, rmt_encoder_handle_t* ret_encoder )
 {
@@ -232,187 +597,1224 @@ static esp_err_t RGB_RMT_setup_encoder( RGB_LED_TYPE_PARAMS* params, rmt_encoder
     return return_status;
 }
 
-/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
- * SUMMARY:
- *      RGB_LED_Init() - "Initialize the RGB leds"
- *
- * DESCRIPTION:
- *      Initializes the RGB leds
- *
- * INPUTS:
- *      none
- *
- * OUTPUTS:
- *      none
- *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
-STATUS_E RGB_LED_Init()
+/* Local helper, data pin of a strip */
+static INT32 RGB_LED_StripGpio( INT32 strip_i32 )
 {
-    /* Set up the RGBLED params */
-    RGB_LED_params_S = RGB_LED_all_params_S[ RGB_LED_TYPE ];
+    return ( rgb_geometry_S.num_strips_u8 == 0 ) ? RGB_LED_PIN : rgb_geometry_S.strip_gpio_u8[ strip_i32 ];
+}
 
-    /* 1 - Install RMT TX Channel */
-    ESP_LOGI("RGB_LED_Init()", "RMT TX: install");
-    rmt_tx_channel_config_t RGB_channel_config;
-    RGB_channel_config.gpio_num = RGB_LED_PIN;
-    RGB_channel_config.clk_src = RMT_CLK_SRC_DEFAULT;
-    RGB_channel_config.resolution_hz = RGB_LED_HZ;
-    RGB_channel_config.mem_block_symbols = 128;
-    RGB_channel_config.trans_queue_depth = 4;
-    ESP_ERROR_CHECK( rmt_new_tx_channel( &RGB_channel_config, &RGB_channel_handle ) );
+/* Local backend function, one RMT TX channel and encoder per strip */
+static STATUS_E RGB_RMT_init( void )
+{
+    rmt_tx_event_callbacks_t RGB_callbacks = {
+        .on_trans_done = RGB_RMT_tx_done,
+    };
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    rmt_channel_handle_t channels_h[ RGB_LED_MAX_STRIPS ];
+#endif
 
-    /* 2 - Enable RMT TX channel */
-    ESP_LOGI("RGB_LED_Init()", "RMT tx: enable");
-    ESP_ERROR_CHECK( rmt_enable( RGB_channel_handle ) );
+    /* The encoder runs until the frame is out, the store may change under it */
+    rmt_frames_S = calloc( RGB_LED_TX_IN_FLIGHT * rgb_num_pixels_i32, sizeof(RGB_PIXEL) );
+    if( rmt_frames_S == NULL )
+    {
+        ESP_LOGE("RGB_RMT_init()", "No memory for %d frames of %" PRIi32 " pixels", RGB_LED_TX_IN_FLIGHT, rgb_num_pixels_i32);
+        return STATUS_ERR;
+    }
+    rmt_next_frame_i32 = 0;
 
-    /* 3 - Install RGB RMT encoder */
-    ESP_ERROR_CHECK( RGB_RMT_setup_encoder( &RGB_LED_params_S, &RGB_encoder_handle ) );
+    for( INT32 strip = 0; strip < rgb_num_strips_i32; strip++ )
+    {
+        RGB_LED_STRIP* strip_S = &rgb_strips_S[ strip ];
 
-    /* Set the initial colors to off (0, 0, 0) */
-    memset(pixel_tx_buffer_u8, 0, sizeof(pixel_tx_buffer_u8));
-    RGB_LED_TransmitColors();
+        /* 1 - Install RMT TX Channel */
+        ESP_LOGI("RGB_RMT_init()", "RMT TX: install strip %" PRIi32 ", pixels %" PRIi32 " - %" PRIi32, strip,
+            strip_S->first_pixel_i32, strip_S->first_pixel_i32 + strip_S->num_pixels_i32 - 1);
+        rmt_tx_channel_config_t RGB_channel_config = {};
+        RGB_channel_config.gpio_num = RGB_LED_StripGpio( strip );
+        RGB_channel_config.clk_src = RMT_CLK_SRC_DEFAULT;
+        RGB_channel_config.resolution_hz = RGB_LED_HZ;
+        /* A single channel borrows the memory of the others, strips need a block each */
+        RGB_channel_config.mem_block_symbols = ( rgb_num_strips_i32 == 1 ) ? 128 : SOC_RMT_MEM_WORDS_PER_CHANNEL;
+        RGB_channel_config.trans_queue_depth = 4;
+        ESP_ERROR_CHECK( rmt_new_tx_channel( &RGB_channel_config, &strip_S->channel_h ) );
+        ESP_ERROR_CHECK( rmt_tx_register_event_callbacks( strip_S->channel_h, &RGB_callbacks, strip_S ) );
+#if SOC_GPIO_SUPPORT_SLP_SWITCH
+        /* The chain latches the last frame, keep the data pin driven low through light sleep */
+        gpio_sleep_sel_dis( RGB_channel_config.gpio_num );
+#endif
+
+        /* 2 - Enable RMT TX channel */
+        ESP_LOGI("RGB_RMT_init()", "RMT tx: enable");
+        ESP_ERROR_CHECK( rmt_enable( strip_S->channel_h ) );
+
+        /* 3 - Install RGB RMT encoder */
+        ESP_ERROR_CHECK( RGB_RMT_setup_encoder( &RGB_LED_params_S, &strip_S->encoder_h ) );
+
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+        channels_h[ strip ] = strip_S->channel_h;
+#endif
+    }
+    rgb_rmt_enabled_b = TRUE;
+
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    /* 4 - Start the strips on the same clock edge */
+    if( rgb_num_strips_i32 > 1 )
+    {
+        rmt_sync_manager_config_t RGB_sync_config = {
+            .tx_channel_array = channels_h,
+            .array_size = rgb_num_strips_i32,
+        };
+        ESP_ERROR_CHECK( rmt_new_sync_manager( &RGB_sync_config, &RGB_sync_handle ) );
+    }
+#endif
 
     return STATUS_OK;
 }
 
-/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
- * SUMMARY:
- *      RGB_LED_SetPixelColor() - "Set the color of an RGB LED"
- *
- * DESCRIPTION:
- *      Sets a RGB_COLOR_24BIT corresponding to the LED
- *
- * INPUTS:
- *      (INT32) index of the LED
- *      (RGB_COLOR_PCT) RGB color proportions
- *      (UINT8) visible brightness of the color
- *
- * OUTPUTS:
- *      none
- *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
-STATUS_E RGB_LED_SetPixelColor(INT32 index_i32, RGB_COLOR_PCT color_S, UINT8 brightness_u8 )
+/* Local backend function */
+static void RGB_RMT_deinit( void )
 {
-    /* If the passed index is greater than number of LEDs */
-    if( index_i32 >= RGB_LED_COUNT ){
-        ESP_LOGE("RGB_LED_SetPixelColor()", "Index out of bounds");
-        return STATUS_ERR;
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    if( RGB_sync_handle != NULL )
+    {
+        ESP_ERROR_CHECK( rmt_del_sync_manager( RGB_sync_handle ) );
+        RGB_sync_handle = NULL;
     }
+#endif
 
-    RGB_COLOR_24BIT rgb_color;
-    UINT8 r_lut;
-    UINT8 g_lut;
-    UINT8 b_lut;
+    for( INT32 strip = 0; strip < rgb_num_strips_i32; strip++ )
+    {
+        RGB_LED_STRIP* strip_S = &rgb_strips_S[ strip ];
 
-    /* Reduce brightness to max 100% */
-    if( brightness_u8 > 100 )
+        if( rgb_rmt_enabled_b )
+        {
+            ESP_ERROR_CHECK( rmt_disable( strip_S->channel_h ) );
+        }
+        ESP_ERROR_CHECK( rmt_del_channel( strip_S->channel_h ) );
+        ESP_ERROR_CHECK( rmt_del_encoder( strip_S->encoder_h ) );
+        strip_S->channel_h = NULL;
+        strip_S->encoder_h = NULL;
+    }
+    rgb_rmt_enabled_b = FALSE;
+
+    free( rmt_frames_S );
+    rmt_frames_S = NULL;
+}
+
+/* Local backend function, copies the dirty part of every strip into the next frame slot and queues it */
+static INT32 RGB_RMT_transmit( INT32 num_pixels_i32 )
+{
+    RGB_PIXEL* frame_S = &rmt_frames_S[ rmt_next_frame_i32 * rgb_num_pixels_i32 ];
+    INT32 sent_pixels_i32 = 0;
+
+    /* Channels released by RGB_RMT_idle() */
+    if( !rgb_rmt_enabled_b )
     {
-        brightness_u8 = 100;
+        for( INT32 strip = 0; strip < rgb_num_strips_i32; strip++ )
+        {
+            ESP_ERROR_CHECK( rmt_enable( rgb_strips_S[ strip ].channel_h ) );
+        }
+        rgb_rmt_enabled_b = TRUE;
+    }
+
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    /* Nothing else in flight, the strips can be lined up again */
+    if( ( RGB_sync_handle != NULL ) && ( uxSemaphoreGetCount( tx_slots_free_s ) == RGB_LED_TX_IN_FLIGHT - 1 ) )
+    {
+        ESP_ERROR_CHECK( rmt_sync_reset( RGB_sync_handle ) );
     }
+#endif
+
+    /* Set up the transmission configuration */
+    rmt_transmit_config_t tx_config = {
+        .loop_count = 0,
+    };
 
-    /* Get the LUT indices */
-    r_lut = (UINT8)(color_S.r * brightness_u8);
-    g_lut = (UINT8)(color_S.g * brightness_u8);
-    b_lut = (UINT8)(color_S.b * brightness_u8);
+    /* Frame slots are released in order, so the older copy is free again */
+    rmt_frame_brightness_u8[ rmt_next_frame_i32 ] = tx_brightness_u8;
 
-    /* Check for OOB LUT errors */
-    if( r_lut > 100 || g_lut > 100 || b_lut > 100 )
+    /* Send out the values, encoded from the copy in the ISR */
+    for( INT32 strip = 0; strip < rgb_num_strips_i32; strip++ )
     {
-        ESP_LOGE("RGB_LED_SetPixelColor()", "LUT index out of bounds");
+        const RGB_LED_STRIP* strip_S = &rgb_strips_S[ strip ];
+        INT32 tx_pixels_i32 = num_pixels_i32 - strip_S->first_pixel_i32;
+
+        if( tx_pixels_i32 > strip_S->num_pixels_i32 )
+        {
+            tx_pixels_i32 = strip_S->num_pixels_i32;
+        }
+        else if( tx_pixels_i32 < 1 )
+        {
+            tx_pixels_i32 = 1;
+        }
+
+        memcpy( &frame_S[ strip_S->first_pixel_i32 ], &pixel_store_S[ strip_S->first_pixel_i32 ],
+            tx_pixels_i32 * sizeof(RGB_PIXEL) );
+
+        ESP_ERROR_CHECK( rmt_transmit(
+            strip_S->channel_h,
+            strip_S->encoder_h,
+            &frame_S[ strip_S->first_pixel_i32 ],
+            tx_pixels_i32 * sizeof(RGB_PIXEL),
+            &tx_config
+        ) );
+
+        sent_pixels_i32 += tx_pixels_i32;
     }
 
-    /* Get the actual 0-255 RGB values from the LUT */
-    rgb_color.red_U8 = gamma_lut[r_lut];
-    rgb_color.green_U8 = gamma_lut[g_lut];
-    rgb_color.blue_U8 = gamma_lut[b_lut];
+    rmt_next_frame_i32 = ( rmt_next_frame_i32 + 1 ) % RGB_LED_TX_IN_FLIGHT;
 
-    /* Set the color */
-    pixel_colors_pct_S[index_i32] = color_S;
-    pixel_colors_24bit_S[index_i32] = rgb_color;
+    return sent_pixels_i32;
+}
 
-    return STATUS_OK;
+/* Local backend function */
+static void RGB_RMT_wait_done( void )
+{
+    for( INT32 strip = 0; strip < rgb_num_strips_i32; strip++ )
+    {
+        ESP_ERROR_CHECK( rmt_tx_wait_all_done( rgb_strips_S[ strip ].channel_h, -1 ) );
+    }
 }
 
-/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
- * SUMMARY:
- *      RGB_LED_ModifyPixelBrightness() - "Set the brightness of an RGB LED"
- *
- * DESCRIPTION:
- *      Sets a RGB_COLOR_24BIT corresponding to the LED, based on the newly
- *      provided brightness value.
- *
- * INPUTS:
- *      (INT32) index of the LED
- *      (UINT8) visible brightness of the color
- *
- * OUTPUTS:
- *      none
- *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
-STATUS_E RGB_LED_ModifyPixelBrightness(INT32 index_i32, UINT8 brightness_u8)
+/* Local backend function, an enabled channel keeps the chip out of light sleep */
+static void RGB_RMT_idle( void )
 {
-    STATUS_E status = RGB_LED_SetPixelColor(index_i32, pixel_colors_pct_S[index_i32], brightness_u8);
-    return status;
+    if( !rgb_rmt_enabled_b )
+    {
+        return;
+    }
+
+    for( INT32 strip = 0; strip < rgb_num_strips_i32; strip++ )
+    {
+        ESP_ERROR_CHECK( rmt_disable( rgb_strips_S[ strip ].channel_h ) );
+    }
+    rgb_rmt_enabled_b = FALSE;
 }
 
-/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
- * SUMMARY:
- *      RGB_LED_TransmitColors() - "Convert colors to pixel buffer and transmit"
- *
- * DESCRIPTION:
- *      Goes through the array of RGB_COLOR_24BIT variables, sets the pixel buffer,
- *      and then transmits them using the rmt peripheral.
- *
- * INPUTS:
- *      none
+/* Local SPI callback, runs in ISR context when the DMA has sent a frame */
+static IRAM_ATTR void RGB_SPI_tx_done( spi_transaction_t* transaction_S )
+{
+    BaseType_t task_woken = pdFALSE;
+
+#if RGB_LED_BENCHMARK == 1
+    bench_isr_count_u32++;
+#endif
+
+    RGB_LED_FrameDoneFromISR( &task_woken );
+
+    portYIELD_FROM_ISR( task_woken );
+}
+
+/*
+ * Local backend function, WS2812 bits as SPI bytes sent by DMA.
  *
- * OUTPUTS:
- *      none
- *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
-STATUS_E RGB_LED_TransmitColors()
+ * Every LED bit is RGB_SPI_SLOTS SPI bits, high for the first 1 - 3 of
+ * them. The SPI clock is set so RGB_SPI_SLOTS bits take one LED bit period
+ * of the LED type, and the high time of a "0" and a "1" is rounded to whole
+ * SPI bits. Each frame is encoded into a DMA buffer by the CPU, a few table
+ * lookups per pixel, and then sent with one interrupt at the end.
+ */
+static STATUS_E RGB_SPI_init( void )
 {
-    /* Create a pixel buffer and populate it with 8-bit values */
-    for( INT32 pixel = 0; pixel < RGB_LED_COUNT; pixel += 1 )
+    const RGB_LED_TYPE_PARAMS* params = &RGB_LED_params_S;
+    double bit_us = ( params->T0H + params->T0L + params->T1H + params->T1L ) / 2;
+    INT32 clock_hz_i32 = RGB_SPI_SLOTS * 1000000 / bit_us;
+    INT32 high0_i32 = params->T0H / bit_us * RGB_SPI_SLOTS + 0.5;
+    INT32 high1_i32 = params->T1H / bit_us * RGB_SPI_SLOTS + 0.5;
+    INT32 buffer_bytes_i32;
+
+    /* One SPI controller, the SPI backend drives a single chain */
+    if( rgb_num_strips_i32 != 1 )
     {
-        pixel_tx_buffer_u8[ ( pixel * 3 ) + 0 ] = pixel_colors_24bit_S[ pixel ].green_U8;
-        pixel_tx_buffer_u8[ ( pixel * 3 ) + 1 ] = pixel_colors_24bit_S[ pixel ].red_U8;
-        pixel_tx_buffer_u8[ ( pixel * 3 ) + 2 ] = pixel_colors_24bit_S[ pixel ].blue_U8;
+        ESP_LOGE("RGB_SPI_init()", "SPI sends one strip, not %" PRIi32, rgb_num_strips_i32);
+        return STATUS_ERR;
     }
 
-    /* Set up the transmission configuration */
-    rmt_transmit_config_t tx_config = {
-        .loop_count = 0,
+    /* Keep a "0" and a "1" apart, and a low part in both */
+    high0_i32 = ( high0_i32 < 1 ) ? 1 : ( high0_i32 > RGB_SPI_SLOTS - 2 ) ? RGB_SPI_SLOTS - 2 : high0_i32;
+    high1_i32 = ( high1_i32 <= high0_i32 ) ? high0_i32 + 1 : ( high1_i32 > RGB_SPI_SLOTS - 1 ) ? RGB_SPI_SLOTS - 1 : high1_i32;
+
+    for( INT32 value = 0; value < 256; value++ )
+    {
+        UINT32 bits_u32 = 0;
+
+        for( INT32 bit = 7; bit >= 0; bit-- )
+        {
+            INT32 high_i32 = ( value & ( 1 << bit ) ) ? high1_i32 : high0_i32;
+            bits_u32 = ( bits_u32 << RGB_SPI_SLOTS ) | ( ( ( 1u << high_i32 ) - 1 ) << ( RGB_SPI_SLOTS - high_i32 ) );
+        }
+        spi_byte_lut_u32[ value ] = bits_u32;
+    }
+
+    /* Whole chain plus the reset, low for TRS */
+    spi_reset_bytes_i32 = ( params->TRS * clock_hz_i32 / 1000000 + 7 ) / 8 + 1;
+    buffer_bytes_i32 = rgb_num_pixels_i32 * rgb_geometry_S.leds_per_cell_u8 * RGB_LED_PIXEL_BYTES * RGB_SPI_SLOTS + spi_reset_bytes_i32;
+
+    for( INT32 buffer = 0; buffer < RGB_LED_TX_IN_FLIGHT; buffer++ )
+    {
+        spi_buffer_u8[ buffer ] = heap_caps_calloc( 1, buffer_bytes_i32, MALLOC_CAP_DMA );
+        if( spi_buffer_u8[ buffer ] == NULL )
+        {
+            ESP_LOGE("RGB_SPI_init()", "No DMA memory for %" PRIi32 " bytes", buffer_bytes_i32);
+            while( --buffer >= 0 )
+            {
+                heap_caps_free( spi_buffer_u8[ buffer ] );
+                spi_buffer_u8[ buffer ] = NULL;
+            }
+            return STATUS_ERR;
+        }
+    }
+    spi_next_buffer_i32 = 0;
+
+    spi_bus_config_t RGB_bus_config = {
+        .mosi_io_num = RGB_LED_StripGpio( 0 ),
+        .miso_io_num = -1,
+        .sclk_io_num = -1,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = buffer_bytes_i32,
+    };
+    ESP_ERROR_CHECK( spi_bus_initialize( RGB_SPI_HOST, &RGB_bus_config, SPI_DMA_CH_AUTO ) );
+#if SOC_GPIO_SUPPORT_SLP_SWITCH
+    /* The chain latches the last frame, keep the data pin driven low through light sleep */
+    gpio_sleep_sel_dis( RGB_bus_config.mosi_io_num );
+#endif
+
+    spi_device_interface_config_t RGB_device_config = {
+        .clock_speed_hz = clock_hz_i32,
+        .mode = 0,
+        .spics_io_num = -1,
+        .queue_size = RGB_LED_TX_IN_FLIGHT,
+        .post_cb = RGB_SPI_tx_done,
     };
+    ESP_ERROR_CHECK( spi_bus_add_device( RGB_SPI_HOST, &RGB_device_config, &RGB_spi_handle ) );
 
-    /* Send out the values */
-    ESP_ERROR_CHECK( rmt_transmit(
-        RGB_channel_handle,
-        RGB_encoder_handle,
-        pixel_tx_buffer_u8,
-        sizeof(pixel_tx_buffer_u8),
-        &tx_config
-    ) );
+    ESP_LOGI("RGB_SPI_init()", "SPI %" PRIi32 " Hz, %" PRIi32 "/%" PRIi32 " high bits, %" PRIi32 " byte buffers",
+        clock_hz_i32, high0_i32, high1_i32, buffer_bytes_i32);
 
     return STATUS_OK;
 }
 
-/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
- * SUMMARY:
- *      RGB_LED_Wipe() - "Wipe all colors and transmit"
- *
- * DESCRIPTION:
- *      Sets pixel buffer to all zeros and transmits.
- *
- * INPUTS:
- *      none
- *
- * OUTPUTS:
- *      none
- *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
-STATUS_E RGB_LED_Wipe()
+/* Local backend function */
+static void RGB_SPI_deinit( void )
+{
+    spi_transaction_t* transaction_S;
+
+    /* Collect the finished transactions before the device goes */
+    while( spi_device_get_trans_result( RGB_spi_handle, &transaction_S, 0 ) == ESP_OK );
+
+    ESP_ERROR_CHECK( spi_bus_remove_device( RGB_spi_handle ) );
+    ESP_ERROR_CHECK( spi_bus_free( RGB_SPI_HOST ) );
+    RGB_spi_handle = NULL;
+
+    for( INT32 buffer = 0; buffer < RGB_LED_TX_IN_FLIGHT; buffer++ )
+    {
+        heap_caps_free( spi_buffer_u8[ buffer ] );
+        spi_buffer_u8[ buffer ] = NULL;
+    }
+}
+
+/* Local backend function, encodes the dirty prefix into the next DMA buffer and queues it */
+static INT32 RGB_SPI_transmit( INT32 num_pixels_i32 )
+{
+    spi_transaction_t* transaction_S;
+    UINT8* buffer_u8 = spi_buffer_u8[ spi_next_buffer_i32 ];
+    UINT8* out_u8 = buffer_u8;
+    UINT8 bytes_u8[ RGB_LED_MAX_PIXEL_BYTES ];
+
+    /* Finished transactions are only handed back here, never waited for */
+    while( spi_device_get_trans_result( RGB_spi_handle, &transaction_S, 0 ) == ESP_OK );
+
+    /* Frame slots are released in order, so the older buffer is free again */
+    for( INT32 pixel = 0; pixel < num_pixels_i32; pixel++ )
+    {
+        RGB_LED_WireBytes( pixel_store_S[ pixel ], pixel, tx_brightness_u8, bytes_u8 );
+
+        for( INT32 led = 0; led < rgb_geometry_S.leds_per_cell_u8; led++ )
+        {
+            for( INT32 byte = 0; byte < RGB_LED_PIXEL_BYTES; byte++ )
+            {
+                UINT32 bits_u32 = spi_byte_lut_u32[ bytes_u8[ byte ] ];
+
+                out_u8[ 0 ] = bits_u32 >> 24;
+                out_u8[ 1 ] = bits_u32 >> 16;
+                out_u8[ 2 ] = bits_u32 >> 8;
+                out_u8[ 3 ] = bits_u32;
+                out_u8 += RGB_SPI_SLOTS;
+            }
+        }
+    }
+    memset( out_u8, 0, spi_reset_bytes_i32 );
+    out_u8 += spi_reset_bytes_i32;
+
+    transaction_S = &spi_transaction_S[ spi_next_buffer_i32 ];
+    memset( transaction_S, 0, sizeof(spi_transaction_t) );
+    transaction_S->length = ( out_u8 - buffer_u8 ) * 8;
+    transaction_S->tx_buffer = buffer_u8;
+    ESP_ERROR_CHECK( spi_device_queue_trans( RGB_spi_handle, transaction_S, 0 ) );
+
+    spi_next_buffer_i32 = ( spi_next_buffer_i32 + 1 ) % RGB_LED_TX_IN_FLIGHT;
+
+    return num_pixels_i32;
+}
+
+/* Local backend function */
+static void RGB_SPI_wait_done( void )
+{
+    spi_transaction_t* transaction_S;
+
+    /* Every frame slot back means every transaction is out */
+    for( INT32 slot = 0; slot < RGB_LED_TX_IN_FLIGHT; slot++ )
+    {
+        xSemaphoreTake( tx_slots_free_s, portMAX_DELAY );
+    }
+    for( INT32 slot = 0; slot < RGB_LED_TX_IN_FLIGHT; slot++ )
+    {
+        xSemaphoreGive( tx_slots_free_s );
+    }
+
+    while( spi_device_get_trans_result( RGB_spi_handle, &transaction_S, 0 ) == ESP_OK );
+}
+
+/* All backends, selected by RGB_LED_Init(). The SPI driver only holds its power lock while a transaction is queued */
+static const RGB_LED_BACKEND rgb_backends_S[] = {
+    [LED_BACKEND_RMT] = { "RMT", RGB_RMT_init, RGB_RMT_deinit, RGB_RMT_transmit, RGB_RMT_wait_done, RGB_RMT_idle },
+    [LED_BACKEND_SPI] = { "SPI", RGB_SPI_init, RGB_SPI_deinit, RGB_SPI_transmit, RGB_SPI_wait_done, NULL },
+};
+
+/*
+ * Local helper, takes the geometry and sizes the pixel buffers from it.
+ *
+ * The pixel store and the dither errors come from one allocation, the old
+ * one is released. No backend may be running while this runs, the strips
+ * are split again.
+ */
+static STATUS_E RGB_LED_ArenaInit( const RGB_LED_GEOMETRY* geometry_S )
+{
+    INT32 num_pixels_i32;
+    INT32 line_pixels_i32;
+    INT32 num_lines_i32;
+    INT32 num_strips_i32;
+    INT32 first_pixel_i32 = 0;
+    void* arena_p;
+
+    if( ( geometry_S == NULL ) || ( geometry_S->width_u16 == 0 ) || ( geometry_S->height_u16 == 0 )
+     || ( geometry_S->leds_per_cell_u8 == 0 ) || ( geometry_S->map_E > LED_MAP_CUSTOM )
+     || ( ( geometry_S->map_E == LED_MAP_CUSTOM ) && ( geometry_S->custom_map_u16 == NULL ) ) )
+    {
+        ESP_LOGE("RGB_LED_ArenaInit()", "Invalid geometry");
+        return STATUS_ERR;
+    }
+
+    if( geometry_S->num_strips_u8 > RGB_LED_MAX_STRIPS )
+    {
+        ESP_LOGE("RGB_LED_ArenaInit()", "%u strips, the RMT has %d TX channels", geometry_S->num_strips_u8, RGB_LED_MAX_STRIPS);
+        return STATUS_ERR;
+    }
+
+    num_pixels_i32 = geometry_S->width_u16 * geometry_S->height_u16;
+    num_strips_i32 = ( geometry_S->num_strips_u8 == 0 ) ? 1 : geometry_S->num_strips_u8;
+
+    /* Strips get whole lines, a custom map can be cut anywhere */
+    line_pixels_i32 = ( geometry_S->map_E == LED_MAP_CUSTOM ) ? 1
+                    : geometry_S->columns_b ? geometry_S->height_u16 : geometry_S->width_u16;
+    num_lines_i32 = num_pixels_i32 / line_pixels_i32;
+
+    if( num_lines_i32 < num_strips_i32 )
+    {
+        ESP_LOGE("RGB_LED_ArenaInit()", "%" PRIi32 " lines cannot be split into %" PRIi32 " strips",
+            num_lines_i32, num_strips_i32);
+        return STATUS_ERR;
+    }
+
+    /* RGB_PIXEL first keeps the 32-bit words aligned */
+    arena_p = calloc( 1, num_pixels_i32 * ( sizeof(RGB_PIXEL) + sizeof(dither_error_u8[0]) ) );
+    if( arena_p == NULL )
+    {
+        ESP_LOGE("RGB_LED_ArenaInit()", "No memory for %" PRIi32 " pixels", num_pixels_i32);
+        return STATUS_ERR;
+    }
+
+    free( rgb_arena_p );
+    rgb_arena_p = arena_p;
+    pixel_store_S = arena_p;
+    dither_error_u8 = (void*)&pixel_store_S[ num_pixels_i32 ];
+
+    rgb_geometry_S = *geometry_S;
+    rgb_num_pixels_i32 = num_pixels_i32;
+    rgb_num_strips_i32 = num_strips_i32;
+    pixel_dirty_max_i32 = num_pixels_i32 - 1;
+    power_cells_uA_u32 = 0;
+
+    /* Equal runs, the first strips take the lines left over */
+    for( INT32 strip = 0; strip < rgb_num_strips_i32; strip++ )
+    {
+        INT32 strip_lines_i32 = ( num_lines_i32 + rgb_num_strips_i32 - 1 - strip ) / rgb_num_strips_i32;
+
+        rgb_strips_S[ strip ].first_pixel_i32 = first_pixel_i32;
+        rgb_strips_S[ strip ].num_pixels_i32 = strip_lines_i32 * line_pixels_i32;
+        first_pixel_i32 += rgb_strips_S[ strip ].num_pixels_i32;
+    }
+
+    ESP_LOGI("RGB_LED_ArenaInit()", "%ux%u cells, %u LED(s) per cell, %" PRIi32 " LEDs",
+        geometry_S->width_u16, geometry_S->height_u16, geometry_S->leds_per_cell_u8,
+        num_pixels_i32 * geometry_S->leds_per_cell_u8);
+
+    return STATUS_OK;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_Init() - "Initialize the RGB leds"
+ *
+ * DESCRIPTION:
+ *      Initializes the RGB leds for the given grid. The pixel buffers are
+ *      allocated once here, sized from the geometry, so the frame work in
+ *      the rest of the driver is linear in the number of cells.
+ *
+ *      LED_BACKEND_RMT gives each strip its own RMT TX channel and encoder.
+ *      With more than one strip the channels share the RMT memory, and are
+ *      started together by a sync manager where the RMT supports it, so a
+ *      frame takes as long as the longest strip instead of the whole chain.
+ *      The encoder runs in the RMT interrupt, refilling the channel memory
+ *      every few pixels.
+ *
+ *      LED_BACKEND_SPI encodes the frame into a DMA buffer up front and
+ *      streams it out of the SPI MOSI pin, with a single interrupt per frame.
+ *      It drives one strip and needs 12 bytes of DMA memory per LED (16
+ *      for RGBW), twice.
+ *
+ * INPUTS:
+ *      (const RGB_LED_GEOMETRY*) grid size, LEDs per cell and chain layout,
+ *          copied by the driver
+ *      (RGB_LED_BACKEND_E) peripheral that sends the frames
+ *
+ * OUTPUTS:
+ *      STATUS_OK - LEDs ready
+ *      STATUS_ERR - invalid geometry or backend, or out of memory
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+STATUS_E RGB_LED_Init(const RGB_LED_GEOMETRY* geometry_S, RGB_LED_BACKEND_E backend_E)
+{
+    /* Set up the RGBLED params */
+    RGB_LED_params_S = RGB_LED_all_params_S[ RGB_LED_TYPE ];
+
+    /* Current model, in uA per gamma_lut step so the estimate stays integer */
+    power_step_uA_u32[ PIXEL_RED ] = RGB_LED_params_S.mA_R * 1000 / 255 + 0.5;
+    power_step_uA_u32[ PIXEL_GREEN ] = RGB_LED_params_S.mA_G * 1000 / 255 + 0.5;
+    power_step_uA_u32[ PIXEL_BLUE ] = RGB_LED_params_S.mA_B * 1000 / 255 + 0.5;
+    power_step_uA_u32[ PIXEL_WHITE ] = RGB_LED_params_S.mA_W * 1000 / 255 + 0.5;
+    power_idle_uA_u32 = RGB_LED_params_S.mA_Q * 1000 + 0.5;
+
+    if( backend_E >= sizeof(rgb_backends_S) / sizeof(rgb_backends_S[0]) )
+    {
+        ESP_LOGE("RGB_LED_Init()", "Unknown backend %d", backend_E);
+        return STATUS_ERR;
+    }
+
+    /* Pixel buffers and strip runs, before anything can transmit */
+    if( RGB_LED_ArenaInit( geometry_S ) != STATUS_OK )
+    {
+        return STATUS_ERR;
+    }
+
+    /* Limit the transmissions in flight, released again on completion */
+    tx_slots_free_s = xSemaphoreCreateCounting( RGB_LED_TX_IN_FLIGHT, RGB_LED_TX_IN_FLIGHT );
+
+    /* Output hardware */
+    rgb_backend_S = &rgb_backends_S[ backend_E ];
+    ESP_LOGI("RGB_LED_Init()", "%s backend", rgb_backend_S->name_str);
+    if( rgb_backend_S->init() != STATUS_OK )
+    {
+        return STATUS_ERR;
+    }
+
+    /* Set the initial colors to off (0, 0, 0) */
+    pixel_dirty_max_i32 = rgb_num_pixels_i32 - 1;
+    RGB_LED_TransmitColors();
+
+    return STATUS_OK;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_GetCount() - "Get the number of pixels"
+ *
+ * DESCRIPTION:
+ *      Returns the number of addressable pixels (grid cells). With more than
+ *      one LED per cell the chain is longer than this.
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      (INT32) pixels, 0 before RGB_LED_Init()
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+INT32 RGB_LED_GetCount()
+{
+    return rgb_num_pixels_i32;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_GetPixelIndex() - "Get the pixel of a grid cell"
+ *
+ * DESCRIPTION:
+ *      Maps a cell (x = 0 left, y = 0 bottom) to its pixel index, which is
+ *      its position along the chain counted in cells. Lines are rows or
+ *      columns, numbered from the start corner of the chain.
+ *
+ * INPUTS:
+ *      (UINT16) x, column of the cell
+ *      (UINT16) y, row of the cell
+ *
+ * OUTPUTS:
+ *      (INT32) pixel index, -1 if the cell is outside the grid
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+INT32 RGB_LED_GetPixelIndex(UINT16 x_u16, UINT16 y_u16)
+{
+    const RGB_LED_GEOMETRY* geometry_S = &rgb_geometry_S;
+    INT32 across_i32;   /* Distance from the start side, counted in cells */
+    INT32 up_i32;       /* Distance from the start row, counted in cells */
+    INT32 line_i32;
+    INT32 position_i32;
+    INT32 line_len_i32;
+
+    if( ( x_u16 >= geometry_S->width_u16 ) || ( y_u16 >= geometry_S->height_u16 ) )
+    {
+        return -1;
+    }
+
+    if( geometry_S->map_E == LED_MAP_CUSTOM )
+    {
+        return geometry_S->custom_map_u16[ x_u16 * geometry_S->height_u16 + y_u16 ];
+    }
+
+    across_i32 = geometry_S->start_right_b ? ( geometry_S->width_u16 - 1 - x_u16 ) : x_u16;
+    up_i32 = geometry_S->start_top_b ? ( geometry_S->height_u16 - 1 - y_u16 ) : y_u16;
+
+    if( geometry_S->columns_b )
+    {
+        line_i32 = across_i32;
+        position_i32 = up_i32;
+        line_len_i32 = geometry_S->height_u16;
+    }
+    else
+    {
+        line_i32 = up_i32;
+        position_i32 = across_i32;
+        line_len_i32 = geometry_S->width_u16;
+    }
+
+    /* Every other line runs back the way it came */
+    if( ( geometry_S->map_E == LED_MAP_SERPENTINE ) && ( line_i32 & 1 ) )
+    {
+        position_i32 = line_len_i32 - 1 - position_i32;
+    }
+
+    return line_i32 * line_len_i32 + position_i32;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_SetPixelColor() - "Set the color of an RGB LED"
+ *
+ * DESCRIPTION:
+ *      Stores the color and brightness of the LED. The gamma correction and
+ *      global brightness are applied by the encoder during transmission, so
+ *      nothing is converted here.
+ *
+ * INPUTS:
+ *      (INT32) index of the LED
+ *      (RGB_COLOR) RGB color proportions
+ *      (UINT8) visible brightness of the color
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+STATUS_E RGB_LED_SetPixelColor(INT32 index_i32, RGB_COLOR color_S, UINT8 brightness_u8 )
+{
+    /* If the passed index is greater than number of LEDs */
+    if( index_i32 < 0 || index_i32 >= rgb_num_pixels_i32 ){
+        ESP_LOGE("RGB_LED_SetPixelColor()", "Index out of bounds");
+        return STATUS_ERR;
+    }
+
+    RGB_PIXEL pixel;
+
+    /* Reduce brightness to max 100% */
+    if( brightness_u8 > 100 )
+    {
+        brightness_u8 = 100;
+    }
+
+    pixel.channel_u8[ PIXEL_RED ] = color_S.r;
+    pixel.channel_u8[ PIXEL_GREEN ] = color_S.g;
+    pixel.channel_u8[ PIXEL_BLUE ] = color_S.b;
+    pixel.channel_u8[ PIXEL_LEVEL ] = brightness_u8;
+
+    if( pixel_store_S[index_i32].word_u32 != pixel.word_u32 )
+    {
+        /* Move the current estimate from the old color to the new one */
+        power_cells_uA_u32 -= RGB_LED_PixelCurrent( pixel_store_S[index_i32] );
+        power_cells_uA_u32 += RGB_LED_PixelCurrent( pixel );
+
+        /* Track the highest pixel that needs to be sent */
+        if( index_i32 > pixel_dirty_max_i32 )
+        {
+            pixel_dirty_max_i32 = index_i32;
+        }
+
+        /* Set the color */
+        pixel_store_S[index_i32].word_u32 = pixel.word_u32;
+    }
+
+    return STATUS_OK;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_ModifyPixelBrightness() - "Set the brightness of an RGB LED"
+ *
+ * DESCRIPTION:
+ *      Keeps the stored color of the LED and replaces its brightness value.
+ *
+ * INPUTS:
+ *      (INT32) index of the LED
+ *      (UINT8) visible brightness of the color
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+STATUS_E RGB_LED_ModifyPixelBrightness(INT32 index_i32, UINT8 brightness_u8)
+{
+    if( index_i32 < 0 || index_i32 >= rgb_num_pixels_i32 ){
+        ESP_LOGE("RGB_LED_ModifyPixelBrightness()", "Index out of bounds");
+        return STATUS_ERR;
+    }
+
+    RGB_COLOR color_S = {
+        .r = pixel_store_S[index_i32].channel_u8[ PIXEL_RED ],
+        .g = pixel_store_S[index_i32].channel_u8[ PIXEL_GREEN ],
+        .b = pixel_store_S[index_i32].channel_u8[ PIXEL_BLUE ],
+    };
+
+    STATUS_E status = RGB_LED_SetPixelColor(index_i32, color_S, brightness_u8);
+    return status;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_SetGlobalBrightness() - "Set the brightness of every LED"
+ *
+ * DESCRIPTION:
+ *      Scales the brightness of all pixels at transmit time, the stored
+ *      per-pixel state is not touched. Every pixel is marked for sending.
+ *      Frames over the power budget are sent dimmer than this, see
+ *      RGB_LED_SetPowerBudget().
+ *
+ * INPUTS:
+ *      (UINT8) global brightness percentage (0 - 100)
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void RGB_LED_SetGlobalBrightness(UINT8 brightness_u8)
+{
+    if( brightness_u8 > 100 )
+    {
+        brightness_u8 = 100;
+    }
+
+    if( brightness_u8 != global_brightness_u8 )
+    {
+        global_brightness_u8 = brightness_u8;
+        pixel_dirty_max_i32 = rgb_num_pixels_i32 - 1;
+    }
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_SetDither() - "Enable temporal dithering"
+ *
+ * DESCRIPTION:
+ *      When enabled, each channel is encoded from a 16-bit (8.8) gamma
+ *      corrected target instead of gamma_lut, and the fractional part is
+ *      carried per pixel into the next transmission. Averaged over frames,
+ *      dim colors then land between the 8-bit output steps.
+ *
+ *      Dithering only works if RGB_LED_TransmitColors() is called at a
+ *      steady, high rate (100+ fps). Every call then sends the full chain:
+ *      100 LEDs * 24 bits * 1.25us + reset = ~3.05ms on the wire per frame,
+ *      1024 LEDs take ~30.8ms and cannot dither smoothly.
+ *
+ * INPUTS:
+ *      (BOOL) TRUE = dither, FALSE = plain gamma_lut output
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void RGB_LED_SetDither(BOOL enable_b)
+{
+    if( enable_b != dither_enabled_b )
+    {
+        memset(dither_error_u8, 0, rgb_num_pixels_i32 * sizeof(dither_error_u8[0]));
+        dither_enabled_b = enable_b;
+        pixel_dirty_max_i32 = rgb_num_pixels_i32 - 1;
+    }
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_GetDither() - "Check if temporal dithering is enabled"
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      (BOOL) TRUE = dithering
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+BOOL RGB_LED_GetDither()
+{
+    return dither_enabled_b;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_ColorFromPct() - "Convert a floating point color"
+ *
+ * DESCRIPTION:
+ *      Converts a legacy 0.0 - 1.0 RGB_COLOR_PCT to a 0 - 255 RGB_COLOR.
+ *      Uses soft-float math, keep this out of per-frame code.
+ *
+ * INPUTS:
+ *      (RGB_COLOR_PCT) RGB color proportions
+ *
+ * OUTPUTS:
+ *      (RGB_COLOR) equivalent integer color
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+RGB_COLOR RGB_LED_ColorFromPct(RGB_COLOR_PCT color_S)
+{
+    RGB_COLOR color;
+
+    color.r = ( color_S.r <= 0.0 ) ? 0 : ( color_S.r >= 1.0 ) ? 255 : (UINT8)( color_S.r * 255.0 + 0.5 );
+    color.g = ( color_S.g <= 0.0 ) ? 0 : ( color_S.g >= 1.0 ) ? 255 : (UINT8)( color_S.g * 255.0 + 0.5 );
+    color.b = ( color_S.b <= 0.0 ) ? 0 : ( color_S.b >= 1.0 ) ? 255 : (UINT8)( color_S.b * 255.0 + 0.5 );
+
+    return color;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_SetPixelColorPct() - "Set the color of an RGB LED (legacy)"
+ *
+ * DESCRIPTION:
+ *      Compatibility shim for the floating point color API, converts the
+ *      color and calls RGB_LED_SetPixelColor().
+ *
+ * INPUTS:
+ *      (INT32) index of the LED
+ *      (RGB_COLOR_PCT) RGB color proportions
+ *      (UINT8) visible brightness of the color
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+STATUS_E RGB_LED_SetPixelColorPct(INT32 index_i32, RGB_COLOR_PCT color_S, UINT8 brightness_u8)
+{
+    return RGB_LED_SetPixelColor(index_i32, RGB_LED_ColorFromPct(color_S), brightness_u8);
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_TransmitColors() - "Transmit the stored colors"
+ *
+ * DESCRIPTION:
+ *      Transmits the pixel store using the backend chosen at init. The RMT
+ *      backend copies the pixels into a frame slot here and its encoder
+ *      converts them to gamma corrected wire bytes on the fly, the SPI
+ *      backend converts the pixels into its DMA buffer here. Either way the
+ *      store can be changed as soon as the function returns.
+ *
+ *      The LEDs latch in chain order, so only the prefix up to the highest
+ *      changed pixel is sent (followed by the reset code), the rest of the
+ *      chain keeps its previous colors. Nothing is sent if no pixel changed.
+ *      With several strips each one sends its part of that prefix, and at
+ *      least its first pixel so every strip takes part in every frame.
+ *      When no frame is in flight the strips are synchronized again, and
+ *      start together.
+ *
+ *      With a power budget set, the global brightness of the frame is first
+ *      limited so the estimated LED current stays within it, see
+ *      RGB_LED_SetPowerBudget(). A change of that limit resends every pixel.
+ *
+ *      The function only queues the transmission and returns. At most RGB_LED_TX_IN_FLIGHT
+ *      transmissions are queued, a slot is released by the RMT completion
+ *      callback. If no slot is free, the changes stay pending for the next
+ *      call.
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      STATUS_OK - transmission started
+ *      STATUS_NO_CHANGE - no pixel changed, nothing sent
+ *      STATUS_BUSY - too many transmissions in flight, try again later
+ *      STATUS_ERR - no backend (not initialized)
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+STATUS_E RGB_LED_TransmitColors()
+{
+    UINT8 brightness_u8 = RGB_LED_PowerLimit();
+    INT32 dirty_end_i32;
+    INT32 sent_pixels_i32 = 0;
+
+    /* A new power limit changes every lit pixel */
+    if( brightness_u8 != tx_brightness_u8 )
+    {
+        tx_brightness_u8 = brightness_u8;
+        pixel_dirty_max_i32 = rgb_num_pixels_i32 - 1;
+    }
+    dirty_end_i32 = pixel_dirty_max_i32 + 1;
+
+    /* Dithered output changes every frame, always send the whole chain */
+    if( dither_enabled_b )
+    {
+        dirty_end_i32 = rgb_num_pixels_i32;
+    }
+
+    if( rgb_backend_S == NULL )
+    {
+        return STATUS_ERR;
+    }
+
+    if( dirty_end_i32 == 0 )
+    {
+        tx_bytes_saved_u64 += rgb_num_pixels_i32 * RGB_LED_PIXEL_BYTES * rgb_geometry_S.leds_per_cell_u8;
+        return STATUS_NO_CHANGE;
+    }
+
+    /* Claim a transmission slot */
+    if( xSemaphoreTake( tx_slots_free_s, 0 ) != pdTRUE )
+    {
+        return STATUS_BUSY;
+    }
+
+    /* Hand the changed prefix to the backend */
+    sent_pixels_i32 = rgb_backend_S->transmit( dirty_end_i32 );
+
+    /* Record the bytes skipped past the last changed pixel */
+    tx_bytes_saved_u64 += ( rgb_num_pixels_i32 - sent_pixels_i32 ) * RGB_LED_PIXEL_BYTES * rgb_geometry_S.leds_per_cell_u8;
+
+    if( tx_brightness_u8 < global_brightness_u8 )
+    {
+        power_limited_frames_u32++;
+    }
+
+    pixel_dirty_max_i32 = -1;
+
+    return STATUS_OK;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_Idle() - "Release the LED peripheral until the next frame"
+ *
+ * DESCRIPTION:
+ *      Waits for the frames in flight, then lets the backend release its
+ *      peripheral. The LEDs hold the last frame, and the chip can go into
+ *      light sleep. The next RGB_LED_TransmitColors() takes it back.
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void RGB_LED_Idle()
+{
+    if( rgb_backend_S == NULL )
+    {
+        return;
+    }
+
+    rgb_backend_S->wait_done();
+    if( rgb_backend_S->idle != NULL )
+    {
+        rgb_backend_S->idle();
+    }
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_SetTxDoneNotify() - "Notify a task when a frame is sent"
+ *
+ * DESCRIPTION:
+ *      The given task receives a task notification (xTaskNotifyGive style)
+ *      from the completion interrupt every time a frame has been sent and
+ *      its buffer released.
+ *
+ * INPUTS:
+ *      (TaskHandle_t) task to notify, NULL to disable
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void RGB_LED_SetTxDoneNotify(TaskHandle_t task_h)
+{
+    tx_notify_task_h = task_h;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_GetBytesSaved() - "Get the number of pixel bytes not sent"
+ *
+ * DESCRIPTION:
+ *      Returns the total pixel bytes skipped by RGB_LED_TransmitColors(),
+ *      either past the last changed pixel or for unchanged frames.
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      (UINT64) bytes saved since init
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+UINT64 RGB_LED_GetBytesSaved()
+{
+    return tx_bytes_saved_u64;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_SetPowerBudget() - "Limit the current drawn by the LEDs"
+ *
+ * DESCRIPTION:
+ *      The current of each frame is estimated from the gamma corrected
+ *      channel values and the per channel currents of the LED type. The
+ *      estimate is kept up to date as pixels change, so a frame only costs
+ *      one multiply to check. When a frame would draw more than the budget,
+ *      its global brightness is scaled down until it fits. The dark current
+ *      of the LEDs cannot be dimmed, a budget below it turns them all off.
+ *
+ *      100 WS2812B LEDs at full white draw about 6A, a 5W USB supply gives
+ *      1A for the LEDs and the controller together.
+ *
+ * INPUTS:
+ *      (UINT32) budget in mA at the LED supply, 0 = unlimited
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void RGB_LED_SetPowerBudget(UINT32 budget_mA_u32)
+{
+    power_budget_mA_u32 = budget_mA_u32;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_GetCurrentEstimate() - "Get the estimated LED current"
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      (UINT32) estimated current (mA) of the last frame checked, after the
+ *          power limit
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+UINT32 RGB_LED_GetCurrentEstimate()
+{
+    return power_frame_mA_u32;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_GetPowerLimitedFrames() - "Get the number of dimmed frames"
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      (UINT32) frames sent below the global brightness to stay within the
+ *          power budget, since boot
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+UINT32 RGB_LED_GetPowerLimitedFrames()
+{
+    return power_limited_frames_u32;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_Wipe() - "Wipe all colors and transmit"
+ *
+ * DESCRIPTION:
+ *      Sets every stored pixel to zero and transmits.
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+STATUS_E RGB_LED_Wipe()
 {
     STATUS_E status;
     /* Set the colors to off (0, 0, 0) */
-    memset(pixel_colors_24bit_S, 0, sizeof(pixel_colors_24bit_S ) );
-    memset(pixel_tx_buffer_u8, 0, sizeof(pixel_tx_buffer_u8 ) );
+    memset(pixel_store_S, 0, rgb_num_pixels_i32 * sizeof(RGB_PIXEL));
+    power_cells_uA_u32 = 0;
+    pixel_dirty_max_i32 = rgb_num_pixels_i32 - 1;
     status = RGB_LED_TransmitColors();
 
     return status;
-}
\ No newline at end of file
+}
+
+#if RGB_LED_BENCHMARK == 1
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      RGB_LED_Benchmark() - "Measure the cost of filling every pixel"
+ *
+ * DESCRIPTION:
+ *      Fills all pixels through the floating point shim and through the
+ *      integer path, and logs the CPU cycles taken by each. Then converts
+ *      all pixels into wire bytes with and without dithering, which is the
+ *      work the backends add to each frame.
+ *
+ *      Then, with each backend in turn, renders and transmits one full frame
+ *      at 100 (10x10), 256 (16x16) and 1024 (16x16, 4 LEDs per cell) LEDs
+ *      and logs:
+ *          - CPU cycles in the task (render and RGB_LED_TransmitColors())
+ *          - interrupts taken to send the frame, and the CPU cycles spent
+ *            encoding in them (RMT refills, SPI has one completion)
+ *          - the time until the chain has latched, the frame rate ceiling
+ *      The wire alone needs LEDs * 24 bits * 1.25us + reset, ~30.8ms for
+ *      1024, divided by the number of strips when they are sent in parallel.
+ *      The pixel buffers and backends are rebuilt for each run, the face is
+ *      left dark on the backend chosen at init.
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void RGB_LED_Benchmark()
+{
+    const RGB_COLOR_PCT color_pct_S = { .r = 0.0, .g = 1.0, .b = 0.5 };
+    const RGB_COLOR color_S = RGB_LED_default_colors_S[ COLOR_Mint ];
+    UINT32 start_u32;
+    UINT32 cycles_pct_u32;
+    UINT32 cycles_int_u32;
+
+    start_u32 = esp_cpu_get_cycle_count();
+    for( INT32 pixel = 0; pixel < rgb_num_pixels_i32; pixel++ )
+    {
+        RGB_LED_SetPixelColorPct( pixel, color_pct_S, 100 - ( pixel % 100 ) );
+    }
+    cycles_pct_u32 = esp_cpu_get_cycle_count() - start_u32;
+
+    start_u32 = esp_cpu_get_cycle_count();
+    for( INT32 pixel = 0; pixel < rgb_num_pixels_i32; pixel++ )
+    {
+        RGB_LED_SetPixelColor( pixel, color_S, 100 - ( pixel % 100 ) );
+    }
+    cycles_int_u32 = esp_cpu_get_cycle_count() - start_u32;
+
+    ESP_LOGI("RGB_LED_Benchmark()", "Fill %" PRIi32 " pixels: double %" PRIu32 " cycles, integer %" PRIu32 " cycles",
+        rgb_num_pixels_i32, cycles_pct_u32, cycles_int_u32);
+
+    /* Wire byte conversion, plain and dithered */
+    UINT32 cycles_load_u32[ 2 ];
+    UINT8 bytes_u8[ RGB_LED_MAX_PIXEL_BYTES ];
+
+    for( INT32 dither = 0; dither < 2; dither++ )
+    {
+        RGB_LED_SetDither( dither );
+        start_u32 = esp_cpu_get_cycle_count();
+        for( INT32 pixel = 0; pixel < rgb_num_pixels_i32; pixel++ )
+        {
+            RGB_LED_WireBytes( pixel_store_S[ pixel ], pixel, tx_brightness_u8, bytes_u8 );
+        }
+        cycles_load_u32[ dither ] = esp_cpu_get_cycle_count() - start_u32;
+    }
+    RGB_LED_SetDither( FALSE );
+
+    ESP_LOGI("RGB_LED_Benchmark()", "Encode %" PRIi32 " pixels: gamma_lut %" PRIu32 " cycles, dithered %" PRIu32 " cycles",
+        rgb_num_pixels_i32, cycles_load_u32[ 0 ], cycles_load_u32[ 1 ]);
+
+    memset(pixel_store_S, 0, rgb_num_pixels_i32 * sizeof(RGB_PIXEL));
+    power_cells_uA_u32 = 0;
+    pixel_dirty_max_i32 = rgb_num_pixels_i32 - 1;
+
+    /* Frame rate ceiling of larger faces, render every cell then send the full chain */
+    static const RGB_LED_GEOMETRY bench_geometry_S[] = {
+        { .width_u16 = 10, .height_u16 = 10, .leds_per_cell_u8 = 1, .map_E = LED_MAP_SERPENTINE },
+        { .width_u16 = 16, .height_u16 = 16, .leds_per_cell_u8 = 1, .map_E = LED_MAP_SERPENTINE },
+        { .width_u16 = 16, .height_u16 = 16, .leds_per_cell_u8 = 4, .map_E = LED_MAP_SERPENTINE },
+    };
+    const RGB_LED_BACKEND* saved_backend_S = rgb_backend_S;
+    RGB_LED_GEOMETRY saved_geometry_S = rgb_geometry_S;
+
+    /* The buffers are replaced, nothing may still be reading them */
+    rgb_backend_S->wait_done();
+    rgb_backend_S->deinit();
+
+    for( INT32 backend = 0; backend < sizeof(rgb_backends_S) / sizeof(rgb_backends_S[0]); backend++ )
+    {
+        for( INT32 bench = 0; bench < sizeof(bench_geometry_S) / sizeof(bench_geometry_S[0]); bench++ )
+        {
+            RGB_LED_GEOMETRY geometry_S = bench_geometry_S[ bench ];
+            UINT32 cycles_task_u32;
+            UINT32 isr_count_u32;
+            UINT32 isr_cycles_u32;
+            INT64 start_us_i64;
+            INT64 frame_us_i64;
+
+            /* Same strips and pins as the real face */
+            geometry_S.num_strips_u8 = saved_geometry_S.num_strips_u8;
+            memcpy( geometry_S.strip_gpio_u8, saved_geometry_S.strip_gpio_u8, sizeof(geometry_S.strip_gpio_u8) );
+
+            rgb_backend_S = &rgb_backends_S[ backend ];
+            if( ( RGB_LED_ArenaInit( &geometry_S ) != STATUS_OK ) || ( rgb_backend_S->init() != STATUS_OK ) )
+            {
+                ESP_LOGW("RGB_LED_Benchmark()", "%s: %" PRIi32 " LEDs skipped", rgb_backend_S->name_str,
+                    rgb_num_pixels_i32 * geometry_S.leds_per_cell_u8);
+                continue;
+            }
+
+            start_us_i64 = esp_timer_get_time();
+            bench_isr_count_u32 = 0;
+            bench_isr_cycles_u32 = 0;
+            start_u32 = esp_cpu_get_cycle_count();
+            for( UINT16 y = 0; y < geometry_S.height_u16; y++ )
+            {
+                for( UINT16 x = 0; x < geometry_S.width_u16; x++ )
+                {
+                    RGB_LED_SetPixelColor( RGB_LED_GetPixelIndex( x, y ), color_S, 1 + ( ( x + y ) % 100 ) );
+                }
+            }
+            RGB_LED_TransmitColors();
+            cycles_task_u32 = esp_cpu_get_cycle_count() - start_u32;
+            rgb_backend_S->wait_done();
+            frame_us_i64 = esp_timer_get_time() - start_us_i64;
+            isr_count_u32 = bench_isr_count_u32;
+            isr_cycles_u32 = bench_isr_cycles_u32;
+
+            ESP_LOGI("RGB_LED_Benchmark()", "%s %" PRIi32 " LEDs: task %" PRIu32 " cycles, %" PRIu32 " interrupts %" PRIu32
+                " cycles, frame %" PRIi64 " us, max %" PRIi64 " fps", rgb_backend_S->name_str,
+                rgb_num_pixels_i32 * geometry_S.leds_per_cell_u8, cycles_task_u32, isr_count_u32, isr_cycles_u32,
+                frame_us_i64, ( frame_us_i64 > 0 ) ? ( 1000000 / frame_us_i64 ) : 0);
+
+            rgb_backend_S->deinit();
+        }
+    }
+
+    /* Back to the real face, dark */
+    rgb_backend_S = saved_backend_S;
+    if( ( RGB_LED_ArenaInit( &saved_geometry_S ) != STATUS_OK ) || ( rgb_backend_S->init() != STATUS_OK ) )
+    {
+        /* Nothing to send with, RGB_LED_TransmitColors() fails until RGB_LED_Init() */
+        ESP_LOGE("RGB_LED_Benchmark()", "Could not restore the %s backend", rgb_backend_S->name_str);
+        rgb_backend_S = NULL;
+        return;
+    }
+    RGB_LED_TransmitColors();
+    rgb_backend_S->wait_done();
+}
+#endif
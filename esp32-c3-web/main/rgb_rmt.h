@@ -4,11 +4,12 @@
  *
  * PURPOSE:
  *      This module is designed to provide simple functions to control RGB leds
- *      using the RMT peripheral of the ESP32.
+ *      using the RMT peripheral of the ESP32, or the SPI peripheral with DMA.
  *
  * DEPENDENCIES:
  *      ESP32 GPIO
  *      ESP32 RMT
+ *      ESP32 SPI (GDMA)
  *
  *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*
  * (C) Andrew Bright 2023, github.com/e5h
@@ -16,6 +17,12 @@
 
 #ifndef WC_RGB_RMT_H
 
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*][ Feature Switches ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+
+#define RGB_LED_BENCHMARK       (0) /* 1 = build RGB_LED_Benchmark(), 0 = unused */
+
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ Include Files ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
@@ -25,20 +32,35 @@
 #include "driver/gpio.h"
 #include "driver/rmt_encoder.h"
 #include "driver/rmt_tx.h"
+#include "soc/soc_caps.h"
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ GLOBAL : Constants and Types ][~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 
 #define RGB_LED_HZ          (10000000)  /* 10Mhz = 0.1us ticks */
+#define RGB_LED_TX_IN_FLIGHT (2)        /* Transmissions queued at once */
+#define RGB_LED_MAX_STRIPS  (SOC_RMT_TX_CANDIDATES_PER_GROUP)  /* LED chains driven in parallel, one RMT TX channel each */
+#define RGB_LED_MAX_PIXEL_BYTES (4)     /* Largest pixel on the wire (RGBW) */
 
 /**
  * Struct to hold a brightness adjustable color
  * 
- * Each double value is 0.0 - 1.0, representing 0 - 100% of that
- * color. This is used to multiply the result of a 0 - 255 valued
- * gamma corrected lookup table. Lookup table indices are the
- * brightness (0 - 100).
+ * Each channel is 0 - 255, representing 0 - 100% of that color. The
+ * channel is scaled by the brightness (0 - 100) with integer math to
+ * get the index into a 0 - 255 valued gamma corrected lookup table.
+ */
+typedef struct {
+    UINT8 r;
+    UINT8 g;
+    UINT8 b;
+} RGB_COLOR;
+
+/**
+ * Legacy brightness adjustable color (0.0 - 1.0 per channel)
+ * 
+ * Only kept for RGB_LED_SetPixelColorPct(), the ESP32-C3 has no FPU
+ * so these should not be used in the LED path.
  */
 typedef struct {
     double r;
@@ -56,18 +78,77 @@ typedef enum{
     LED_WS2813_V3,
     LED_SK6812_V1,
     LED_PI554FCH,
+    LED_SK6812_RGBW_V1,
+    LED_WS2811_V1,
 } RGB_LED_TYPE_E;
 
+/**
+ * Order of the channels on the wire
+ *
+ * LED_ORDER_GRBW drives a separate white LED, the white part of the color
+ * (the smallest of red, green and blue) is moved to it.
+ */
+typedef enum{
+    LED_ORDER_GRB = 0,
+    LED_ORDER_RGB,
+    LED_ORDER_GRBW,
+} RGB_LED_ORDER_E;
+
 /* Struct to defined RGB LED parameters */
 typedef struct{
     INT32               pixel_sz_bytes; /* Size of a pixel in bytes (usually 3 or 4) */
+    RGB_LED_ORDER_E     order_E;        /* Channel order of the pixel bytes */
     double              T0H;            /* Time (us) spent high for an encoded "0 bit" */
     double              T1H;            /* Time (us) spent high for an encoded "1 bit" */
     double              T0L;            /* Time (us) spent low for an encoded "0 bit" */
     double              T1L;            /* Time (us) spent low for an encoded "1 bit" */
     double              TRS;            /* Time (us) spent low to reset */
+    double              mA_R;           /* Current (mA) of the red channel at full scale */
+    double              mA_G;           /* Current (mA) of the green channel at full scale */
+    double              mA_B;           /* Current (mA) of the blue channel at full scale */
+    double              mA_W;           /* Current (mA) of the white channel at full scale (RGBW) */
+    double              mA_Q;           /* Current (mA) of a dark LED */
 } RGB_LED_TYPE_PARAMS;
 
+/* Peripheral that sends the frames, see RGB_LED_Init() */
+typedef enum{
+    LED_BACKEND_RMT = 0,        /* RMT channel per strip, encoded in the refill interrupt */
+    LED_BACKEND_SPI,            /* SPI MOSI fed by DMA, encoded before sending, one strip */
+} RGB_LED_BACKEND_E;
+
+/* Order of the pixels along the LED chain */
+typedef enum{
+    LED_MAP_PROGRESSIVE = 0,    /* Every line starts on the same side */
+    LED_MAP_SERPENTINE,         /* Lines alternate direction (zigzag) */
+    LED_MAP_CUSTOM,             /* Pixel of each cell listed in custom_map_u16 */
+} RGB_LED_MAP_E;
+
+/**
+ * Geometry of the LED grid
+ *
+ * A pixel is one cell of the grid. All LEDs of a cell show the pixel color
+ * and follow each other on the chain, so a face with 2 LEDs behind every
+ * letter is 2 * width * height LEDs long. Cells are addressed with x = 0 on
+ * the left and y = 0 on the bottom row.
+ *
+ * The chain can be cut into up to RGB_LED_MAX_STRIPS strips sent in
+ * parallel. The pixels are split into equal runs of whole lines (rows or
+ * columns), strip 0 takes the first run, and each strip is wired from the
+ * start of its run exactly as the single chain would be.
+ */
+typedef struct{
+    UINT16              width_u16;          /* Cells per row */
+    UINT16              height_u16;         /* Rows */
+    UINT8               leds_per_cell_u8;   /* LEDs behind each cell (1 or more) */
+    RGB_LED_MAP_E       map_E;
+    BOOL                columns_b;          /* Chain runs along columns instead of rows */
+    BOOL                start_right_b;      /* Chain starts on the right side */
+    BOOL                start_top_b;        /* Chain starts on the top row */
+    const UINT16*       custom_map_u16;     /* LED_MAP_CUSTOM only, pixel of cell [x * height + y] */
+    UINT8               num_strips_u8;      /* Strips, 0 = one chain on WC_RGB_LED_PIN */
+    UINT8               strip_gpio_u8[ RGB_LED_MAX_STRIPS ];    /* Data pin of each strip */
+} RGB_LED_GEOMETRY;
+
 typedef enum{
     COLOR_Red = 0,
     COLOR_Orange,
@@ -87,7 +168,7 @@ typedef enum{
 } RGB_LED_DEFAULT_COLOR_E;
 
 /* Array to access */
-extern const RGB_COLOR_PCT RGB_LED_default_colors_S[];
+extern const RGB_COLOR RGB_LED_default_colors_S[];
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ LOCAL : Constants and Types ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
@@ -102,11 +183,30 @@ extern const RGB_COLOR_PCT RGB_LED_default_colors_S[];
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 
 /* Core functions */
-extern STATUS_E RGB_LED_Init();
-extern STATUS_E RGB_LED_SetPixelColor(INT32 index, RGB_COLOR_PCT color, UINT8 brightness);
+extern STATUS_E RGB_LED_Init(const RGB_LED_GEOMETRY* geometry_S, RGB_LED_BACKEND_E backend_E);
+extern INT32    RGB_LED_GetCount();
+extern INT32    RGB_LED_GetPixelIndex(UINT16 x_u16, UINT16 y_u16);
+extern STATUS_E RGB_LED_SetPixelColor(INT32 index, RGB_COLOR color, UINT8 brightness);
 extern STATUS_E RGB_LED_ModifyPixelBrightness(INT32 index, UINT8 brightness);
+extern void     RGB_LED_SetGlobalBrightness(UINT8 brightness);
 extern STATUS_E RGB_LED_TransmitColors();
+extern void     RGB_LED_Idle();
 extern STATUS_E RGB_LED_Wipe();
+extern UINT64   RGB_LED_GetBytesSaved();
+extern void     RGB_LED_SetTxDoneNotify(TaskHandle_t task_h);
+extern void     RGB_LED_SetDither(BOOL enable_b);
+extern BOOL     RGB_LED_GetDither();
+extern void     RGB_LED_SetPowerBudget(UINT32 budget_mA_u32);
+extern UINT32   RGB_LED_GetCurrentEstimate();
+extern UINT32   RGB_LED_GetPowerLimitedFrames();
+
+/* Compatibility with the floating point color API */
+extern RGB_COLOR RGB_LED_ColorFromPct(RGB_COLOR_PCT color);
+extern STATUS_E RGB_LED_SetPixelColorPct(INT32 index, RGB_COLOR_PCT color, UINT8 brightness);
+
+#if RGB_LED_BENCHMARK == 1
+extern void RGB_LED_Benchmark();
+#endif
 
 #define WC_RGB_RMT_H
 #endif
\ No newline at end of file
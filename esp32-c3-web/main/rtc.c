@@ -28,6 +28,8 @@
 #include "rtc.h"
 #include "driver/i2c_master.h"
 #include "driver/i2c_slave.h"
+#include "driver/gpio.h"
+#include "esp_sleep.h"
 
 /*=============================================================================*/
 /*][ LOCAL : Constants and Types ][============================================*/
@@ -35,17 +37,44 @@
 
 #define LOG_TAG "rtc.c"     // Tag for optional ESP_LOGx calls
 
+#define RTC_READ_RES_US     (10000)     // Resolution of a time read (100th seconds register)
+#define RTC_EDGE_WAIT_US    (2 * RTC_READ_RES_US) // Longest wait for the 100th seconds to count
+#define RTC_SYNC_TOL_US     (1000)      // Largest correction that still lengthens the resync interval
+#define RTC_DRIFT_BASE_US   (600000000LL) // Shortest span the drift is measured over (10 min, 17 ppm at 10 ms)
+#define RTC_DAYS_TO_2000    (10957)     // Days from 1970-01-01 to 2000-01-01
+
 typedef struct{
     INT32 i2c_port_e;
     UINT8 address_u8;
 } RTC_T;
 
+typedef struct{
+    INT32 int_gpio_i32;             // GPIO wired to ~INTA, -1 = events not enabled
+    UINT8 events_u8;                // RTC_EVENT_E bits enabled on ~INTA
+    EventGroupHandle_t flags_h;     // Event group woken by an event
+    EventBits_t flag_bits;
+} RTC_EVENTS_T;
+
+typedef struct{
+    INT64 base_us_i64;              // TIMER_GetTimeUs() at the last resync
+    INT64 base_rtc_us_i64;          // RTC time at the last resync, us since 2000-01-01 00:00:00
+    INT64 anchor_us_i64;            // TIMER_GetTimeUs() at the read the drift is measured from
+    INT64 anchor_rtc_us_i64;        // RTC time at that read (middle of its window)
+    INT32 drift_ppb_i32;            // Rate of the RTC against the timer, parts per billion
+    UINT8 wday_offset_u8;           // Weekday register minus the weekday of the date
+} RTC_CLOCK_T;
+
 /*=============================================================================*/
 /*][ LOCAL : Variables ][======================================================*/
 /*=============================================================================*/
 
 volatile bool rtc_initialized_b = FALSE;
 static RTC_T rtc_s;
+static RTC_EVENTS_T rtc_events_s = { .int_gpio_i32 = -1 };
+
+static RTC_CLOCK_T rtc_clock_s[2];      // Double buffer, readers copy rtc_clock_s[rtc_clock_seq_u32 & 1]
+static UINT32 rtc_clock_seq_u32 = 0;    // Bumped after each update, 0 = time never read
+static RTC_SYNC_STATS rtc_sync_stats_s = { .sync_interval_s_u32 = RTC_SYNC_MIN_S };
 
 static i2c_master_bus_handle_t i2c_bus_handle_s;
 static i2c_master_dev_handle_t i2c_rtc_handle_s;
@@ -196,7 +225,7 @@ static STATUS_E reg_set(UINT8 reg_addr_u8, UINT8 mask_u8, UINT8 bits_u8)
     }
 
     // Keep the irrelevant bits, only write the masked bits to the value
-    reg_write_command_u8[1] = reg_read_value_u8[0] & ((0xFF & ~mask_u8) | bits_u8);
+    reg_write_command_u8[1] = (reg_read_value_u8[0] & ~mask_u8) | (bits_u8 & mask_u8);
 
     // Write the new register value
     status_e &= i2c_write(reg_write_command_u8, sizeof(reg_write_command_u8));
@@ -204,12 +233,470 @@ static STATUS_E reg_set(UINT8 reg_addr_u8, UINT8 mask_u8, UINT8 bits_u8)
     return status_e;
 }
 
+/**===< local >================================================================
+ * NAME:
+ *      flags_clear() - read and clear the event flags on the RTC
+ *
+ * SUMMARY:
+ *      Reads the flags register, and clears the periodic and alarm 1 flags
+ *      that are set. ~INTA is held low (level mode) until they are cleared.
+ *
+ * INPUT REQUIREMENTS:
+ *      - p_events_u8 must not be null
+ *
+ * OUTPUT GUARANTEES:
+ *      - p_events_u8 holds the RTC_EVENT_E bits that were set
+ *      - flags set after the read are not cleared
+ *      - status of the operation will be returned (0 = fail, 1 = success)
+ **===< local >================================================================*/
+static STATUS_E flags_clear(UINT8* p_events_u8)
+{
+    STATUS_E status_e = STATUS_OK;
+
+    UINT8 flags_u8[1] = {0};
+    UINT8 clear_command_u8[2] = {CTRL_REG_ADDR_FLAGS, 0xFF};
+
+    *p_events_u8 = RTC_EVENT_NONE;
+
+    if(i2c_read(CTRL_REG_ADDR_FLAGS, flags_u8, 1) < STATUS_OK)
+    {
+        return STATUS_ERR;
+    }
+
+    // Writing 0 clears a flag and 1 leaves it, so only the flags read above are cleared
+    if(flags_u8[0] & CTRL_REG_FLAGS_M_PIF)
+    {
+        *p_events_u8 |= RTC_EVENT_MINUTE;
+        clear_command_u8[1] &= ~CTRL_REG_FLAGS_M_PIF;
+    }
+
+    if(flags_u8[0] & CTRL_REG_FLAGS_M_A1F)
+    {
+        *p_events_u8 |= RTC_EVENT_ALARM;
+        clear_command_u8[1] &= ~CTRL_REG_FLAGS_M_A1F;
+    }
+
+    if(clear_command_u8[1] != 0xFF)
+    {
+        status_e = i2c_write(clear_command_u8, sizeof(clear_command_u8));
+    }
+
+    return status_e;
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      int_isr() - ~INTA went low
+ *
+ * SUMMARY:
+ *      The flags can only be cleared over I2C, which is not possible from an
+ *      interrupt. The pin interrupt is masked until RTC_clear_events() has
+ *      cleared them, and the event group is woken.
+ *
+ * INPUT REQUIREMENTS:
+ *      ---
+ *
+ * OUTPUT GUARANTEES:
+ *      - runs in ISR context, from the GPIO ISR service
+ **===< local >================================================================*/
+static void int_isr(void* arg)
+{
+    BaseType_t task_woken = pdFALSE;
+
+    gpio_intr_disable(rtc_events_s.int_gpio_i32);
+    xEventGroupSetBitsFromISR(rtc_events_s.flags_h, rtc_events_s.flag_bits, &task_woken);
+
+    if(task_woken == pdTRUE)
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      date_to_days() - days since 2000-01-01 of a date
+ *
+ * SUMMARY:
+ *      Counts the years from March, so the leap day is the last day of the
+ *      year (days_from_civil).
+ *
+ * INPUT REQUIREMENTS:
+ *      year 0-99 (2000-2099), month 1-12, day 1-31
+ *
+ * OUTPUT GUARANTEES:
+ *      Returns the day number, 2000-01-01 = 0
+ **===< local >================================================================*/
+static INT32 date_to_days(INT32 year_i32, INT32 month_i32, INT32 day_i32)
+{
+    INT32 march_year_i32 = 2000 + year_i32 - (month_i32 <= 2);
+    INT32 era_i32 = march_year_i32 / 400;
+    INT32 year_of_era_i32 = march_year_i32 - era_i32 * 400;
+    INT32 day_of_year_i32 = (153 * (month_i32 + (month_i32 > 2 ? -3 : 9)) + 2) / 5 + day_i32 - 1;
+    INT32 day_of_era_i32 = year_of_era_i32 * 365 + year_of_era_i32 / 4 - year_of_era_i32 / 100 + day_of_year_i32;
+
+    return era_i32 * 146097 + day_of_era_i32 - 719468 - RTC_DAYS_TO_2000;
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      days_to_date() - date of a day number since 2000-01-01
+ *
+ * SUMMARY:
+ *      Reverse of date_to_days() (civil_from_days).
+ *
+ * INPUT REQUIREMENTS:
+ *      days must be >= 0
+ *
+ * OUTPUT GUARANTEES:
+ *      year 0-99 (wraps after 2099 like the RTC), month 1-12, day 1-31
+ **===< local >================================================================*/
+static void days_to_date(INT32 days_i32, INT32* p_year_i32, INT32* p_month_i32, INT32* p_day_i32)
+{
+    INT32 shifted_i32 = days_i32 + RTC_DAYS_TO_2000 + 719468;
+    INT32 era_i32 = shifted_i32 / 146097;
+    INT32 day_of_era_i32 = shifted_i32 - era_i32 * 146097;
+    INT32 year_of_era_i32 = (day_of_era_i32 - day_of_era_i32 / 1460 + day_of_era_i32 / 36524 - day_of_era_i32 / 146096) / 365;
+    INT32 day_of_year_i32 = day_of_era_i32 - (365 * year_of_era_i32 + year_of_era_i32 / 4 - year_of_era_i32 / 100);
+    INT32 march_month_i32 = (5 * day_of_year_i32 + 2) / 153;
+
+    *p_day_i32 = day_of_year_i32 - (153 * march_month_i32 + 2) / 5 + 1;
+    *p_month_i32 = march_month_i32 < 10 ? march_month_i32 + 3 : march_month_i32 - 9;
+    *p_year_i32 = (year_of_era_i32 + era_i32 * 400 + (*p_month_i32 <= 2) - 2000) % 100;
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      time_to_us() - RTC time in us since 2000-01-01 00:00:00
+ *
+ * SUMMARY:
+ *      Also gives the offset of the weekday register from the weekday of
+ *      the date, the register is free running (any 0-6 start).
+ *
+ * INPUT REQUIREMENTS:
+ *      p_timestamp_s in the register ranges (see RTC_get_time())
+ *
+ * OUTPUT GUARANTEES:
+ *      Returns the time in microseconds
+ **===< local >================================================================*/
+static INT64 time_to_us(const struct tm* p_timestamp_s, UINT8* p_wday_offset_u8)
+{
+    INT32 days_i32 = date_to_days(p_timestamp_s->tm_year, p_timestamp_s->tm_mon, p_timestamp_s->tm_mday);
+    INT64 seconds_i64 = (INT64)days_i32 * 86400
+                      + p_timestamp_s->tm_hour * 3600 + p_timestamp_s->tm_min * 60 + p_timestamp_s->tm_sec;
+
+    // 2000-01-01 was a saturday (6)
+    *p_wday_offset_u8 = (UINT8)((p_timestamp_s->tm_wday + 7 - (days_i32 + 6) % 7) % 7);
+
+    return seconds_i64 * 1000000;
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      us_to_time() - reverse of time_to_us()
+ *
+ * SUMMARY:
+ *      ---
+ *
+ * INPUT REQUIREMENTS:
+ *      rtc_us_i64 must be >= 0
+ *
+ * OUTPUT GUARANTEES:
+ *      p_timestamp_s holds the time in the register ranges
+ **===< local >================================================================*/
+static void us_to_time(INT64 rtc_us_i64, UINT8 wday_offset_u8, struct tm* p_timestamp_s)
+{
+    INT64 seconds_i64 = rtc_us_i64 / 1000000;
+    INT32 days_i32 = (INT32)(seconds_i64 / 86400);
+    INT32 second_of_day_i32 = (INT32)(seconds_i64 % 86400);
+    INT32 year_i32, month_i32, day_i32;
+
+    days_to_date(days_i32, &year_i32, &month_i32, &day_i32);
+
+    p_timestamp_s->tm_sec = second_of_day_i32 % 60;
+    p_timestamp_s->tm_min = (second_of_day_i32 / 60) % 60;
+    p_timestamp_s->tm_hour = second_of_day_i32 / 3600;
+    p_timestamp_s->tm_mday = day_i32;
+    p_timestamp_s->tm_wday = ((days_i32 + 6) % 7 + wday_offset_u8) % 7;
+    p_timestamp_s->tm_mon = month_i32;
+    p_timestamp_s->tm_year = year_i32;
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      time_read() - read the time registers of the RTC
+ *
+ * SUMMARY:
+ *      One 8-byte I2C burst from the 100th seconds register, the RTC
+ *      latches all of them at the start of the transfer. Only the time
+ *      service (RTC_sync()) reads the registers, RTC_get_time() is served
+ *      from the cached time.
+ *
+ * INPUT REQUIREMENTS:
+ *      - p_timestamp_s and p_subsecond_us_u32 must not be null
+ *      - 100th seconds mode enabled (RTC_init())
+ *
+ * OUTPUT GUARANTEES:
+ *      - p_timestamp_s holds the register values (see RTC_get_time())
+ *      - p_subsecond_us_u32 holds the 100th seconds in microseconds
+ *      - status of the operation will be returned (0 = fail, 1 = success)
+ **===< local >================================================================*/
+static STATUS_E time_read(struct tm* p_timestamp_s, UINT32* p_subsecond_us_u32)
+{
+    STATUS_E status_e = STATUS_OK;
+
+    UINT8 buffer_u8[8];
+    UINT8 time_values_u8[8];
+    memset(buffer_u8, 0, sizeof(buffer_u8));
+    memset(time_values_u8, 0, sizeof(time_values_u8));
+
+    // Sequential RTC read
+    if(i2c_read(RTC_REG_ADDR_100TH_SECONDS, buffer_u8, sizeof(buffer_u8)) < STATUS_OK)
+    {
+        return STATUS_ERR;
+    }
+
+    // buffer_u8[0] : 100th seconds
+    buffer_u8[0] &= RTC_REG_100TH_SECONDS_M;
+    status_e  &= bcd_to_dec(&buffer_u8[0], &time_values_u8[0]);
+    *p_subsecond_us_u32 = time_values_u8[0] * RTC_READ_RES_US;
+
+    // buffer_u8[1] : seconds
+    buffer_u8[1] &= RTC_REG_SECONDS_M_SEC;
+    status_e  &= bcd_to_dec(&buffer_u8[1], &time_values_u8[1]);
+    p_timestamp_s->tm_sec = time_values_u8[1];
+
+    // buffer_u8[2] : minutes
+    buffer_u8[2] &= RTC_REG_MINUTES_M_MIN;
+    status_e  &= bcd_to_dec(&buffer_u8[2], &time_values_u8[2]);
+    p_timestamp_s->tm_min = time_values_u8[2];
+
+    // buffer_u8[3] : hours
+    buffer_u8[3] &= RTC_REG_HOURS_M_HRS24;
+    status_e  &= bcd_to_dec(&buffer_u8[3], &time_values_u8[3]);
+    p_timestamp_s->tm_hour = time_values_u8[3];
+
+    // buffer_u8[4] : days
+    buffer_u8[4] &= RTC_REG_DAYS_M;
+    status_e  &= bcd_to_dec(&buffer_u8[4], &time_values_u8[4]);
+    p_timestamp_s->tm_mday = time_values_u8[4];
+
+    // buffer_u8[5] : weekdays
+    buffer_u8[5] &= RTC_REG_WEEKDAYS_M;
+    status_e  &= bcd_to_dec(&buffer_u8[5], &time_values_u8[5]);
+    p_timestamp_s->tm_wday = time_values_u8[5];
+
+    // buffer_u8[6] : months
+    buffer_u8[6] &= RTC_REG_MONTHS_M;
+    status_e  &= bcd_to_dec(&buffer_u8[6], &time_values_u8[6]);
+    p_timestamp_s->tm_mon = time_values_u8[6];
+
+    // buffer_u8[7] : years
+    buffer_u8[7] &= RTC_REG_YEARS_M;
+    status_e  &= bcd_to_dec(&buffer_u8[7], &time_values_u8[7]);
+    p_timestamp_s->tm_year = time_values_u8[7];
+
+    // A cleared RTC reads day 0 and month 0, which is not a date
+    if(p_timestamp_s->tm_mday < 1 || p_timestamp_s->tm_mon < 1 || p_timestamp_s->tm_mon > 12)
+    {
+        status_e = STATUS_ERR;
+    }
+
+    ESP_LOGD("time_read", "Read RTC time registers (dec). [yr: %u] [mo: %u] [wd: %u, d: %u] [h: %u, m: %u, s: %u.%02u]",
+             time_values_u8[7],
+             time_values_u8[6],
+             time_values_u8[5],
+             time_values_u8[4],
+             time_values_u8[3],
+             time_values_u8[2],
+             time_values_u8[1],
+             time_values_u8[0]
+    );
+
+    // Any failed conversion will have set this to 0 (STATUS_ERR) if an error occurred.
+    return status_e;
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      clock_publish() - replace the cached time
+ *
+ * SUMMARY:
+ *      Writes the buffer readers are not using, then makes it current. Only
+ *      one task may update the clock (the task calling RTC_sync()).
+ *
+ * INPUT REQUIREMENTS:
+ *      ---
+ *
+ * OUTPUT GUARANTEES:
+ *      - readers see either the old or the new clock, never a mix
+ **===< local >================================================================*/
+static void clock_publish(const RTC_CLOCK_T* p_clock_s)
+{
+    UINT32 seq_u32 = rtc_clock_seq_u32 + 1;
+
+    rtc_clock_s[seq_u32 & 1] = *p_clock_s;
+    __atomic_store_n(&rtc_clock_seq_u32, seq_u32, __ATOMIC_RELEASE);
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      clock_snapshot() - copy the cached time without a lock
+ *
+ * SUMMARY:
+ *      Copies the current buffer and checks it was not reused meanwhile,
+ *      which takes two updates during the copy. A reader never waits on the
+ *      writer, so a higher priority task cannot be stuck behind it.
+ *
+ * INPUT REQUIREMENTS:
+ *      ---
+ *
+ * OUTPUT GUARANTEES:
+ *      - returns FALSE if the time was never read
+ **===< local >================================================================*/
+static BOOL clock_snapshot(RTC_CLOCK_T* p_clock_s)
+{
+    UINT32 seq_u32;
+
+    do
+    {
+        seq_u32 = __atomic_load_n(&rtc_clock_seq_u32, __ATOMIC_ACQUIRE);
+        *p_clock_s = rtc_clock_s[seq_u32 & 1];
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while(seq_u32 != __atomic_load_n(&rtc_clock_seq_u32, __ATOMIC_RELAXED));
+
+    return (seq_u32 != 0) ? TRUE : FALSE;
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      clock_now_us() - RTC time of a timer value from the cached clock
+ *
+ * SUMMARY:
+ *      ---
+ *
+ * INPUT REQUIREMENTS:
+ *      ---
+ *
+ * OUTPUT GUARANTEES:
+ *      Returns us since 2000-01-01 00:00:00
+ **===< local >================================================================*/
+static INT64 clock_now_us(const RTC_CLOCK_T* p_clock_s, INT64 now_us_i64)
+{
+    INT64 elapsed_us_i64 = now_us_i64 - p_clock_s->base_us_i64;
+
+    return p_clock_s->base_rtc_us_i64 + elapsed_us_i64 + elapsed_us_i64 * p_clock_s->drift_ppb_i32 / 1000000000;
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      clock_step() - restart the cached time
+ *
+ * SUMMARY:
+ *      The drift estimate is kept, it belongs to the crystals, and is
+ *      measured again from this time.
+ *
+ * INPUT REQUIREMENTS:
+ *      rtc_us_i64 is the RTC time at now_us_i64, for a read that is the
+ *      middle of the window it gave
+ *
+ * OUTPUT GUARANTEES:
+ *      ---
+ **===< local >================================================================*/
+static void clock_step(INT64 now_us_i64, INT64 rtc_us_i64, UINT8 wday_offset_u8)
+{
+    RTC_CLOCK_T clock_s = {0};
+
+    clock_snapshot(&clock_s);
+    clock_s.base_us_i64 = now_us_i64;
+    clock_s.base_rtc_us_i64 = rtc_us_i64;
+    clock_s.anchor_us_i64 = clock_s.base_us_i64;
+    clock_s.anchor_rtc_us_i64 = clock_s.base_rtc_us_i64;
+    clock_s.wday_offset_u8 = wday_offset_u8;
+    clock_publish(&clock_s);
+
+    rtc_sync_stats_s.sync_interval_s_u32 = RTC_SYNC_MIN_S;
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      clock_read() - read the RTC against the timer
+ *
+ * SUMMARY:
+ *      A read only places the RTC somewhere in a 100th second. The 100th
+ *      seconds are then read again until they count, the edge is between
+ *      the start of the last read that did not see it and the end of the
+ *      one that did, a window of two short transfers. Without the edge
+ *      (preempted, or not counting) the window is the 100th second read.
+ *
+ * INPUT REQUIREMENTS:
+ *      ---
+ *
+ * OUTPUT GUARANTEES:
+ *      - the RTC time at timer value p_now_us_i64 is in [p_rtc_us_i64,
+ *        p_rtc_us_i64 + p_window_us_i32), us since 2000-01-01 00:00:00
+ *      - status of the operation will be returned (0 = fail, 1 = success)
+ **===< local >================================================================*/
+static STATUS_E clock_read(INT64* p_now_us_i64, INT64* p_rtc_us_i64, INT32* p_window_us_i32, UINT8* p_wday_offset_u8)
+{
+    struct tm rtc_time_s;
+    UINT32 subsecond_us_u32;
+
+    INT64 start_us_i64 = (INT64)TIMER_GetTimeUs();
+    STATUS_E status_e = time_read(&rtc_time_s, &subsecond_us_u32);
+    INT64 end_us_i64 = (INT64)TIMER_GetTimeUs();
+
+    if(status_e < STATUS_OK)
+    {
+        return status_e;
+    }
+
+    *p_rtc_us_i64 = time_to_us(&rtc_time_s, p_wday_offset_u8) + subsecond_us_u32;
+    *p_now_us_i64 = end_us_i64;
+    *p_window_us_i32 = RTC_READ_RES_US + (INT32)(end_us_i64 - start_us_i64);
+
+    UINT8 hundredths_u8 = (UINT8)(subsecond_us_u32 / RTC_READ_RES_US);
+    INT64 wait_end_us_i64 = end_us_i64 + RTC_EDGE_WAIT_US;
+
+    while(end_us_i64 < wait_end_us_i64)
+    {
+        UINT8 read_u8[1];
+        UINT8 read_dec_u8[1];
+        INT64 read_start_us_i64 = (INT64)TIMER_GetTimeUs();
+
+        if(i2c_read(RTC_REG_ADDR_100TH_SECONDS, read_u8, 1) < STATUS_OK
+        || bcd_to_dec(read_u8, read_dec_u8) < STATUS_OK)
+        {
+            break;
+        }
+
+        INT64 read_end_us_i64 = (INT64)TIMER_GetTimeUs();
+
+        if(read_dec_u8[0] != hundredths_u8)
+        {
+            // One count later is the edge, more and a read was missed
+            if(read_dec_u8[0] == (hundredths_u8 + 1) % 100)
+            {
+                *p_rtc_us_i64 += RTC_READ_RES_US;
+                *p_now_us_i64 = read_end_us_i64;
+                *p_window_us_i32 = (INT32)(read_end_us_i64 - start_us_i64);
+            }
+            break;
+        }
+
+        start_us_i64 = read_start_us_i64;
+        end_us_i64 = read_end_us_i64;
+    }
+
+    return STATUS_OK;
+}
+
 /**===< global >===============================================================
  * NAME:
  *      RTC_init() - Initialize the real time clock
  *
  * SUMMARY:
- *      Sets the RTC address and the i2c port number
+ *      Sets the RTC address and the i2c port number, and reads the time
+ *      once for RTC_get_time()
  *
  * INPUT REQUIREMENTS:
  *      Must be a valid address
@@ -249,99 +736,223 @@ STATUS_E RTC_init(UINT8 rtc_addr_u8)
     // - 24 hour mode (default)
     // - 12.5pF, 32.768kHz crystal
     status_e &= reg_set(CTRL_REG_ADDR_OSCILLATOR, CTRL_REG_OSC_M_CL, OSC_CL_12_5_PF);
+    // - 100th seconds counted, the time service locks to the second edge with it
+    status_e &= reg_set(CTRL_REG_ADDR_FUNCTION, CTRL_REG_FUNC_M_1OOTH, CTRL_REG_FUNC_M_1OOTH);
 
     rtc_initialized_b = TRUE;
 
+    // First read of the time service
+    UINT32 next_sync_ms_u32;
+    status_e &= RTC_sync(&next_sync_ms_u32);
+
     return status_e;
 }
 
 /**===< global >===============================================================
  * NAME:
- *      RTC_get_time() - Get the current time from the RTC
+ *      RTC_get_time() - Get the current time
  *
  * SUMMARY:
+ *      Interpolates from the last RTC read with the CPU timer, corrected by
+ *      the drift estimate. No bus traffic and no lock, any task can call it
+ *      as often as needed. The RTC is only read by RTC_sync().
+ *
+ *      The fields hold the RTC register values, tm_year is 0-99 (2000 -
+ *      2099), tm_mon is 1-12 and tm_wday is the weekday register.
  *
  * INPUT REQUIREMENTS:
+ *      Not from an interrupt
  *
  * OUTPUT GUARANTEES:
+ *      Will return a status enum (0 = fail, the time was never read)
  **===< global >===============================================================*/
 STATUS_E RTC_get_time(struct tm* p_timestamp_s)
 {
-    if(rtc_initialized_b != TRUE)
+    RTC_CLOCK_T clock_s;
+
+    if(clock_snapshot(&clock_s) != TRUE)
     {
         return STATUS_ERR;
     }
 
-    STATUS_E status_e = STATUS_OK;
+    us_to_time(clock_now_us(&clock_s, (INT64)TIMER_GetTimeUs()), clock_s.wday_offset_u8, p_timestamp_s);
 
-    UINT8 buffer_u8[7];
-    UINT8 time_values_u8[7];
-    memset(buffer_u8, 0, sizeof(buffer_u8));
-    memset(time_values_u8, 0, sizeof(time_values_u8));
+    return STATUS_OK;
+}
 
-    // Sequential RTC read
-    if(i2c_read(RTC_REG_ADDR_SECONDS, buffer_u8, sizeof(buffer_u8)) < STATUS_OK)
+/**===< global >===============================================================
+ * NAME:
+ *      RTC_get_next_edge() - Get the timer value of the next RTC edge
+ *
+ * SUMMARY:
+ *      Gives the TIMER_GetTimeUs() value at which the cached time reaches
+ *      the next multiple of period_s_u32 seconds (1 = next second, 60 =
+ *      next minute). A task woken at that time sees the new second or
+ *      minute in RTC_get_time(), within the window of the last resync.
+ *
+ * INPUT REQUIREMENTS:
+ *      period_s_u32 divides a day (1, 60, ...)
+ *
+ * OUTPUT GUARANTEES:
+ *      p_edge_us_u64 holds the timer value, rounded up
+ *      Will return a status enum (0 = fail, the time was never read)
+ **===< global >===============================================================*/
+STATUS_E RTC_get_next_edge(UINT32 period_s_u32, UINT64* p_edge_us_u64)
+{
+    RTC_CLOCK_T clock_s;
+
+    if(clock_snapshot(&clock_s) != TRUE || period_s_u32 == 0)
     {
         return STATUS_ERR;
     }
 
-    ESP_LOGI("RTC_get_time", "Read RTC time registers (bcd). [yr: %02x] [mo: %02x] [wd: %02x, d: %02x] [h: %02x, m: %02x, s: %02x]",
-             buffer_u8[6],
-             buffer_u8[5],
-             buffer_u8[4],
-             buffer_u8[3],
-             buffer_u8[2],
-             buffer_u8[1],
-             buffer_u8[0]
-    );
+    INT64 now_us_i64 = (INT64)TIMER_GetTimeUs();
+    INT64 period_us_i64 = (INT64)period_s_u32 * 1000000;
+    INT64 rtc_to_edge_us_i64 = period_us_i64 - clock_now_us(&clock_s, now_us_i64) % period_us_i64;
 
-    // buffer_u8[0] : seconds
-    buffer_u8[0] &= RTC_REG_SECONDS_M_SEC;
-    status_e  &= bcd_to_dec(&buffer_u8[0], &time_values_u8[0]);
-    p_timestamp_s->tm_sec = time_values_u8[0];
+    // The RTC runs drift_ppb fast against the timer, 1 us more against rounding down
+    INT64 to_edge_us_i64 = rtc_to_edge_us_i64 + 1
+                         - rtc_to_edge_us_i64 * clock_s.drift_ppb_i32 / (1000000000 + clock_s.drift_ppb_i32);
 
-    // buffer_u8[1] : minutes
-    buffer_u8[1] &= RTC_REG_MINUTES_M_MIN;
-    status_e  &= bcd_to_dec(&buffer_u8[1], &time_values_u8[1]);
-    p_timestamp_s->tm_min = time_values_u8[1];
+    *p_edge_us_u64 = (UINT64)(now_us_i64 + to_edge_us_i64);
 
-    // buffer_u8[2] : hours
-    buffer_u8[2] &= RTC_REG_HOURS_M_HRS24;
-    status_e  &= bcd_to_dec(&buffer_u8[2], &time_values_u8[2]);
-    p_timestamp_s->tm_hour = time_values_u8[2];
+    return STATUS_OK;
+}
 
-    // buffer_u8[3] : days
-    buffer_u8[3] &= RTC_REG_DAYS_M;
-    status_e  &= bcd_to_dec(&buffer_u8[3], &time_values_u8[3]);
-    p_timestamp_s->tm_mday = time_values_u8[3];
+/**===< global >===============================================================
+ * NAME:
+ *      RTC_sync() - Discipline the cached time to the RTC
+ *
+ * SUMMARY:
+ *      Reads the RTC on a 100th second edge (see clock_read()), which puts
+ *      the RTC time in a window of a few hundred us. When the cached time
+ *      is inside that window it is kept, else it is moved to the nearest
+ *      edge of the window. A correction up to RTC_SYNC_TOL_US makes the
+ *      next resync twice as far (up to RTC_SYNC_MAX_S), a larger one halves
+ *      it. A jump larger than any drift (RTC set elsewhere) restarts the
+ *      cached time.
+ *
+ *      The drift is the RTC time against the timer since the anchor read.
+ *      Both reads are off by half their window, 5 ms without the edge, so
+ *      the estimate gets better the longer the RTC is kept.
+ *
+ * INPUT REQUIREMENTS:
+ *      Called from one task only, the one updating the clock
+ *
+ * OUTPUT GUARANTEES:
+ *      p_next_sync_ms_u32 holds the time to the next resync
+ *      Will return a status enum (0 = fail, 1 = success)
+ **===< global >===============================================================*/
+STATUS_E RTC_sync(UINT32* p_next_sync_ms_u32)
+{
+    *p_next_sync_ms_u32 = RTC_SYNC_MIN_S * 1000;
 
-    // buffer_u8[4] : weekdays
-    buffer_u8[4] &= RTC_REG_WEEKDAYS_M;
-    status_e  &= bcd_to_dec(&buffer_u8[4], &time_values_u8[4]);
-    p_timestamp_s->tm_wday = time_values_u8[4];
+    if(rtc_initialized_b != TRUE)
+    {
+        return STATUS_ERR;
+    }
 
-    // buffer_u8[5] : months
-    buffer_u8[5] &= RTC_REG_MONTHS_M;
-    status_e  &= bcd_to_dec(&buffer_u8[5], &time_values_u8[5]);
-    p_timestamp_s->tm_mon = time_values_u8[5];
+    RTC_CLOCK_T clock_s;
+    INT64 now_us_i64;
+    INT64 rtc_us_i64;
+    INT32 window_us_i32;
+    UINT8 wday_offset_u8;
 
-    // buffer_u8[6] : years
-    buffer_u8[6] &= RTC_REG_YEARS_M;
-    status_e  &= bcd_to_dec(&buffer_u8[6], &time_values_u8[6]);
-    p_timestamp_s->tm_year = time_values_u8[6];
+    STATUS_E status_e = clock_read(&now_us_i64, &rtc_us_i64, &window_us_i32, &wday_offset_u8);
 
-    ESP_LOGI("RTC_get_time", "Read RTC time registers (dec). [yr: %u] [mo: %u] [wd: %u, d: %u] [h: %u, m: %u, s: %u]",
-             time_values_u8[6],
-             time_values_u8[5],
-             time_values_u8[4],
-             time_values_u8[3],
-             time_values_u8[2],
-             time_values_u8[1],
-             time_values_u8[0]
-    );
+    if(status_e < STATUS_OK)
+    {
+        return status_e;
+    }
 
-    // Any failed conversion will have set this to 0 (STATUS_ERR) if an error occurred.
-    return status_e;
+    rtc_sync_stats_s.resyncs_u32++;
+
+    if(clock_snapshot(&clock_s) != TRUE)
+    {
+        clock_step(now_us_i64, rtc_us_i64 + window_us_i32 / 2, wday_offset_u8);
+        return STATUS_OK;
+    }
+
+    INT64 elapsed_us_i64 = now_us_i64 - clock_s.base_us_i64;
+    INT64 predicted_us_i64 = clock_now_us(&clock_s, now_us_i64);
+    INT64 bound_us_i64 = elapsed_us_i64 * RTC_DRIFT_MAX_PPB / 1000000000 + RTC_READ_RES_US;
+    INT64 error_us_i64 = 0;
+
+    if(predicted_us_i64 < rtc_us_i64)
+    {
+        error_us_i64 = rtc_us_i64 - predicted_us_i64;
+    }
+    else if(predicted_us_i64 >= rtc_us_i64 + window_us_i32)
+    {
+        error_us_i64 = rtc_us_i64 + window_us_i32 - 1 - predicted_us_i64;
+    }
+
+    if(error_us_i64 > bound_us_i64 || error_us_i64 < -bound_us_i64 || wday_offset_u8 != clock_s.wday_offset_u8)
+    {
+        ESP_LOGW("RTC_sync", "RTC moved by %lld ms, time restarted", (long long)(error_us_i64 / 1000));
+        rtc_sync_stats_s.steps_u32++;
+        rtc_sync_stats_s.last_error_us_i32 = 0;
+        clock_step(now_us_i64, rtc_us_i64 + window_us_i32 / 2, wday_offset_u8);
+        *p_next_sync_ms_u32 = rtc_sync_stats_s.sync_interval_s_u32 * 1000;
+        return STATUS_OK;
+    }
+
+    if(error_us_i64 > RTC_SYNC_TOL_US || error_us_i64 < -RTC_SYNC_TOL_US)
+    {
+        if(rtc_sync_stats_s.sync_interval_s_u32 > RTC_SYNC_MIN_S)
+        {
+            rtc_sync_stats_s.sync_interval_s_u32 /= 2;
+        }
+    }
+    else if(rtc_sync_stats_s.sync_interval_s_u32 < RTC_SYNC_MAX_S)
+    {
+        rtc_sync_stats_s.sync_interval_s_u32 *= 2;
+    }
+
+    clock_s.base_us_i64 = now_us_i64;
+    clock_s.base_rtc_us_i64 = predicted_us_i64 + error_us_i64;
+
+    // Too short a span and the windows of the reads swamp the drift
+    INT64 span_us_i64 = now_us_i64 - clock_s.anchor_us_i64;
+    if(span_us_i64 >= RTC_DRIFT_BASE_US)
+    {
+        INT64 rtc_span_us_i64 = rtc_us_i64 + window_us_i32 / 2 - clock_s.anchor_rtc_us_i64;
+        INT64 drift_ppb_i64 = (rtc_span_us_i64 - span_us_i64) * 1000 / (span_us_i64 / 1000000);
+
+        drift_ppb_i64 = (drift_ppb_i64 > RTC_DRIFT_MAX_PPB) ? RTC_DRIFT_MAX_PPB : drift_ppb_i64;
+        drift_ppb_i64 = (drift_ppb_i64 < -RTC_DRIFT_MAX_PPB) ? -RTC_DRIFT_MAX_PPB : drift_ppb_i64;
+        clock_s.drift_ppb_i32 = (INT32)drift_ppb_i64;
+    }
+
+    clock_publish(&clock_s);
+
+    rtc_sync_stats_s.last_error_us_i32 = (INT32)error_us_i64;
+    *p_next_sync_ms_u32 = rtc_sync_stats_s.sync_interval_s_u32 * 1000;
+
+    return STATUS_OK;
+}
+
+/**===< global >===============================================================
+ * NAME:
+ *      RTC_get_sync_stats() - Get the metrics of the time service
+ *
+ * SUMMARY:
+ *      ---
+ *
+ * INPUT REQUIREMENTS:
+ *      ---
+ *
+ * OUTPUT GUARANTEES:
+ *      p_stats_s holds a copy of the metrics
+ **===< global >===============================================================*/
+void RTC_get_sync_stats(RTC_SYNC_STATS* p_stats_s)
+{
+    RTC_CLOCK_T clock_s = {0};
+
+    clock_snapshot(&clock_s);
+
+    *p_stats_s = rtc_sync_stats_s;
+    p_stats_s->drift_ppb_i32 = clock_s.drift_ppb_i32;
 }
 
 /**===< global >===============================================================
@@ -349,8 +960,12 @@ STATUS_E RTC_get_time(struct tm* p_timestamp_s)
  *      RTC_set_time() - Set the timestamp on the RTC
  *
  * SUMMARY:
+ *      The RTC is stopped and its prescaler cleared while the time is
+ *      written, so the written time starts on a second edge. The cached
+ *      time is restarted from a read right after.
  *
  * INPUT REQUIREMENTS:
+ *      Called from the task calling RTC_sync()
  *
  * OUTPUT GUARANTEES:
  **===< global >===============================================================*/
@@ -363,32 +978,34 @@ STATUS_E RTC_set_time(struct tm* p_timestamp_s)
 
     STATUS_E status_e = STATUS_OK;
 
-    UINT8 buffer_u8[8];
+    UINT8 buffer_u8[9];
     UINT8 time_values_u8[7];
     memset(buffer_u8, 0, sizeof(buffer_u8));
     memset(time_values_u8, 0, sizeof(time_values_u8));
 
     // buffer_u8[0] : register address
 
-    // buffer_u8[1] : seconds
+    // buffer_u8[1] : 100th seconds (0)
+
+    // buffer_u8[2] : seconds
     time_values_u8[0] = (UINT8)p_timestamp_s->tm_sec;
 
-    // buffer_u8[2] : minutes
+    // buffer_u8[3] : minutes
     time_values_u8[1] = (UINT8)p_timestamp_s->tm_min;
 
-    // buffer_u8[3] : hours
+    // buffer_u8[4] : hours
     time_values_u8[2] = (UINT8)p_timestamp_s->tm_hour;
 
-    // buffer_u8[4] : days
+    // buffer_u8[5] : days
     time_values_u8[3] = (UINT8)p_timestamp_s->tm_mday;
 
-    // buffer_u8[5] : weekdays
+    // buffer_u8[6] : weekdays
     time_values_u8[4] = (UINT8)p_timestamp_s->tm_wday;
 
-    // buffer_u8[6] : months
+    // buffer_u8[7] : months
     time_values_u8[5] = (UINT8)p_timestamp_s->tm_mon;
 
-    // buffer_u8[7] : years
+    // buffer_u8[8] : years
     time_values_u8[6] = (UINT8)p_timestamp_s->tm_year;
 
     ESP_LOGI("RTC_set_time", "Setting RTC time registers (dec). [yr: %u] [mo: %u] [wd: %u, d: %u] [h: %u, m: %u, s: %u]",
@@ -401,29 +1018,228 @@ STATUS_E RTC_set_time(struct tm* p_timestamp_s)
              time_values_u8[0]
              );
 
-    // Copy everything to the actual write buffer. Offset by 1 due to inclusion of register address.
-    buffer_u8[0] = RTC_REG_ADDR_SECONDS;
-    for(INT32 i = 1; i < sizeof(buffer_u8); i++)
+    // Copy everything to the actual write buffer. Offset by 2 due to inclusion of register address and 100th seconds.
+    buffer_u8[0] = RTC_REG_ADDR_100TH_SECONDS;
+    for(INT32 i = 2; i < sizeof(buffer_u8); i++)
     {
-        status_e &= dec_to_bcd(&time_values_u8[i - 1], &buffer_u8[i]);
+        status_e &= dec_to_bcd(&time_values_u8[i - 2], &buffer_u8[i]);
     }
 
     if(status_e >= STATUS_OK)
     {
-        status_e = i2c_write(buffer_u8, sizeof(buffer_u8));
+        UINT8 reset_u8[2] = { CTRL_REG_ADDR_RESETS, CTRL_REG_RESET_BASE | REG_RESET_BIT_CPR };
+        UINT8 run_u8[2] = { CTRL_REG_ADDR_STOP_ENABLE, 0x00 };
+
+        status_e &= reg_set(CTRL_REG_ADDR_STOP_ENABLE, CTRL_REG_STOP_ENABLE_M_STOP, CTRL_REG_STOP_ENABLE_M_STOP);
+        status_e &= i2c_write(reset_u8, sizeof(reset_u8));
+        status_e &= i2c_write(buffer_u8, sizeof(buffer_u8));
+        status_e &= i2c_write(run_u8, sizeof(run_u8)); // Also after a failure, the RTC must not stay stopped
+    }
+
+    // The cached time follows the new time, no need to wait for a resync
+    if(status_e >= STATUS_OK)
+    {
+        INT64 now_us_i64;
+        INT64 rtc_us_i64;
+        INT32 window_us_i32;
+        UINT8 wday_offset_u8;
+
+        status_e = clock_read(&now_us_i64, &rtc_us_i64, &window_us_i32, &wday_offset_u8);
+        if(status_e >= STATUS_OK)
+        {
+            clock_step(now_us_i64, rtc_us_i64 + window_us_i32 / 2, wday_offset_u8);
+        }
     }
 
     ESP_LOGI("RTC_set_time", "Setting RTC time registers (bcd). [yr: %02x] [mo: %02x] [wd: %02x, d: %02x] [h: %02x, m: %02x, s: %02x]",
+             buffer_u8[8],
              buffer_u8[7],
              buffer_u8[6],
              buffer_u8[5],
              buffer_u8[4],
              buffer_u8[3],
-             buffer_u8[2],
-             buffer_u8[1]
+             buffer_u8[2]
     );
 
     return status_e;
 }
 
+/**===< global >===============================================================
+ * NAME:
+ *      RTC_enable_events() - Wake a task from the RTC interrupt
+ *
+ * SUMMARY:
+ *      Sets ~INTA up as an interrupt output that stays low until the flags
+ *      are cleared, for a minute rollover and/or alarm 1. The GPIO wired to
+ *      ~INTA sets flag_bits in the event group, and wakes the chip from
+ *      light sleep. The woken task must call RTC_clear_events().
+ *
+ *      With RTC_EVENT_MINUTE, nothing has to poll the RTC between minutes.
+ *
+ * INPUT REQUIREMENTS:
+ *      RTC_init() must have been called
+ *      int_gpio_i32 must be a valid GPIO (~INTA is open drain, the internal
+ *      pullup is enabled)
+ *
+ * OUTPUT GUARANTEES:
+ *      Stale flags are cleared
+ *      Will return a status enum (0 = fail, 1 = success)
+ **===< global >===============================================================*/
+STATUS_E RTC_enable_events(INT32 int_gpio_i32, UINT8 events_u8, EventGroupHandle_t flags_h, EventBits_t flag_bits)
+{
+    if(rtc_initialized_b != TRUE)
+    {
+        return STATUS_ERR;
+    }
+
+    if(int_gpio_i32 < 0 || flags_h == NULL)
+    {
+        return STATUS_ERR_PARAM;
+    }
+
+    STATUS_E status_e = STATUS_OK;
+
+    UINT8 events_cleared_u8 = RTC_EVENT_NONE;
+    UINT8 inta_command_u8[2] = {CTRL_REG_ADDR_INTA_ENABLE, CTRL_REG_INTA_ENABLE_M_ILPA};
+
+    if(events_u8 & RTC_EVENT_MINUTE)
+    {
+        inta_command_u8[1] |= CTRL_REG_INTA_ENABLE_M_PIEA;
+    }
+
+    if(events_u8 & RTC_EVENT_ALARM)
+    {
+        inta_command_u8[1] |= CTRL_REG_INTA_ENABLE_M_A1IEA;
+    }
+
+    rtc_events_s.int_gpio_i32 = int_gpio_i32;
+    rtc_events_s.events_u8 = events_u8;
+    rtc_events_s.flags_h = flags_h;
+    rtc_events_s.flag_bits = flag_bits;
+
+    // ~INTA as interrupt output (level), one periodic interrupt per minute
+    status_e &= reg_set(CTRL_REG_ADDR_PIN_IO, CTRL_REG_PIN_IO_M_INTAPM, PIN_IO_INTAPM_N_INTA_OUT);
+    status_e &= reg_set(CTRL_REG_ADDR_FUNCTION, CTRL_REG_FUNC_M_PI,
+                        (events_u8 & RTC_EVENT_MINUTE) ? FUNC_PI_MINUTE : FUNC_PI_NONE);
+    status_e &= i2c_write(inta_command_u8, sizeof(inta_command_u8));
+
+    // Active low, a level interrupt is also the only kind that wakes from light sleep
+    gpio_config_t int_config_s = {
+        .pin_bit_mask = 1ULL << int_gpio_i32,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    ESP_ERROR_CHECK(gpio_config(&int_config_s));
+
+    // The ISR service may already be installed by another module
+    esp_err_t err = gpio_install_isr_service(0);
+    if(err != ESP_OK && err != ESP_ERR_INVALID_STATE)
+    {
+        ESP_ERROR_CHECK(err);
+    }
+    ESP_ERROR_CHECK(gpio_isr_handler_add(int_gpio_i32, int_isr, NULL));
+    ESP_ERROR_CHECK(gpio_wakeup_enable(int_gpio_i32, GPIO_INTR_LOW_LEVEL));
+    ESP_ERROR_CHECK(esp_sleep_enable_gpio_wakeup());
+#if SOC_GPIO_SUPPORT_SLP_SWITCH
+    // Keep the pullup and the input through light sleep
+    gpio_sleep_sel_dis(int_gpio_i32);
+#endif
+
+    // Clears anything left from before a reset, and unmasks the interrupt
+    status_e &= RTC_clear_events(&events_cleared_u8);
+
+    ESP_LOGI("RTC_enable_events", "RTC events 0x%02x on GPIO %d (stale 0x%02x)", events_u8, (int)int_gpio_i32, events_cleared_u8);
+
+    return status_e;
+}
+
+/**===< global >===============================================================
+ * NAME:
+ *      RTC_set_alarm() - Set the daily alarm 1 of the RTC
+ *
+ * SUMMARY:
+ *      The alarm matches the hour, minute and second every day. It only
+ *      wakes a task if RTC_EVENT_ALARM is given to RTC_enable_events().
+ *
+ * INPUT REQUIREMENTS:
+ *      RTC_init() must have been called
+ *      Hour 0-23, minute 0-59, second 0-59
+ *
+ * OUTPUT GUARANTEES:
+ *      Will return a status enum (0 = fail, 1 = success)
+ **===< global >===============================================================*/
+STATUS_E RTC_set_alarm(const struct tm* p_alarm_s)
+{
+    if(rtc_initialized_b != TRUE)
+    {
+        return STATUS_ERR;
+    }
+
+    if(p_alarm_s == NULL
+    || p_alarm_s->tm_sec < 0 || p_alarm_s->tm_sec > 59
+    || p_alarm_s->tm_min < 0 || p_alarm_s->tm_min > 59
+    || p_alarm_s->tm_hour < 0 || p_alarm_s->tm_hour > 23)
+    {
+        return STATUS_ERR_PARAM;
+    }
+
+    STATUS_E status_e = STATUS_OK;
+
+    const UINT8 alarm1_enables_m_u8 = RTC_REG_ALARM_EN_M_SEC_A1E | RTC_REG_ALARM_EN_M_MIN_A1E | RTC_REG_ALARM_EN_M_HR_A1E
+                                    | RTC_REG_ALARM_EN_M_DAY_A1E | RTC_REG_ALARM_EN_M_MON_A1E;
+    UINT8 buffer_u8[4] = {RTC_REG_ADDR_SECOND_ALARM1, 0, 0, 0};
+    UINT8 time_values_u8[3] = {(UINT8)p_alarm_s->tm_sec, (UINT8)p_alarm_s->tm_min, (UINT8)p_alarm_s->tm_hour};
+
+    for(INT32 i = 1; i < sizeof(buffer_u8); i++)
+    {
+        status_e &= dec_to_bcd(&time_values_u8[i - 1], &buffer_u8[i]);
+    }
+
+    // No match on a half written alarm, enable it once the time is in
+    status_e &= reg_set(RTC_REG_ADDR_ALARM_ENABLES, alarm1_enables_m_u8, 0);
+    if(status_e >= STATUS_OK)
+    {
+        status_e = i2c_write(buffer_u8, sizeof(buffer_u8));
+    }
+    status_e &= reg_set(RTC_REG_ADDR_ALARM_ENABLES, alarm1_enables_m_u8,
+                        RTC_REG_ALARM_EN_M_SEC_A1E | RTC_REG_ALARM_EN_M_MIN_A1E | RTC_REG_ALARM_EN_M_HR_A1E);
+
+    return status_e;
+}
+
+/**===< global >===============================================================
+ * NAME:
+ *      RTC_clear_events() - Acknowledge the RTC events
+ *
+ * SUMMARY:
+ *      Reads and clears the event flags, which releases ~INTA, and unmasks
+ *      the GPIO interrupt again. Call from the task woken by
+ *      RTC_enable_events() after clearing flag_bits, so an event that comes
+ *      in between wakes it again.
+ *
+ * INPUT REQUIREMENTS:
+ *      RTC_enable_events() must have been called
+ *      p_events_u8 must not be null
+ *
+ * OUTPUT GUARANTEES:
+ *      p_events_u8 holds the RTC_EVENT_E bits that were set
+ *      Will return a status enum (0 = fail, 1 = success)
+ **===< global >===============================================================*/
+STATUS_E RTC_clear_events(UINT8* p_events_u8)
+{
+    if(rtc_initialized_b != TRUE || rtc_events_s.int_gpio_i32 < 0)
+    {
+        return STATUS_ERR;
+    }
+
+    STATUS_E status_e = flags_clear(p_events_u8);
+
+    // Unmask even on an I2C error, the pin is still low and the task is woken again to retry
+    gpio_intr_enable(rtc_events_s.int_gpio_i32);
+
+    return status_e;
+}
+
 /* end */
\ No newline at end of file
@@ -457,6 +457,27 @@
 
 /* ===========================================*/
 
+/* Time service, the RTC is read at these intervals by RTC_sync() */
+#define RTC_SYNC_MIN_S                  (60u)       // First resync interval, and after a correction
+#define RTC_SYNC_MAX_S                  (7680u)     // Longest resync interval (60 s doubled 7 times)
+#define RTC_DRIFT_MAX_PPB               (200000)    // Largest believable drift (200 ppm), more is a step
+
+/* Metrics of the time service, see RTC_get_sync_stats() */
+typedef struct{
+    INT32 drift_ppb_i32;                // Rate of the RTC against the CPU timer, parts per billion
+    INT32 last_error_us_i32;            // Correction made at the last resync
+    UINT32 resyncs_u32;                 // RTC reads since boot
+    UINT32 steps_u32;                   // Resyncs that restarted the time (RTC moved)
+    UINT32 sync_interval_s_u32;         // Time to the next resync
+} RTC_SYNC_STATS;
+
+/* Events the RTC signals on ~INTA, see RTC_enable_events() */
+typedef enum{
+    RTC_EVENT_NONE                  = 0x00,
+    RTC_EVENT_MINUTE                = 0x01, // Every minute rollover (periodic interrupt)
+    RTC_EVENT_ALARM                 = 0x02, // Alarm 1 matched, see RTC_set_alarm()
+} RTC_EVENT_E;
+
 /*=============================================================================*/
 /*][ GLOBAL : Exportable Variables ][==========================================*/
 /*=============================================================================*/
@@ -468,6 +489,12 @@
 extern STATUS_E     RTC_init(UINT8 rtc_addr_u8);
 extern STATUS_E     RTC_get_time(struct tm* p_timestamp_s);
 extern STATUS_E     RTC_set_time(struct tm* p_timestamp_s);
+extern STATUS_E     RTC_get_next_edge(UINT32 period_s_u32, UINT64* p_edge_us_u64);
+extern STATUS_E     RTC_sync(UINT32* p_next_sync_ms_u32);
+extern void         RTC_get_sync_stats(RTC_SYNC_STATS* p_stats_s);
+extern STATUS_E     RTC_enable_events(INT32 int_gpio_i32, UINT8 events_u8, EventGroupHandle_t flags_h, EventBits_t flag_bits);
+extern STATUS_E     RTC_set_alarm(const struct tm* p_alarm_s);
+extern STATUS_E     RTC_clear_events(UINT8* p_events_u8);
 
 /* End */
 #define WC_RTC_H
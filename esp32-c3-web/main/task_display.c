@@ -18,85 +18,284 @@
 
 #include "task_display.h"
 #include "cfg_clock.h"
+#include "cfg_clock_masks.h"
+#include "cfg_wave_luts.h"
+#include "clock_face.h"
+#include "esp_timer.h"
+#if CLOCK_EFFECT_BENCHMARK == 1
+#include <math.h>
+#include "esp_cpu.h"
+#endif
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ LOCAL : Constants and Types ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 
-//typedef 
+/* A full clock face: which pixels are lit, and the color of each lit pixel. The
+   buffers are in the display arena, sized from the LED geometry by CLOCK_Init() */
+typedef struct{
+    UINT64*             bits_u64;                               /* Lit pixels, clock_mask_words_i32 words */
+    UINT8*              color_index_u8;                         /* RGB_LED_DEFAULT_COLOR_E per pixel */
+    UINT8               brightness_u8;                          /* Brightness of every lit pixel */
+} CLOCK_FRAME;
+
+#define CLOCK_FRAME_PERIOD_US   (16667)     /* 60 frames per second */
+#define CLOCK_DITHER_PERIOD_US  (8333)      /* 120 frames per second while dithering */
+#define CLOCK_RENDER_BUDGET_US  (4000)      /* Render time allowed per frame */
+#define CLOCK_MAX_WORD_RANKS    (16)        /* Words faded in one after another */
+#define CLOCK_REQUEST_FRAMES    (4)         /* Frames queued to the display task */
+
+/* Task notification bits for the display task */
+typedef enum{
+    NOTIFY_FRAME_TICK   = 0x01,             /* Frame timer expired */
+    NOTIFY_NEW_FRAME    = 0x02,             /* New layer request queued */
+    NOTIFY_EFFECT       = 0x04,             /* Effect or dithering changed */
+} CLOCK_NOTIFY_E;
+
+/* Effect shader: modulates the color of the pixel at (x, y) on frame t */
+typedef RGB_COLOR (*CLOCK_EFFECT_FN)( UINT8 x_u8, UINT8 y_u8, UINT32 t_u32, RGB_COLOR color_S );
+
+/* Content of one compositor layer */
+typedef struct{
+    CLOCK_FRAME             frame_S;                    /* Overlay layers only */
+    UINT8                   alpha_u8;                   /* 0 = hidden, 255 = opaque */
+    BOOL                    flash_b;                    /* Alpha pulses at ~1Hz */
+} CLOCK_LAYER;
+
+/* Request to update a layer */
+typedef struct{
+    CLOCK_LAYER_E           layer_E;
+    BOOL                    frame_valid_b;              /* FALSE = only change alpha and flash */
+    UINT8                   frame_slot_u8;              /* clock_request_frames_S the frame is in */
+    CLOCK_LAYER             layer_S;
+    CLOCK_TRANSITION_E      transition_E;               /* LAYER_TIME only */
+} CLOCK_FRAME_REQUEST;
+
+/* Transition in progress between two frames */
+typedef struct{
+    BOOL                    active_b;
+    CLOCK_TRANSITION_E      transition_E;
+    UINT32                  frame_u32;                              /* Frames elapsed */
+    UINT32                  num_frames_u32;                         /* Frames in the transition */
+    UINT8                   num_ranks_u8;                           /* WORD_FADE only */
+    UINT8*                  rank_u8;                                /* WORD_FADE only, fade-in order per pixel */
+    CLOCK_FRAME             from_S;
+    CLOCK_FRAME             to_S;
+} CLOCK_ANIMATION;
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ LOCAL : Variables ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 
+static const CLOCK_FACE* volatile clock_face_S = &CLOCK_FACE_builtin_S;   /* Face words are looked up in */
+static struct tm clock_time_S;              /* Time last displayed */
+static BOOL clock_time_valid_b = FALSE;
+
+static INT32 clock_num_pixels_i32 = 0;      /* Pixels of the LED geometry, 0 before CLOCK_Init() */
+static INT32 clock_mask_words_i32 = 0;      /* 64-bit words of a display pixel mask */
+static void* clock_arena_p = NULL;          /* Single allocation behind the display buffers */
+
+static CLOCK_FRAME clock_shown_frame_S;     /* Settled content of the time layer */
+static CLOCK_FRAME clock_next_frame_S;      /* Frame being built for the next update */
+static CLOCK_ANIMATION clock_animation_S;   /* Transition being rendered by the display task */
+static CLOCK_FRAME clock_request_frames_S[ CLOCK_REQUEST_FRAMES ];  /* Frames of queued layer requests */
+
+static CLOCK_LAYER clock_layers_S[ NUM_LAYERS ] = {      /* Time and effect layers only use alpha */
+    [ LAYER_TIME ]      = { .alpha_u8 = 255 },
+    [ LAYER_EFFECT ]    = { .alpha_u8 = 255 },
+};
+static UINT64* clock_composite_mask_u64 = NULL;         /* Pixels lit by the last composite */
+static UINT64* clock_lit_mask_u64 = NULL;               /* Pixels lit by the composite being built */
+static BOOL clock_composite_dirty_b = FALSE;            /* A layer changed since the last composite */
+
+static CLOCK_TRANSITION_E clock_transition_E = TRANSITION_CROSSFADE;
+static UINT32 clock_transition_ms_u32 = 500;
+
+static TaskHandle_t h_task_display = NULL;
+static QueueHandle_t q_display_frames = NULL;
+static QueueHandle_t q_free_frames = NULL;  /* Indexes of the unused clock_request_frames_S */
+static esp_timer_handle_t timer_handle_frame = NULL;
+
+static volatile CLOCK_EFFECT_E clock_effect_E = EFFECT_NONE;
+static CLOCK_EFFECT_E clock_effect_shown_E = EFFECT_NONE;  /* Effect last rendered by the display task */
+static UINT32 clock_effect_frame_u32 = 0;                   /* Effect time, in 60 fps frames */
+static UINT32 frame_timer_period_us_u32 = 0;                /* Frame timer period, 0 = stopped */
+
+static portMUX_TYPE frame_tick_lock_s = portMUX_INITIALIZER_UNLOCKED;
+static UINT32 frame_ticks_u32 = 0;          /* Frame timer expiries not yet handled */
+static CLOCK_FRAME_STATS clock_frame_stats_S;
+
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ Function Definitions ][~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      FrameClear() - "Turn off every pixel of a frame"
+ *
+ * INPUTS:
+ *      frame - the frame to clear
+ *      brightness - the percentage brightness for pixels lit afterwards
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void FrameClear( CLOCK_FRAME* frame_S, UINT8 brightness_u8 )
+{
+    memset( frame_S->bits_u64, 0, clock_mask_words_i32 * sizeof( UINT64 ) );
+    frame_S->brightness_u8 = brightness_u8;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      FrameCopy() - "Copy the content of a frame"
+ *
+ * DESCRIPTION:
+ *      Frames only point to their buffers, so they are copied with this
+ *      rather than by assignment. Only the colors of lit pixels are used,
+ *      but all are copied to keep the work the same for every frame.
+ *
+ * INPUTS:
+ *      to - the frame to overwrite
+ *      from - the frame to copy
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void FrameCopy( CLOCK_FRAME* to_S, const CLOCK_FRAME* from_S )
+{
+    memcpy( to_S->bits_u64, from_S->bits_u64, clock_mask_words_i32 * sizeof( UINT64 ) );
+    memcpy( to_S->color_index_u8, from_S->color_index_u8, clock_num_pixels_i32 );
+    to_S->brightness_u8 = from_S->brightness_u8;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      FrameSetPixel() - "Light a single pixel of a frame"
+ *
+ * INPUTS:
+ *      frame - the frame to draw into
+ *      pixel - the LED index
+ *      color - the color of the pixel
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void FrameSetPixel( CLOCK_FRAME* frame_S, UINT8 pixel_u8, RGB_LED_DEFAULT_COLOR_E color_E )
+{
+    if( pixel_u8 >= clock_num_pixels_i32 )
+    {
+        return;
+    }
+
+    frame_S->bits_u64[ pixel_u8 / 64 ] |= ( 1ull << ( pixel_u8 % 64 ) );
+    frame_S->color_index_u8[ pixel_u8 ] = color_E;
+}
+
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
  * <<< LOCAL FUNCTION >>>
  * SUMMARY:
  *      ColorWordPixels() - "Color the pixels of a given word"
  *
  * DESCRIPTION:
- *      Takes the index of a word in the clock_config.c words structure, and
- *      loops through the defined pixels to color them all.
+ *      Takes the index of a word in the word table of the face, and loops
+ *      through the defined pixels to color them all in the frame.
  *
  * INPUTS:
+ *      frame - the frame to draw into
+ *      face - the face the word belongs to
  *      wordIndex - the index of the word in the structure
  *      color - the color to print the word in
- *      brightness - the percentage brightness value to print the word in
  *
  * OUTPUTS:
  *      TRUE - successfully printed the word
  *      FALSE - could not print pixels
  *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
-BOOL ColorWordPixels( UINT8 word_index_u8, RGB_COLOR_PCT color_S, UINT8 brightness_u8 )
+BOOL ColorWordPixels( CLOCK_FRAME* frame_S, const CLOCK_FACE* face_S, UINT8 word_index_u8, RGB_LED_DEFAULT_COLOR_E color_E )
 {
     /* Ensure the index is within bounds */
-    if( word_index_u8 >= CLOCK_num_words_u8 )
+    if( word_index_u8 >= face_S->header_S->num_words_u8 )
     {
         return FALSE;
     }
 
-    ESP_LOGI( "ColorWordPixels()", "Printing word: \"%s\"", CLOCK_words_S[ word_index_u8 ].word_str );
+    const UINT8* pixels_u8 = CLOCK_FACE_WordPixels( face_S, word_index_u8 );
+
+    ESP_LOGI( "ColorWordPixels()", "Printing word: \"%s\"", CLOCK_FACE_WordName( face_S, word_index_u8 ) );
 
     /* For each letter in the word, */
-    for( INT8 pixel = 0; pixel < CLOCK_words_S[ word_index_u8 ].word_length_u8; pixel++ )
+    for( INT8 pixel = 0; pixel < face_S->words_S[ word_index_u8 ].length_u8; pixel++ )
     {
         /* Color the pixel */
-        RGB_LED_SetPixelColor( CLOCK_words_S[ word_index_u8 ].word_pixels_u8[ pixel ], color_S, brightness_u8 );
-        ESP_LOGD( "ColorWordPixels()", "Colored pixel #%d", CLOCK_words_S[ word_index_u8 ].word_pixels_u8[ pixel ] );
+        FrameSetPixel( frame_S, pixels_u8[ pixel ], color_E );
+        ESP_LOGD( "ColorWordPixels()", "Colored pixel #%d", pixels_u8[ pixel ] );
     }
 
     return TRUE;
 }
 
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      WordHash() - "Hash a (word, type) pair"
+ *
+ * DESCRIPTION:
+ *      FNV-1a over the word and the single type bit. Must match hash_key()
+ *      and hash_slot() in tools/gen_clock_masks.py, which picks the seeds so
+ *      that every word of the face lands in its own slot.
+ *
+ * INPUTS:
+ *      face - the face whose hash table is used
+ *      word - the word to hash
+ *      type - a single CLOCK_WORD_TYPE bit
+ *
+ * OUTPUTS:
+ *      (UINT16) slot in the hash_slot_u8 table of the face
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+UINT16 WordHash( const CLOCK_FACE* face_S, STRING word_str, UINT8 type_u8 )
+{
+    UINT32 key_u32 = 0x811C9DC5u;
+    UINT32 hash_u32;
+
+    while( *word_str != '\0' )
+    {
+        key_u32 = ( key_u32 ^ (UINT8)*word_str++ ) * 0x01000193u;
+    }
+    key_u32 = ( key_u32 ^ type_u8 ) * 0x01000193u;
+
+    hash_u32 = ( key_u32 ^ face_S->hash_seed_u16[ key_u32 & ( face_S->header_S->hash_buckets_u16 - 1 ) ] ) * 0x9E3779B1u;
+    hash_u32 ^= hash_u32 >> 16;
+
+    return hash_u32 & ( face_S->header_S->hash_slots_u16 - 1 );
+}
+
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
  * <<< LOCAL FUNCTION >>>
  * SUMMARY:
  *      DisplayWord() - "Display a given word on the clock face"
  *
  * DESCRIPTION:
- *      Takes the string of a word and checks to see if the word exists in
- *      the collection of words available on the clock face. If the word
- *      exits, it first checks that the type is compatible before finding
- *      the index of the word and calling ColorWordPixels() to
- *      color the associated pixels.
+ *      Takes the string of a word and looks it up in the perfect hash of
+ *      the words available on the active clock face (clock_face.h), once for
+ *      each type bit requested. The candidate word is confirmed with a
+ *      single strcmp(), then ColorWordPixels() colors the associated pixels.
  *
  * INPUTS:
+ *      frame - the frame to draw into
  *      word - the word to display
  *      type - the type of word (prefix, hour, etc)
  *      color - the color to print the word in
- *      brightness - the percentage brightness value to print the word in
  *
  * OUTPUTS:
  *      TRUE - successfully printed the word
  *      FALSE - could not find word
  *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
-BOOL DisplayWord( STRING word_str, CLOCK_WORD_TYPE word_type_E, RGB_COLOR_PCT color_S, UINT8 brightness_u8 )
+BOOL DisplayWord( CLOCK_FRAME* frame_S, STRING word_str, CLOCK_WORD_TYPE word_type_E, RGB_LED_DEFAULT_COLOR_E color_E )
 {
-    BOOL success_b = TRUE;
+    const CLOCK_FACE* face_S = clock_face_S;
 
     /* Do not check if null pointer */
     if( word_str == NULL )
@@ -104,26 +303,78 @@ BOOL DisplayWord( STRING word_str, CLOCK_WORD_TYPE word_type_E, RGB_COLOR_PCT co
         return FALSE;
     }
 
-    /* Check the current buffer for matches against word collection */
-    for( INT8 word = 0; word < CLOCK_num_words_u8; word++ )
+    /* One hash lookup per requested type, lowest type bit first */
+    for( UINT8 types_u8 = word_type_E; types_u8 != 0; types_u8 &= ( types_u8 - 1 ) )
     {
-        /* If a match exists */
-        if( ( strcmp( word_str, CLOCK_words_S[ word ].word_str ) == 0 )
-         && ( ( CLOCK_words_S[ word ].word_type_E & word_type_E ) != 0 ) )
+        UINT8 type_u8 = types_u8 & -types_u8;
+        UINT8 word_u8 = face_S->hash_slot_u8[ WordHash( face_S, word_str, type_u8 ) ];
+
+        /* A slot only proves a match once the word itself is compared */
+        if( ( word_u8 != CLOCK_WORD_HASH_EMPTY )
+         && ( face_S->words_S[ word_u8 ].type_u8 == type_u8 )
+         && ( strcmp( word_str, CLOCK_FACE_WordName( face_S, word_u8 ) ) == 0 ) )
         {
-            success_b = ColorWordPixels( word, color_S, brightness_u8 );
-            break;
+            return ColorWordPixels( frame_S, face_S, word_u8, color_E );
         }
-        /* If a match was not found in all words */
-        else if( word == ( CLOCK_num_words_u8 - 1 ) )
+    }
+
+    /* Mark failed phrase display */
+    ESP_LOGW( "DisplayWord()", "Failed to find: \"%s\"!", word_str );
+    return FALSE;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      FaceMaskWords() - "Get the words of a face mask inside the display"
+ *
+ * DESCRIPTION:
+ *      Face masks have the CLOCK_MASK_WORDS of the face image, display masks
+ *      are sized from the LED geometry. A face only lights pixels below its
+ *      led_count, which FaceFitsLeds() keeps on the chain, so the words past
+ *      either end are empty.
+ *
+ * OUTPUTS:
+ *      (INT32) words to visit in a face mask
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+INT32 FaceMaskWords( void )
+{
+    return ( clock_mask_words_i32 < CLOCK_MASK_WORDS ) ? clock_mask_words_i32 : CLOCK_MASK_WORDS;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      ColorMaskPixels() - "Color every pixel set in a packed pixel mask"
+ *
+ * DESCRIPTION:
+ *      Adds a CLOCK_PIXEL_MASK (generated at build time, see clock_face.h)
+ *      to the lit pixels of the frame, and colors the newly set pixels.
+ *
+ * INPUTS:
+ *      frame - the frame to draw into
+ *      mask - the packed pixel mask to display
+ *      color - the color to print the pixels in
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void ColorMaskPixels( CLOCK_FRAME* frame_S, const CLOCK_PIXEL_MASK* mask_S, RGB_LED_DEFAULT_COLOR_E color_E )
+{
+    for( INT32 word = 0; word < FaceMaskWords(); word++ )
+    {
+        UINT64 bits_u64 = mask_S->bits_u64[ word ];
+
+        frame_S->bits_u64[ word ] |= bits_u64;
+
+        /* Pop the lowest set bit until none are left */
+        while( bits_u64 != 0 )
         {
-            /* Mark failed phrase display */
-            ESP_LOGW( "DisplayWord()", "Failed to find: \"%s\"!", word_str );
-            return FALSE;
+            INT32 pixel_i32 = ( word * 64 ) + __builtin_ctzll( bits_u64 );
+            frame_S->color_index_u8[ pixel_i32 ] = color_E;
+            bits_u64 &= ( bits_u64 - 1 );
         }
     }
-
-    return success_b;
 }
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
@@ -132,99 +383,1438 @@ BOOL DisplayWord( STRING word_str, CLOCK_WORD_TYPE word_type_E, RGB_COLOR_PCT co
  *      DisplayPhrase() - "Display a given phrase on the clock face"
  *
  * DESCRIPTION:
- *      Takes a phrase in string format, and separates into substrings which
- *      are then used to search the structure of words in the cfg_clock.c
- *      file. If a match is found, the index of the word in the structure
- *      is passed to another helper function to display it.
+ *      Places the words of the phrase in reading order with
+ *      CLOCK_ResolvePhrase(), then colors the pixels of every word that
+ *      could be placed.
  *
  * INPUTS:
+ *      frame - the frame to draw into
  *      phrase - phrase to parse and display
  *      type - the type of words to look for (can be multiple)
  *      color - the color to print the words in
- *      brightness - the percentage brightness value to print the words in
  *
  * OUTPUTS:
  *      TRUE - successfully printed every word in the phrase
- *      FALSE - could not parse and display one or more words
+ *      FALSE - could not place one or more words
  *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
-BOOL DisplayPhrase( STRING phrase_str, CLOCK_WORD_TYPE word_type_E, RGB_COLOR_PCT color_S, UINT8 brightness_u8 )
+BOOL DisplayPhrase( CLOCK_FRAME* frame_S, STRING phrase_str, CLOCK_WORD_TYPE word_type_E, RGB_LED_DEFAULT_COLOR_E color_E )
 {
-    BOOL success_b = TRUE;
-    CHAR buffer_current_word_c[ MAX_WORD_LENGTH ] = { 0 };
-    UINT8 buffer_charindex_u8 = 0;
-    UINT8 phrase_charindex_u8 = 0;
+    CLOCK_PHRASE_PLACEMENT placement_S;
+    BOOL success_b = CLOCK_ResolvePhrase( phrase_str, word_type_E, &placement_S );
 
-    /* Only loop while evaluating string */
-    while( phrase_str[ phrase_charindex_u8 ] != '\0' )
+    ColorMaskPixels( frame_S, &placement_S.mask_S, color_E );
+
+    if( !success_b )
     {
-        /* If a word inside the phrase is encountered */
-        if( phrase_str[ phrase_charindex_u8 ] == ' ' )
-        {
-            /* Cap the buffered string */
-            buffer_current_word_c[ buffer_charindex_u8 ] = '\0';
+        ESP_LOGW( "DisplayPhrase()", "Could not place words 0x%08" PRIX32 " of \"%s\"!", placement_S.unplaced_u32, phrase_str );
+    }
 
-            /* Attempt to display the word (checks against word collection) */
-            success_b &= DisplayWord( buffer_current_word_c, word_type_E, color_S, brightness_u8 );
+    return success_b;
+}
 
-            /* Reset the "current word" buffer */
-            memset( buffer_current_word_c, 0, sizeof( buffer_current_word_c ) );
-            buffer_charindex_u8 = 0;
-            phrase_charindex_u8++;
-        }
-        /* If the next character is the end of the phrase */
-        else if( phrase_str[ phrase_charindex_u8 + 1 ] == '\0' )
-        {
-            /* Final update to the buffer */
-            buffer_current_word_c[ buffer_charindex_u8++ ] = phrase_str[ phrase_charindex_u8++ ];
-            buffer_current_word_c[ buffer_charindex_u8 ] = '\0';
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      FrameIntensity() - "Get the visible color of a frame pixel"
+ *
+ * DESCRIPTION:
+ *      Returns the color of a pixel already scaled by the frame brightness,
+ *      or black when the pixel is not lit. Transitions blend these values.
+ *
+ * INPUTS:
+ *      frame - the frame to read
+ *      pixel - the LED index
+ *
+ * OUTPUTS:
+ *      (RGB_COLOR) 0 - 255 per channel, at 100% brightness
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+RGB_COLOR FrameIntensity( const CLOCK_FRAME* frame_S, INT32 pixel_i32 )
+{
+    RGB_COLOR color_S = { 0 };
 
-            /* Check the current buffer for matches against word collection */
-            success_b &= DisplayWord( buffer_current_word_c, word_type_E, color_S, brightness_u8 );
-        }
-        else
-        {
-            /* Add the indexed phrase character to the "current word" buffer */
-            buffer_current_word_c[ buffer_charindex_u8++ ] = phrase_str[ phrase_charindex_u8++ ];
-        }
+    if( frame_S->bits_u64[ pixel_i32 / 64 ] & ( 1ull << ( pixel_i32 % 64 ) ) )
+    {
+        color_S = RGB_LED_default_colors_S[ frame_S->color_index_u8[ pixel_i32 ] ];
+        color_S.r = ( color_S.r * frame_S->brightness_u8 ) / 100;
+        color_S.g = ( color_S.g * frame_S->brightness_u8 ) / 100;
+        color_S.b = ( color_S.b * frame_S->brightness_u8 ) / 100;
     }
 
-    return success_b;
+    return color_S;
 }
 
-BOOL CLOCK_Init( void );
-BOOL CLOCK_Tick( void );
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      BlendColor() - "Blend two colors with an integer weight"
+ *
+ * INPUTS:
+ *      from - color at weight 0
+ *      to - color at weight 256
+ *      weight - 0 - 256
+ *
+ * OUTPUTS:
+ *      (RGB_COLOR) blended color
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+RGB_COLOR BlendColor( RGB_COLOR from_S, RGB_COLOR to_S, UINT32 weight_u32 )
+{
+    RGB_COLOR color_S;
 
-BOOL CLOCK_UpdateTime( void )
+    color_S.r = ( ( from_S.r * ( 256 - weight_u32 ) ) + ( to_S.r * weight_u32 ) ) >> 8;
+    color_S.g = ( ( from_S.g * ( 256 - weight_u32 ) ) + ( to_S.g * weight_u32 ) ) >> 8;
+    color_S.b = ( ( from_S.b * ( 256 - weight_u32 ) ) + ( to_S.b * weight_u32 ) ) >> 8;
+
+    return color_S;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      ScaleColor() - "Scale a color by an 8-bit level"
+ *
+ * INPUTS:
+ *      color - the color to scale
+ *      level - 0 - 255 (255 = unchanged)
+ *
+ * OUTPUTS:
+ *      (RGB_COLOR) scaled color
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+RGB_COLOR ScaleColor( RGB_COLOR color_S, UINT32 level_u32 )
 {
-    /* Wipe, and delay to prevent timing glitches */
-    RGB_LED_Wipe();
-    vTaskDelay( pdMS_TO_TICKS( 10 ) );
+    color_S.r = ( ( color_S.r * level_u32 ) + 127 ) / 255;
+    color_S.g = ( ( color_S.g * level_u32 ) + 127 ) / 255;
+    color_S.b = ( ( color_S.b * level_u32 ) + 127 ) / 255;
 
-    DisplayPhrase( "it is zozz twenty five to", WORD_PREFIX, RGB_LED_default_colors_S[ COLOR_Mint ], 100 );
-    DisplayPhrase( "eleven my guy", WORD_HOUR, RGB_LED_default_colors_S[ COLOR_Rose ], 100 );
+    return color_S;
+}
 
-    RGB_LED_TransmitColors();
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      ColorLevel() - "Get the brightest channel of a color"
+ *
+ * DESCRIPTION:
+ *      Effects that replace the hue keep the brightness of the frame by
+ *      scaling the new color with this level, so unlit pixels stay black.
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+UINT32 ColorLevel( RGB_COLOR color_S )
+{
+    UINT32 level_u32 = color_S.r;
 
-    return TRUE;
+    level_u32 = ( color_S.g > level_u32 ) ? color_S.g : level_u32;
+    level_u32 = ( color_S.b > level_u32 ) ? color_S.b : level_u32;
+
+    return level_u32;
 }
 
-/* Test - cycle the words */
-BOOL CLOCK_TestWords( RGB_COLOR_PCT color )
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      Effect...() - "Effect shaders"
+ *
+ * DESCRIPTION:
+ *      Each shader gets the grid position of a pixel, the effect time in
+ *      frames and the frame color of the pixel, and returns the color to
+ *      show. Waveforms come from the generated tables in cfg_wave_luts.c,
+ *      indexed by an 8-bit phase, so no floating point is used. Black pixels
+ *      stay black in every effect.
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+RGB_COLOR EffectNone( UINT8 x_u8, UINT8 y_u8, UINT32 t_u32, RGB_COLOR color_S )
 {
-    static UINT8 word_index_u8 = 0;
-    
-    /* Wipe, and delay to prevent timing glitches */
-    RGB_LED_Wipe();
-    vTaskDelay( pdMS_TO_TICKS( 10 ) );
+    return color_S;
+}
+
+RGB_COLOR EffectRainbow( UINT8 x_u8, UINT8 y_u8, UINT32 t_u32, RGB_COLOR color_S )
+{
+    /* One hue cycle across about two face widths, one scroll every ~4 seconds */
+    UINT8 phase_u8 = ( x_u8 * 12 ) + ( y_u8 * 12 ) - t_u32;
+
+    return ScaleColor( WAVE_hue_S[ phase_u8 ], ColorLevel( color_S ) );
+}
+
+RGB_COLOR EffectBreathe( UINT8 x_u8, UINT8 y_u8, UINT32 t_u32, RGB_COLOR color_S )
+{
+    /* ~4.3 second period, eased so the fade looks even, never fully off */
+    UINT32 level_u32 = 32 + ( ( WAVE_ease_u8[ WAVE_sine_u8[ t_u32 & 0xFF ] ] * ( 255 - 32 ) ) / 255 );
 
-    ColorWordPixels( word_index_u8, color, 100 );
+    return ScaleColor( color_S, level_u32 );
+}
+
+RGB_COLOR EffectSparkle( UINT8 x_u8, UINT8 y_u8, UINT32 t_u32, RGB_COLOR color_S )
+{
+    const RGB_COLOR white_S = { 255, 255, 255 };
+    UINT32 window_u32 = t_u32 >> 4;
+    UINT32 hash_u32;
 
-    if( ++word_index_u8 >= CLOCK_num_words_u8 )
+    if( ColorLevel( color_S ) == 0 )
     {
-        word_index_u8 = 0;
+        return color_S;
     }
 
-    RGB_LED_TransmitColors();
+    /* Integer hash of the pixel and the current 16 frame window */
+    hash_u32 = ( x_u8 * 0x9E3779B1u ) ^ ( y_u8 * 0x85EBCA77u ) ^ ( window_u32 * 0xC2B2AE3Du );
+    hash_u32 ^= hash_u32 >> 15;
+    hash_u32 *= 0x2C1B3C6Du;
+    hash_u32 ^= hash_u32 >> 12;
 
-    return TRUE;
-}
\ No newline at end of file
+    /* About 1 in 16 lit pixels flashes in each window, rising and falling over it */
+    if( ( hash_u32 & 0x0F ) != 0 )
+    {
+        return color_S;
+    }
+
+    return BlendColor( color_S, white_S, WAVE_sine_u8[ ( t_u32 & 0x0F ) << 4 ] );
+}
+
+RGB_COLOR EffectGradient( UINT8 x_u8, UINT8 y_u8, UINT32 t_u32, RGB_COLOR color_S )
+{
+    /* Left edge keeps the frame color, right edge shows a slowly drifting hue */
+    RGB_COLOR hue_S = ScaleColor( WAVE_hue_S[ ( t_u32 >> 2 ) & 0xFF ], ColorLevel( color_S ) );
+
+    return BlendColor( color_S, hue_S, ( x_u8 * 256 ) / ( clock_face_S->header_S->grid_width_u8 - 1 ) );
+}
+
+/* Shader for each CLOCK_EFFECT_E */
+static const CLOCK_EFFECT_FN clock_effects_S[ NUM_EFFECTS ] = {
+    [ EFFECT_NONE ]     = EffectNone,
+    [ EFFECT_RAINBOW ]  = EffectRainbow,
+    [ EFFECT_BREATHE ]  = EffectBreathe,
+    [ EFFECT_SPARKLE ]  = EffectSparkle,
+    [ EFFECT_GRADIENT ] = EffectGradient,
+};
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      EffectShade() - "Apply the current effect to one pixel"
+ *
+ * INPUTS:
+ *      pixel - the LED index
+ *      color - frame color of the pixel
+ *
+ * OUTPUTS:
+ *      (RGB_COLOR) color to show
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+RGB_COLOR EffectShade( INT32 pixel_i32, RGB_COLOR color_S )
+{
+    const CLOCK_FACE* face_S = clock_face_S;
+
+    return clock_effects_S[ clock_effect_shown_E ]( face_S->pixel_x_u8[ pixel_i32 ], face_S->pixel_y_u8[ pixel_i32 ],
+        clock_effect_frame_u32, color_S );
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      LayerWeight() - "Get the blend weight of a layer"
+ *
+ * DESCRIPTION:
+ *      Converts the layer alpha to a 0 - 256 blend weight, pulsing it with
+ *      the sine table when the layer flashes.
+ *
+ * INPUTS:
+ *      layer - the layer
+ *
+ * OUTPUTS:
+ *      (UINT32) 0 = layer not visible, 256 = opaque
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+UINT32 LayerWeight( CLOCK_LAYER_E layer_E )
+{
+    UINT32 alpha_u32 = clock_layers_S[ layer_E ].alpha_u8;
+
+    if( clock_layers_S[ layer_E ].flash_b )
+    {
+        alpha_u32 = ( alpha_u32 * WAVE_sine_u8[ ( clock_effect_frame_u32 << 2 ) & 0xFF ] ) / 255;
+    }
+
+    return alpha_u32 + ( alpha_u32 >> 7 );
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      LayersAnimated() - "Check if the composite changes on its own"
+ *
+ * OUTPUTS:
+ *      TRUE - a transition, an effect or a flashing overlay is visible
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+BOOL LayersAnimated( void )
+{
+    BOOL animated_b = clock_animation_S.active_b;
+
+    animated_b |= ( clock_effect_shown_E != EFFECT_NONE ) && ( clock_layers_S[ LAYER_EFFECT ].alpha_u8 != 0 );
+    animated_b |= clock_layers_S[ LAYER_NOTIFY ].flash_b && ( clock_layers_S[ LAYER_NOTIFY ].alpha_u8 != 0 );
+    animated_b |= clock_layers_S[ LAYER_UI ].flash_b && ( clock_layers_S[ LAYER_UI ].alpha_u8 != 0 );
+
+    return animated_b;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      FramePeriodUs() - "Get the current frame period"
+ *
+ * DESCRIPTION:
+ *      Dithering needs a faster refresh for the averaged levels not to
+ *      flicker, otherwise frames are rendered at 60 fps.
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+UINT32 FramePeriodUs( void )
+{
+    return RGB_LED_GetDither() ? CLOCK_DITHER_PERIOD_US : CLOCK_FRAME_PERIOD_US;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      AnimationStart() - "Begin a transition to a new frame"
+ *
+ * DESCRIPTION:
+ *      Starts a transition from the frame currently shown to the requested
+ *      frame. For TRANSITION_WORD_FADE, every clock word fully contained in
+ *      the new frame gets a rank in reading order (top row first), and the
+ *      words fade in one rank after another. A TRANSITION_CUT, or a frame
+ *      lighting the same pixels as the one shown, replaces it right away.
+ *
+ * INPUTS:
+ *      request - frame and transition to show
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void AnimationStart( const CLOCK_FRAME_REQUEST* request_S )
+{
+    CLOCK_ANIMATION* anim_S = &clock_animation_S;
+
+    const CLOCK_FRAME* frame_S = &request_S->layer_S.frame_S;
+
+    /* Finish any running transition at its end frame */
+    if( anim_S->active_b )
+    {
+        anim_S->active_b = FALSE;
+        FrameCopy( &clock_shown_frame_S, &anim_S->to_S );
+    }
+
+    clock_composite_dirty_b = TRUE;
+
+    if( ( request_S->transition_E == TRANSITION_CUT ) || ( clock_transition_ms_u32 == 0 )
+     || ( memcmp( frame_S->bits_u64, clock_shown_frame_S.bits_u64, clock_mask_words_i32 * sizeof( UINT64 ) ) == 0 ) )
+    {
+        FrameCopy( &clock_shown_frame_S, frame_S );
+        return;
+    }
+
+    anim_S->transition_E = request_S->transition_E;
+    anim_S->frame_u32 = 0;
+    anim_S->num_frames_u32 = ( clock_transition_ms_u32 * 1000 ) / FramePeriodUs();
+    if( anim_S->num_frames_u32 == 0 )
+    {
+        anim_S->num_frames_u32 = 1;
+    }
+    FrameCopy( &anim_S->from_S, &clock_shown_frame_S );
+    FrameCopy( &anim_S->to_S, frame_S );
+    anim_S->num_ranks_u8 = 1;
+
+    if( anim_S->transition_E == TRANSITION_WORD_FADE )
+    {
+        const CLOCK_FACE* face_S = clock_face_S;
+        CLOCK_PIXEL_MASK ranked_S = { 0 };
+        memset( anim_S->rank_u8, 0, clock_num_pixels_i32 );
+
+        /* Rank words row by row from the top, using the first pixel of each word */
+        for( INT32 row = face_S->header_S->grid_height_u8 - 1; row >= 0; row-- )
+        {
+            for( INT32 word = 0; word < face_S->header_S->num_words_u8; word++ )
+            {
+                const CLOCK_PIXEL_MASK* word_mask_S = &face_S->word_masks_S[ word ];
+                const UINT8* pixels_u8 = CLOCK_FACE_WordPixels( face_S, word );
+                BOOL contained_b = TRUE;
+                BOOL ranked_b = FALSE;
+
+                if( face_S->pixel_y_u8[ pixels_u8[ 0 ] ] != row )
+                {
+                    continue;
+                }
+
+                for( INT32 w = 0; w < FaceMaskWords(); w++ )
+                {
+                    contained_b &= ( ( word_mask_S->bits_u64[ w ] & ~anim_S->to_S.bits_u64[ w ] ) == 0 );
+                    ranked_b |= ( ( word_mask_S->bits_u64[ w ] & ranked_S.bits_u64[ w ] ) != 0 );
+                }
+
+                if( !contained_b || ranked_b || ( anim_S->num_ranks_u8 >= CLOCK_MAX_WORD_RANKS ) )
+                {
+                    continue;
+                }
+
+                for( INT32 pixel = 0; pixel < face_S->words_S[ word ].length_u8; pixel++ )
+                {
+                    UINT8 index_u8 = pixels_u8[ pixel ];
+                    anim_S->rank_u8[ index_u8 ] = anim_S->num_ranks_u8;
+                    ranked_S.bits_u64[ index_u8 / 64 ] |= ( 1ull << ( index_u8 % 64 ) );
+                }
+                anim_S->num_ranks_u8++;
+            }
+        }
+    }
+
+    anim_S->active_b = TRUE;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      AnimationWeight() - "Get the transition weight of a pixel"
+ *
+ * DESCRIPTION:
+ *      - TRANSITION_CROSSFADE blends the two frames evenly.
+ *      - TRANSITION_WIPE sweeps the new frame in column by column, using the
+ *        grid position of the pixel on the active face.
+ *      - TRANSITION_WORD_FADE fades out the old frame during the first rank,
+ *        then fades in the words of the new frame one rank at a time.
+ *
+ * INPUTS:
+ *      pixel - the LED index
+ *      progress - progress through the transition, 0 - 256
+ *
+ * OUTPUTS:
+ *      (UINT32) weight of the new frame, 0 - 256
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+UINT32 AnimationWeight( INT32 pixel_i32, UINT32 progress_u32 )
+{
+    CLOCK_ANIMATION* anim_S = &clock_animation_S;
+    const CLOCK_FACE* face_S = clock_face_S;
+    UINT32 weight_u32 = progress_u32;
+
+    switch( anim_S->transition_E )
+    {
+        case TRANSITION_WIPE:
+            /* Columns left of the sweep show the new frame */
+            weight_u32 = ( ( (UINT32)face_S->pixel_x_u8[ pixel_i32 ] << 8 ) < ( progress_u32 * face_S->header_S->grid_width_u8 ) ) ? 256 : 0;
+            break;
+
+        case TRANSITION_WORD_FADE:
+        {
+            /* Each rank (0 = fade out of the old frame) gets an equal slice */
+            INT32 ranked_i32 = ( progress_u32 * anim_S->num_ranks_u8 ) - ( anim_S->rank_u8[ pixel_i32 ] << 8 );
+            weight_u32 = ( ranked_i32 < 0 ) ? 0 : ( ranked_i32 > 256 ) ? 256 : ranked_i32;
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    return weight_u32;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      LayersCompose() - "Blend the layers and push the result to the LEDs"
+ *
+ * DESCRIPTION:
+ *      Builds each output pixel from the bottom layer up:
+ *      - LAYER_TIME: the shown frame, or the running transition.
+ *      - LAYER_EFFECT: the current effect, blended in with the layer alpha.
+ *      - LAYER_NOTIFY, LAYER_UI: lit overlay pixels blended in with the
+ *        layer alpha, unlit overlay pixels are transparent.
+ *      Only pixels lit by a visible layer now or by the last composite are
+ *      visited. A pixel showing just the time layer keeps its palette color
+ *      and brightness in the driver, so dimmed pixels keep full precision
+ *      for dithering. The driver only sends pixels whose value changed.
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      STATUS_OK - changes were transmitted
+ *      STATUS_NO_CHANGE - composite was identical, nothing transmitted
+ *      STATUS_BUSY - driver busy, the changes stay pending in the driver
+ *                    and go out with the next RGB_LED_TransmitColors()
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+STATUS_E LayersCompose( void )
+{
+    CLOCK_ANIMATION* anim_S = &clock_animation_S;
+    UINT64* lit_u64 = clock_lit_mask_u64;
+    UINT32 weights_u32[ NUM_LAYERS ];
+    UINT32 progress_u32 = 0;
+
+    for( INT32 layer = 0; layer < NUM_LAYERS; layer++ )
+    {
+        weights_u32[ layer ] = LayerWeight( layer );
+    }
+    if( clock_effect_shown_E == EFFECT_NONE )
+    {
+        weights_u32[ LAYER_EFFECT ] = 0;
+    }
+    if( anim_S->active_b )
+    {
+        progress_u32 = ( anim_S->frame_u32 << 8 ) / anim_S->num_frames_u32;
+    }
+
+    /* Pixels lit by any visible layer */
+    for( INT32 word = 0; word < clock_mask_words_i32; word++ )
+    {
+        lit_u64[ word ] = 0;
+        if( weights_u32[ LAYER_TIME ] != 0 )
+        {
+            lit_u64[ word ] |= clock_shown_frame_S.bits_u64[ word ];
+            if( anim_S->active_b )
+            {
+                lit_u64[ word ] |= anim_S->from_S.bits_u64[ word ] | anim_S->to_S.bits_u64[ word ];
+            }
+        }
+        for( INT32 layer = LAYER_NOTIFY; layer < NUM_LAYERS; layer++ )
+        {
+            if( weights_u32[ layer ] != 0 )
+            {
+                lit_u64[ word ] |= clock_layers_S[ layer ].frame_S.bits_u64[ word ];
+            }
+        }
+    }
+
+    for( INT32 word = 0; word < clock_mask_words_i32; word++ )
+    {
+        /* Also visit the pixels lit last time, to turn them off */
+        UINT64 bits_u64 = lit_u64[ word ] | clock_composite_mask_u64[ word ];
+
+        while( bits_u64 != 0 )
+        {
+            INT32 pixel_i32 = ( word * 64 ) + __builtin_ctzll( bits_u64 );
+            UINT64 bit_u64 = bits_u64 & -bits_u64;
+            RGB_COLOR color_S = { 0 };
+            UINT8 level_u8 = 0;
+            bits_u64 &= ( bits_u64 - 1 );
+
+            /* Time layer, kept as palette color and brightness while possible */
+            if( weights_u32[ LAYER_TIME ] == 0 )
+            {
+                /* Hidden */
+            }
+            else if( anim_S->active_b )
+            {
+                color_S = BlendColor( FrameIntensity( &anim_S->from_S, pixel_i32 ), FrameIntensity( &anim_S->to_S, pixel_i32 ),
+                    AnimationWeight( pixel_i32, progress_u32 ) );
+                level_u8 = 100;
+            }
+            else if( clock_shown_frame_S.bits_u64[ word ] & bit_u64 )
+            {
+                color_S = RGB_LED_default_colors_S[ clock_shown_frame_S.color_index_u8[ pixel_i32 ] ];
+                level_u8 = clock_shown_frame_S.brightness_u8;
+            }
+
+            if( ( weights_u32[ LAYER_TIME ] != 0 ) && ( weights_u32[ LAYER_TIME ] < 256 ) )
+            {
+                color_S = ScaleColor( color_S, ( ( level_u8 * 255 ) / 100 * weights_u32[ LAYER_TIME ] ) >> 8 );
+                level_u8 = 100;
+            }
+
+            /* Effect layer */
+            if( weights_u32[ LAYER_EFFECT ] != 0 )
+            {
+                color_S = ScaleColor( color_S, ( level_u8 * 255 ) / 100 );
+                color_S = BlendColor( color_S, EffectShade( pixel_i32, color_S ), weights_u32[ LAYER_EFFECT ] );
+                level_u8 = 100;
+            }
+
+            /* Overlay layers */
+            for( INT32 layer = LAYER_NOTIFY; layer < NUM_LAYERS; layer++ )
+            {
+                if( ( weights_u32[ layer ] != 0 ) && ( clock_layers_S[ layer ].frame_S.bits_u64[ word ] & bit_u64 ) )
+                {
+                    color_S = ScaleColor( color_S, ( level_u8 * 255 ) / 100 );
+                    color_S = BlendColor( color_S, FrameIntensity( &clock_layers_S[ layer ].frame_S, pixel_i32 ), weights_u32[ layer ] );
+                    level_u8 = 100;
+                }
+            }
+
+            RGB_LED_SetPixelColor( pixel_i32, color_S, level_u8 );
+        }
+    }
+
+    /* The lit mask becomes the last composite, the old one is built over next time */
+    clock_lit_mask_u64 = clock_composite_mask_u64;
+    clock_composite_mask_u64 = lit_u64;
+    clock_composite_dirty_b = FALSE;
+
+    /* The driver skips the transaction when no pixel changed, and flushes
+       any changes left pending by an earlier busy transmit */
+    return RGB_LED_TransmitColors();
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      LayerApply() - "Apply a layer request"
+ *
+ * INPUTS:
+ *      request - the layer update
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void LayerApply( const CLOCK_FRAME_REQUEST* request_S )
+{
+    CLOCK_LAYER* layer_S = &clock_layers_S[ request_S->layer_E ];
+
+    if( request_S->frame_valid_b )
+    {
+        if( request_S->layer_E == LAYER_TIME )
+        {
+            AnimationStart( request_S );
+        }
+        else
+        {
+            FrameCopy( &layer_S->frame_S, &request_S->layer_S.frame_S );
+        }
+
+        /* Copied out, the requester can fill the frame again */
+        xQueueSend( q_free_frames, &request_S->frame_slot_u8, 0 );
+    }
+
+    layer_S->alpha_u8 = request_S->layer_S.alpha_u8;
+    layer_S->flash_b = request_S->layer_S.flash_b;
+    clock_composite_dirty_b = TRUE;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      timer_frame_callback() - "Frame timer callback"
+ *
+ * DESCRIPTION:
+ *      Called every frame period while the display task animates. Counts the
+ *      frame tick and wakes the display task.
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void timer_frame_callback( void* param )
+{
+    portENTER_CRITICAL( &frame_tick_lock_s );
+    frame_ticks_u32++;
+    portEXIT_CRITICAL( &frame_tick_lock_s );
+
+    xTaskNotify( h_task_display, NOTIFY_FRAME_TICK, eSetBits );
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * TASK: task_display
+ * PRIO: 3 - above the heartbeat task, bounded by CLOCK_RENDER_BUDGET_US
+ *
+ * DESCRIPTION:
+ *      Applies layer requests and composites the layers. A static face is
+ *      composited once per change. The frame timer only runs while the
+ *      composite animates (transition, effect or flashing overlay), or
+ *      while dithering (which must refresh the LEDs continuously, at
+ *      CLOCK_DITHER_PERIOD_US). If the task falls behind (several ticks
+ *      pending, or the render went over budget), the missed frames are
+ *      skipped rather than rendered late, so transitions still end on time.
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void task_display( void* params )
+{
+    CLOCK_FRAME_REQUEST request_S;
+    uint32_t notify_bits_u32;
+
+    while( 1 )
+    {
+        xTaskNotifyWait( 0, NOTIFY_FRAME_TICK | NOTIFY_NEW_FRAME | NOTIFY_EFFECT, &notify_bits_u32, portMAX_DELAY );
+
+        while( xQueueReceive( q_display_frames, &request_S, 0 ) == pdTRUE )
+        {
+            LayerApply( &request_S );
+        }
+
+        if( clock_effect_E != clock_effect_shown_E )
+        {
+            clock_effect_shown_E = clock_effect_E;
+            clock_composite_dirty_b = TRUE;
+        }
+
+        /* Frame timer only runs while something animates or dithers */
+        if( !LayersAnimated() && !RGB_LED_GetDither() )
+        {
+            esp_timer_stop( timer_handle_frame );
+            frame_timer_period_us_u32 = 0;
+            if( clock_composite_dirty_b )
+            {
+                LayersCompose();
+            }
+            /* Nothing composites again while static, so once the frames in flight
+               are done, send what a busy driver left pending (the last frame of a
+               transition, or this composite) */
+            RGB_LED_Idle();
+            if( RGB_LED_TransmitColors() == STATUS_OK )
+            {
+                RGB_LED_Idle();
+            }
+            /* Static frame, the LEDs hold it while the chip sleeps */
+            continue;
+        }
+
+        if( frame_timer_period_us_u32 != FramePeriodUs() )
+        {
+            esp_timer_stop( timer_handle_frame );
+            portENTER_CRITICAL( &frame_tick_lock_s );
+            frame_ticks_u32 = 1;
+            portEXIT_CRITICAL( &frame_tick_lock_s );
+            frame_timer_period_us_u32 = FramePeriodUs();
+            esp_timer_start_periodic( timer_handle_frame, frame_timer_period_us_u32 );
+        }
+
+        /* Collect the frame ticks since the last render */
+        UINT32 ticks_u32;
+        portENTER_CRITICAL( &frame_tick_lock_s );
+        ticks_u32 = frame_ticks_u32;
+        frame_ticks_u32 = 0;
+        portEXIT_CRITICAL( &frame_tick_lock_s );
+
+        if( ticks_u32 == 0 )
+        {
+            continue;
+        }
+
+        /* Skip the frames we were too late for */
+        clock_frame_stats_S.frames_skipped_u32 += ticks_u32 - 1;
+        clock_animation_S.frame_u32 += ticks_u32 - 1;
+
+        /* End of the transition, the time layer settles on the new frame */
+        if( clock_animation_S.active_b && ( clock_animation_S.frame_u32 >= clock_animation_S.num_frames_u32 ) )
+        {
+            clock_animation_S.active_b = FALSE;
+            FrameCopy( &clock_shown_frame_S, &clock_animation_S.to_S );
+            clock_composite_dirty_b = TRUE;
+        }
+
+        /* Effects run on wall time so they keep their speed at any frame rate */
+        INT64 start_us_i64 = esp_timer_get_time();
+        clock_effect_frame_u32 = (UINT32)( start_us_i64 / CLOCK_FRAME_PERIOD_US );
+
+        if( LayersAnimated() || clock_composite_dirty_b )
+        {
+            LayersCompose();
+        }
+        else
+        {
+            /* Dithering only, resend the same frame with the next error step */
+            RGB_LED_TransmitColors();
+        }
+        UINT32 render_us_u32 = (UINT32)( esp_timer_get_time() - start_us_i64 );
+
+        clock_animation_S.frame_u32++;
+        clock_frame_stats_S.frames_rendered_u32++;
+        clock_frame_stats_S.last_render_us_u32 = render_us_u32;
+        if( render_us_u32 > clock_frame_stats_S.max_render_us_u32 )
+        {
+            clock_frame_stats_S.max_render_us_u32 = render_us_u32;
+        }
+
+        /* Over budget, drop the next frame to give the other tasks time */
+        if( render_us_u32 > CLOCK_RENDER_BUDGET_US )
+        {
+            clock_frame_stats_S.budget_overruns_u32++;
+            clock_frame_stats_S.frames_skipped_u32++;
+            clock_animation_S.frame_u32++;
+        }
+    }
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      RequestFrameTake() - "Get a frame to send with a layer request"
+ *
+ * DESCRIPTION:
+ *      Takes one of the clock_request_frames_S for the request. The display
+ *      task gives it back once the frame is copied out, LayerRequest() when
+ *      the request is not queued.
+ *
+ * INPUTS:
+ *      request - the layer update, its frame is set up
+ *
+ * OUTPUTS:
+ *      TRUE - the request frame can be drawn into
+ *      FALSE - every frame is queued, or CLOCK_Init() was not called
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+BOOL RequestFrameTake( CLOCK_FRAME_REQUEST* request_S )
+{
+    if( ( q_free_frames == NULL ) || ( xQueueReceive( q_free_frames, &request_S->frame_slot_u8, 0 ) != pdTRUE ) )
+    {
+        return FALSE;
+    }
+
+    request_S->frame_valid_b = TRUE;
+    request_S->layer_S.frame_S = clock_request_frames_S[ request_S->frame_slot_u8 ];
+
+    return TRUE;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      LayerRequest() - "Send a layer update to the display task"
+ *
+ * INPUTS:
+ *      request - the layer update, with a frame from RequestFrameTake() if
+ *                frame_valid
+ *
+ * OUTPUTS:
+ *      TRUE - update queued
+ *      FALSE - queue full, or CLOCK_Init() was not called
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+BOOL LayerRequest( const CLOCK_FRAME_REQUEST* request_S )
+{
+    if( ( h_task_display == NULL ) || ( xQueueSend( q_display_frames, request_S, 0 ) != pdTRUE ) )
+    {
+        /* Not queued, the frame is free again */
+        if( request_S->frame_valid_b )
+        {
+            xQueueSend( q_free_frames, &request_S->frame_slot_u8, 0 );
+        }
+        return FALSE;
+    }
+
+    xTaskNotify( h_task_display, NOTIFY_NEW_FRAME, eSetBits );
+
+    return TRUE;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      ShowFrame() - "Send a frame to the time layer"
+ *
+ * INPUTS:
+ *      frame - the frame to show
+ *
+ * OUTPUTS:
+ *      TRUE - frame queued
+ *      FALSE - queue full, or CLOCK_Init() was not called
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+BOOL ShowFrame( const CLOCK_FRAME* frame_S )
+{
+    CLOCK_FRAME_REQUEST request_S;
+
+    if( !RequestFrameTake( &request_S ) )
+    {
+        return FALSE;
+    }
+
+    request_S.layer_E = LAYER_TIME;
+    FrameCopy( &request_S.layer_S.frame_S, frame_S );
+    request_S.layer_S.alpha_u8 = clock_layers_S[ LAYER_TIME ].alpha_u8;
+    request_S.layer_S.flash_b = FALSE;
+    request_S.transition_E = clock_transition_E;
+
+    return LayerRequest( &request_S );
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_ResolvePhrase() - "Place a phrase on the clock face in reading order"
+ *
+ * DESCRIPTION:
+ *      Walks the phrase once. Each word is spelled through the trie of the
+ *      active face (trie_S), whose nodes list the matching clock words in
+ *      reading order (top row first, then left to right). The first listed
+ *      word of an allowed type that starts after the end of the previous
+ *      placed word is used, which is the earliest valid placement. Words
+ *      that do not exist, or only exist before the previous word, are
+ *      reported and skipped.
+ *
+ *      Letters are matched case-insensitively. Anything that is not a
+ *      letter or a digit separates words. Only reads const tables, so it
+ *      is safe to call from any task (e.g. to validate user text).
+ *
+ * INPUTS:
+ *      phrase - phrase to place
+ *      type - the type of words to look for (can be multiple)
+ *      placement - filled with the mask of the placed words and the words
+ *                  that could not be placed
+ *
+ * OUTPUTS:
+ *      TRUE - every word of the phrase was placed
+ *      FALSE - one or more words could not be placed
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+BOOL CLOCK_ResolvePhrase( const CHAR* phrase_str, CLOCK_WORD_TYPE word_type_E, CLOCK_PHRASE_PLACEMENT* placement_S )
+{
+    const UINT16 no_node_u16 = 0xFFFF;
+    const CLOCK_FACE* face_S = clock_face_S;
+    UINT16 node_u16 = 0;
+    UINT16 next_read_u16 = 0;       /* Earliest reading position for the next word */
+    UINT8 length_u8 = 0;
+    BOOL success_b = TRUE;
+
+    memset( placement_S, 0, sizeof( CLOCK_PHRASE_PLACEMENT ) );
+
+    if( phrase_str == NULL )
+    {
+        return FALSE;
+    }
+
+    for( const CHAR* char_c = phrase_str; ; char_c++ )
+    {
+        /* Follow the trie one letter at a time */
+        if( isalnum( (UINT8)*char_c ) )
+        {
+            CHAR letter_c = tolower( (UINT8)*char_c );
+
+            if( node_u16 != no_node_u16 )
+            {
+                UINT16 child_u16 = face_S->trie_S[ node_u16 ].child_u16;
+                UINT16 steps_u16 = face_S->header_S->trie_nodes_u16;
+
+                /* A face image can link the siblings in a loop, a chain never has more nodes than the trie */
+                while( ( child_u16 != 0 ) && ( face_S->trie_S[ child_u16 ].char_c != letter_c ) && ( --steps_u16 != 0 ) )
+                {
+                    child_u16 = face_S->trie_S[ child_u16 ].sibling_u16;
+                }
+                node_u16 = ( ( child_u16 != 0 ) && ( steps_u16 != 0 ) ) ? child_u16 : no_node_u16;
+            }
+            length_u8++;
+            continue;
+        }
+
+        /* End of a word, place it after the previous one */
+        if( length_u8 != 0 )
+        {
+            BOOL placed_b = FALSE;
+
+            if( node_u16 != no_node_u16 )
+            {
+                const CLOCK_TRIE_NODE* trie_S = &face_S->trie_S[ node_u16 ];
+
+                for( UINT16 entry = trie_S->words_u16; entry < ( trie_S->words_u16 + trie_S->num_words_u8 ); entry++ )
+                {
+                    UINT8 word_u8 = face_S->trie_words_u8[ entry ];
+
+                    if( ( ( face_S->words_S[ word_u8 ].type_u8 & word_type_E ) != 0 )
+                     && ( face_S->read_start_u16[ word_u8 ] >= next_read_u16 ) )
+                    {
+                        for( INT32 word = 0; word < CLOCK_MASK_WORDS; word++ )
+                        {
+                            placement_S->mask_S.bits_u64[ word ] |= face_S->word_masks_S[ word_u8 ].bits_u64[ word ];
+                        }
+                        next_read_u16 = face_S->read_end_u16[ word_u8 ] + 1;
+                        placed_b = TRUE;
+                        break;
+                    }
+                }
+            }
+
+            if( !placed_b )
+            {
+                success_b = FALSE;
+                if( placement_S->num_words_u8 < CLOCK_PHRASE_MAX_WORDS )
+                {
+                    placement_S->unplaced_u32 |= ( 1u << placement_S->num_words_u8 );
+                }
+            }
+
+            if( placement_S->num_words_u8 < 0xFF )
+            {
+                placement_S->num_words_u8++;
+            }
+            node_u16 = 0;
+            length_u8 = 0;
+        }
+
+        if( *char_c == '\0' )
+        {
+            break;
+        }
+    }
+
+    return success_b;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * <<< LOCAL FUNCTION >>>
+ * SUMMARY:
+ *      FaceFitsLeds() - "Check a face against the LED geometry"
+ *
+ * DESCRIPTION:
+ *      A face can only be shown if each of its cells is wired to the pixel
+ *      the LED driver maps that cell to, and all its pixels are on the chain.
+ *
+ * INPUTS:
+ *      face - the face to check
+ *
+ * OUTPUTS:
+ *      TRUE - the face can be shown
+ *      FALSE - different grid or wiring
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+BOOL FaceFitsLeds( const CLOCK_FACE* face_S )
+{
+    const CLOCK_FACE_HEADER* header_S = face_S->header_S;
+
+    if( header_S->led_count_u16 > RGB_LED_GetCount() )
+    {
+        return FALSE;
+    }
+
+    for( UINT16 x = 0; x < header_S->grid_width_u8; x++ )
+    {
+        for( UINT16 y = 0; y < header_S->grid_height_u8; y++ )
+        {
+            if( face_S->xy_pixel_u8[ x * header_S->grid_height_u8 + y ] != RGB_LED_GetPixelIndex( x, y ) )
+            {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_Init() - "Start the clock display"
+ *
+ * DESCRIPTION:
+ *      Sizes the frames and pixel masks from the LED geometry, all in one
+ *      allocation, creates the frame timer and starts the display task.
+ *      RGB_LED_Init() must have been called with a geometry the compiled-in
+ *      face is wired for.
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      TRUE - display task started
+ *      FALSE - could not create the task resources, or the LED geometry
+ *          does not match the face
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+BOOL CLOCK_Init( void )
+{
+    CLOCK_FRAME* frames_S[] = {
+        &clock_shown_frame_S, &clock_next_frame_S, &clock_animation_S.from_S, &clock_animation_S.to_S,
+        &clock_layers_S[ LAYER_NOTIFY ].frame_S, &clock_layers_S[ LAYER_UI ].frame_S,
+    };
+    INT32 fixed_frames_i32 = sizeof( frames_S ) / sizeof( frames_S[ 0 ] );
+    INT32 num_frames_i32 = fixed_frames_i32 + CLOCK_REQUEST_FRAMES;
+    UINT64* words_u64;
+    UINT8* bytes_u8;
+
+    if( !FaceFitsLeds( clock_face_S ) )
+    {
+        ESP_LOGE( "CLOCK_Init()", "LED geometry does not match face \"%s\"", clock_face_S->header_S->name_c );
+        return FALSE;
+    }
+
+    clock_num_pixels_i32 = RGB_LED_GetCount();
+    clock_mask_words_i32 = ( clock_num_pixels_i32 + 63 ) / 64;
+
+    /* A mask and a color index per pixel for each frame, two more masks for the
+       composite and the word ranks. Masks first keeps the 64-bit words aligned */
+    clock_arena_p = calloc( 1, ( ( num_frames_i32 + 2 ) * clock_mask_words_i32 * sizeof( UINT64 ) )
+                             + ( ( num_frames_i32 + 1 ) * clock_num_pixels_i32 ) );
+    if( clock_arena_p == NULL )
+    {
+        ESP_LOGE( "CLOCK_Init()", "No memory for %" PRIi32 " pixels", clock_num_pixels_i32 );
+        clock_num_pixels_i32 = 0;
+        return FALSE;
+    }
+
+    words_u64 = clock_arena_p;
+    bytes_u8 = (UINT8*)&words_u64[ ( num_frames_i32 + 2 ) * clock_mask_words_i32 ];
+
+    for( INT32 frame = 0; frame < num_frames_i32; frame++ )
+    {
+        CLOCK_FRAME* frame_S = ( frame < fixed_frames_i32 ) ? frames_S[ frame ] : &clock_request_frames_S[ frame - fixed_frames_i32 ];
+
+        frame_S->bits_u64 = words_u64;
+        frame_S->color_index_u8 = bytes_u8;
+        words_u64 += clock_mask_words_i32;
+        bytes_u8 += clock_num_pixels_i32;
+    }
+    clock_composite_mask_u64 = words_u64;
+    clock_lit_mask_u64 = words_u64 + clock_mask_words_i32;
+    clock_animation_S.rank_u8 = bytes_u8;
+
+    q_display_frames = xQueueCreate( CLOCK_REQUEST_FRAMES, sizeof( CLOCK_FRAME_REQUEST ) );
+    q_free_frames = xQueueCreate( CLOCK_REQUEST_FRAMES, sizeof( UINT8 ) );
+    if( ( q_display_frames == NULL ) || ( q_free_frames == NULL ) )
+    {
+        return FALSE;
+    }
+
+    for( UINT8 slot = 0; slot < CLOCK_REQUEST_FRAMES; slot++ )
+    {
+        xQueueSend( q_free_frames, &slot, 0 );
+    }
+
+    const esp_timer_create_args_t timer_args_frame = {
+        .callback = &timer_frame_callback,
+        .name = "frame timer"
+    };
+    ESP_ERROR_CHECK( esp_timer_create( &timer_args_frame, &timer_handle_frame ) );
+
+    if( xTaskCreate( &task_display, "Display Task", 4096, NULL, 3, &h_task_display ) != pdPASS )
+    {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_SetTransition() - "Choose how new frames are animated"
+ *
+ * INPUTS:
+ *      transition - the transition used for following frames
+ *      duration - length of the transition in milliseconds (0 = cut)
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void CLOCK_SetTransition( CLOCK_TRANSITION_E transition_E, UINT32 duration_ms_u32 )
+{
+    clock_transition_E = transition_E;
+    clock_transition_ms_u32 = duration_ms_u32;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_SetEffect() - "Choose the effect shown over the clock face"
+ *
+ * DESCRIPTION:
+ *      The display task renders the effect on every frame until it is set
+ *      back to EFFECT_NONE. The effect is blended over the time layer with
+ *      the alpha of LAYER_EFFECT, see CLOCK_SetLayerAlpha().
+ *
+ * INPUTS:
+ *      effect - the effect to show
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void CLOCK_SetEffect( CLOCK_EFFECT_E effect_E )
+{
+    if( effect_E >= NUM_EFFECTS )
+    {
+        return;
+    }
+
+    clock_effect_E = effect_E;
+
+    if( h_task_display != NULL )
+    {
+        xTaskNotify( h_task_display, NOTIFY_EFFECT, eSetBits );
+    }
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_SetDither() - "Enable temporal dithering of the clock face"
+ *
+ * DESCRIPTION:
+ *      Smooths low brightness levels (night dimming, fades) by dithering
+ *      the LED output, see RGB_LED_SetDither(). While enabled the display
+ *      task refreshes the whole chain at 120 fps:
+ *      - RMT: ~3.05ms of the 8.33ms frame on the wire (~37% line usage).
+ *      - CPU: the encoder computes one 8.8 gamma value per channel instead
+ *        of a table lookup, measured by RGB_LED_Benchmark().
+ *
+ * INPUTS:
+ *      enable - TRUE = dither, FALSE = plain output
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void CLOCK_SetDither( BOOL enable_b )
+{
+    RGB_LED_SetDither( enable_b );
+
+    if( h_task_display != NULL )
+    {
+        xTaskNotify( h_task_display, NOTIFY_EFFECT, eSetBits );
+    }
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_SetFace() - "Choose the clock face words are looked up in"
+ *
+ * DESCRIPTION:
+ *      Switches to another face of CLOCK_FACE_Get() and redraws the last
+ *      displayed time with its words, using the current transition. The
+ *      faces stay mapped, so phrases already being resolved finish on the
+ *      previous face. Call from the task that calls CLOCK_UpdateTime().
+ *
+ * INPUTS:
+ *      index - the face, CLOCK_FACE_BUILTIN for the compiled-in face
+ *
+ * OUTPUTS:
+ *      TRUE - face selected
+ *      FALSE - no such face, or it is wired for other LEDs
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+BOOL CLOCK_SetFace( UINT8 index_u8 )
+{
+    const CLOCK_FACE* face_S = CLOCK_FACE_Get( index_u8 );
+
+    if( face_S == NULL )
+    {
+        return FALSE;
+    }
+
+    if( !FaceFitsLeds( face_S ) )
+    {
+        ESP_LOGW( "CLOCK_SetFace()", "Face \"%s\" does not match the LED geometry", face_S->header_S->name_c );
+        return FALSE;
+    }
+
+    clock_face_S = face_S;
+    ESP_LOGI( "CLOCK_SetFace()", "Face \"%s\" (%s)", face_S->header_S->name_c, face_S->header_S->language_c );
+
+    if( clock_time_valid_b )
+    {
+        struct tm time_S = clock_time_S;
+        CLOCK_UpdateTime( &time_S );
+    }
+
+    return TRUE;
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_SetOverlay() - "Show a phrase on an overlay layer"
+ *
+ * DESCRIPTION:
+ *      Replaces the content of LAYER_NOTIFY or LAYER_UI with the given
+ *      phrase, drawn over the time words without touching them. For example
+ *      ( LAYER_NOTIFY, "my happy bday", WORD_CUSTOM, COLOR_Pink, 255, TRUE ).
+ *
+ * INPUTS:
+ *      layer - LAYER_NOTIFY or LAYER_UI
+ *      phrase - words to light, separated by spaces
+ *      type - the type of words to look for (can be multiple)
+ *      color - the color of the words
+ *      alpha - opacity over the layers below (0 - 255)
+ *      flash - TRUE = pulse the layer
+ *
+ * OUTPUTS:
+ *      TRUE - overlay queued
+ *      FALSE - not an overlay layer, unknown word, queue full, or CLOCK_Init()
+ *          was not called
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+BOOL CLOCK_SetOverlay( CLOCK_LAYER_E layer_E, STRING phrase_str, CLOCK_WORD_TYPE word_type_E,
+    RGB_LED_DEFAULT_COLOR_E color_E, UINT8 alpha_u8, BOOL flash_b )
+{
+    CLOCK_FRAME_REQUEST request_S;
+
+    if( ( ( layer_E != LAYER_NOTIFY ) && ( layer_E != LAYER_UI ) ) || !RequestFrameTake( &request_S ) )
+    {
+        return FALSE;
+    }
+
+    request_S.layer_E = layer_E;
+    request_S.layer_S.alpha_u8 = alpha_u8;
+    request_S.layer_S.flash_b = flash_b;
+    request_S.transition_E = TRANSITION_CUT;
+
+    FrameClear( &request_S.layer_S.frame_S, 100 );
+    if( !DisplayPhrase( &request_S.layer_S.frame_S, phrase_str, word_type_E, color_E ) )
+    {
+        xQueueSend( q_free_frames, &request_S.frame_slot_u8, 0 );
+        return FALSE;
+    }
+
+    return LayerRequest( &request_S );
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_SetLayerAlpha() - "Change the opacity of a layer"
+ *
+ * DESCRIPTION:
+ *      Keeps the content of the layer. For LAYER_EFFECT the alpha is the
+ *      strength of the effect, and an alpha of 0 hides an overlay.
+ *
+ * INPUTS:
+ *      layer - the layer to change
+ *      alpha - opacity (0 - 255)
+ *      flash - TRUE = pulse the layer (overlays only)
+ *
+ * OUTPUTS:
+ *      TRUE - change queued
+ *      FALSE - invalid layer or queue full
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+BOOL CLOCK_SetLayerAlpha( CLOCK_LAYER_E layer_E, UINT8 alpha_u8, BOOL flash_b )
+{
+    CLOCK_FRAME_REQUEST request_S = { 0 };
+
+    if( layer_E >= NUM_LAYERS )
+    {
+        return FALSE;
+    }
+
+    request_S.layer_E = layer_E;
+    request_S.frame_valid_b = FALSE;
+    request_S.layer_S.alpha_u8 = alpha_u8;
+    request_S.layer_S.flash_b = flash_b && ( layer_E >= LAYER_NOTIFY );
+
+    return LayerRequest( &request_S );
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_ClearOverlay() - "Hide an overlay layer"
+ *
+ * INPUTS:
+ *      layer - LAYER_NOTIFY or LAYER_UI
+ *
+ * OUTPUTS:
+ *      TRUE - change queued
+ *      FALSE - not an overlay layer, or queue full
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+BOOL CLOCK_ClearOverlay( CLOCK_LAYER_E layer_E )
+{
+    if( ( layer_E != LAYER_NOTIFY ) && ( layer_E != LAYER_UI ) )
+    {
+        return FALSE;
+    }
+
+    return CLOCK_SetLayerAlpha( layer_E, 0, FALSE );
+}
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_GetFrameStats() - "Get the frame scheduler statistics"
+ *
+ * INPUTS:
+ *      stats - filled with the current statistics
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void CLOCK_GetFrameStats( CLOCK_FRAME_STATS* stats_S )
+{
+    *stats_S = clock_frame_stats_S;
+}
+
+BOOL CLOCK_Tick( void );
+
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_UpdateTime() - "Display the given time on the clock face"
+ *
+ * DESCRIPTION:
+ *      Looks up the mask of the current 5-minute slot and the mask of the
+ *      hour word it calls for (hour offset and word form of the slot), and
+ *      displays both. No string handling and no language rules here, the
+ *      time grammar of the face is compiled at build time (clock_grammar.py).
+ *
+ * INPUTS:
+ *      time - the time to display (only hours and minutes are used)
+ *
+ * OUTPUTS:
+ *      TRUE - displayed the time
+ *      FALSE - invalid time, or CLOCK_Init() was not called
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+BOOL CLOCK_UpdateTime( const struct tm* time_S )
+{
+    if( ( time_S == NULL ) || ( clock_arena_p == NULL )
+     || ( time_S->tm_min < 0 ) || ( time_S->tm_min > 59 )
+     || ( time_S->tm_hour < 0 ) || ( time_S->tm_hour > 23 ) )
+    {
+        return FALSE;
+    }
+
+    const CLOCK_FACE* face_S = clock_face_S;
+    UINT8 slot_u8 = time_S->tm_min / 5;
+    UINT8 hour_u8 = ( face_S->slot_hour_form_u8[ slot_u8 ] * CLOCK_NUM_HOURS )
+                  + ( ( time_S->tm_hour + face_S->slot_hour_offset_u8[ slot_u8 ] ) % CLOCK_NUM_HOURS );
+
+    clock_time_S = *time_S;
+    clock_time_valid_b = TRUE;
+
+    FrameClear( &clock_next_frame_S, 100 );
+    ColorMaskPixels( &clock_next_frame_S, &face_S->slot_masks_S[ slot_u8 ], COLOR_Mint );
+    ColorMaskPixels( &clock_next_frame_S, &face_S->hour_masks_S[ hour_u8 ], COLOR_Rose );
+
+    ShowFrame( &clock_next_frame_S );
+
+    return TRUE;
+}
+
+/* Test - cycle the words */
+BOOL CLOCK_TestWords( RGB_LED_DEFAULT_COLOR_E color_E )
+{
+    static UINT8 word_index_u8 = 0;
+    const CLOCK_FACE* face_S = clock_face_S;
+
+    if( clock_arena_p == NULL )
+    {
+        return FALSE;
+    }
+
+    if( word_index_u8 >= face_S->header_S->num_words_u8 )
+    {
+        word_index_u8 = 0;
+    }
+
+    FrameClear( &clock_next_frame_S, 100 );
+    ColorMaskPixels( &clock_next_frame_S, &face_S->word_masks_S[ word_index_u8 ], color_E );
+
+    if( ++word_index_u8 >= face_S->header_S->num_words_u8 )
+    {
+        word_index_u8 = 0;
+    }
+
+    ShowFrame( &clock_next_frame_S );
+
+    return TRUE;
+}
+
+#if CLOCK_EFFECT_BENCHMARK == 1
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~
+ * SUMMARY:
+ *      CLOCK_EffectBenchmark() - "Measure the per-frame cost of each effect"
+ *
+ * DESCRIPTION:
+ *      Shades every pixel of the active face once per effect and logs the CPU
+ *      cycles taken, next to a soft-float sinf() breathe for reference.
+ *      Nothing is written to the LEDs. Call after CLOCK_Init().
+ *
+ * INPUTS:
+ *      none
+ *
+ * OUTPUTS:
+ *      none
+ *~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+void CLOCK_EffectBenchmark( void )
+{
+    static const char* effect_names_S[ NUM_EFFECTS ] = { "none", "rainbow", "breathe", "sparkle", "gradient" };
+    const RGB_COLOR color_S = RGB_LED_default_colors_S[ COLOR_Mint ];
+    const CLOCK_FACE* face_S = clock_face_S;
+    INT32 num_pixels_i32 = face_S->header_S->led_count_u16;
+    volatile UINT32 sink_u32 = 0;
+    UINT32 start_u32;
+    UINT32 cycles_u32;
+
+    for( INT32 effect = 0; effect < NUM_EFFECTS; effect++ )
+    {
+        start_u32 = esp_cpu_get_cycle_count();
+        for( INT32 pixel = 0; pixel < num_pixels_i32; pixel++ )
+        {
+            RGB_COLOR shaded_S = clock_effects_S[ effect ]( face_S->pixel_x_u8[ pixel ], face_S->pixel_y_u8[ pixel ], pixel, color_S );
+            sink_u32 += shaded_S.r + shaded_S.g + shaded_S.b;
+        }
+        cycles_u32 = esp_cpu_get_cycle_count() - start_u32;
+
+        ESP_LOGI( "CLOCK_EffectBenchmark()", "%-8s %" PRIi32 " pixels: %" PRIu32 " cycles",
+            effect_names_S[ effect ], num_pixels_i32, cycles_u32 );
+    }
+
+    /* Reference: breathe level through libm instead of the tables */
+    start_u32 = esp_cpu_get_cycle_count();
+    for( INT32 pixel = 0; pixel < num_pixels_i32; pixel++ )
+    {
+        float level_f = 0.5f - ( 0.5f * cosf( 2.0f * (float)M_PI * (float)pixel / 256.0f ) );
+        RGB_COLOR shaded_S = ScaleColor( color_S, (UINT32)( 255.0f * ( expf( 4.0f * level_f ) - 1.0f ) / ( expf( 4.0f ) - 1.0f ) ) );
+        sink_u32 += shaded_S.r + shaded_S.g + shaded_S.b;
+    }
+    cycles_u32 = esp_cpu_get_cycle_count() - start_u32;
+
+    ESP_LOGI( "CLOCK_EffectBenchmark()", "%-8s %" PRIi32 " pixels: %" PRIu32 " cycles", "libm", num_pixels_i32, cycles_u32 );
+}
+#endif
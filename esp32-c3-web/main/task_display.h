@@ -14,16 +14,74 @@
 
 #ifndef WC_TASK_DISPLAY_H
 
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*][ Feature Switches ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+/*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
+
+#define CLOCK_EFFECT_BENCHMARK  (0) /* 1 = build CLOCK_EffectBenchmark(), 0 = unused */
+
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ Include Files ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 
 #include "rgb_rmt.h"
+#include "cfg_clock.h"
 
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ GLOBAL : Constants and Types ][~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 
+/* Animations between two clock frames */
+typedef enum{
+    TRANSITION_CUT = 0,         /* Show the new frame immediately */
+    TRANSITION_CROSSFADE,       /* Blend the whole face */
+    TRANSITION_WIPE,            /* Sweep the new frame in from the left */
+    TRANSITION_WORD_FADE,       /* Fade the new words in one at a time */
+
+    /* Number of transitions */
+    NUM_TRANSITIONS,
+} CLOCK_TRANSITION_E;
+
+/* Effects applied on top of the displayed frame */
+typedef enum{
+    EFFECT_NONE = 0,            /* Frame colors as drawn */
+    EFFECT_RAINBOW,             /* Hue wheel scrolling diagonally across the face */
+    EFFECT_BREATHE,             /* Whole face slowly fading in and out */
+    EFFECT_SPARKLE,             /* Random lit pixels briefly flash white */
+    EFFECT_GRADIENT,            /* Frame color blending into a drifting hue across the words */
+
+    /* Number of effects */
+    NUM_EFFECTS,
+} CLOCK_EFFECT_E;
+
+/* Compositor layers, bottom to top */
+typedef enum{
+    LAYER_TIME = 0,             /* Time words, with transitions */
+    LAYER_EFFECT,               /* Effect over the time words */
+    LAYER_NOTIFY,               /* Notification overlay (e.g. "my happy bday") */
+    LAYER_UI,                   /* Button feedback overlay */
+
+    /* Number of layers */
+    NUM_LAYERS,
+} CLOCK_LAYER_E;
+
+/* Result of placing a phrase on the clock face */
+#define CLOCK_PHRASE_MAX_WORDS  (32)        /* Words reported in unplaced_u32 */
+typedef struct{
+    CLOCK_PIXEL_MASK    mask_S;                 /* Pixels of the placed words */
+    UINT32              unplaced_u32;           /* Bit n = word n of the phrase was not placed */
+    UINT8               num_words_u8;           /* Words in the phrase */
+} CLOCK_PHRASE_PLACEMENT;
+
+/* Frame scheduler statistics */
+typedef struct{
+    UINT32              frames_rendered_u32;    /* Transition frames rendered */
+    UINT32              frames_skipped_u32;     /* Frames dropped to stay on time */
+    UINT32              budget_overruns_u32;    /* Renders longer than the budget */
+    UINT32              last_render_us_u32;     /* Render time of the last frame */
+    UINT32              max_render_us_u32;      /* Longest render time seen */
+} CLOCK_FRAME_STATS;
+
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*][ GLOBAL : Exportable Variables ][*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
 /*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*~*/
@@ -37,8 +95,22 @@
 
 extern BOOL CLOCK_Init( void );
 extern BOOL CLOCK_Tick( void );
-extern BOOL CLOCK_UpdateTime( void );
-extern BOOL CLOCK_TestWords( RGB_COLOR_PCT color );
+extern void CLOCK_SetTransition( CLOCK_TRANSITION_E transition_E, UINT32 duration_ms_u32 );
+extern void CLOCK_GetFrameStats( CLOCK_FRAME_STATS* stats_S );
+extern void CLOCK_SetEffect( CLOCK_EFFECT_E effect_E );
+extern void CLOCK_SetDither( BOOL enable_b );
+extern BOOL CLOCK_SetFace( UINT8 index_u8 );
+extern BOOL CLOCK_SetOverlay( CLOCK_LAYER_E layer_E, STRING phrase_str, CLOCK_WORD_TYPE word_type_E,
+    RGB_LED_DEFAULT_COLOR_E color_E, UINT8 alpha_u8, BOOL flash_b );
+extern BOOL CLOCK_SetLayerAlpha( CLOCK_LAYER_E layer_E, UINT8 alpha_u8, BOOL flash_b );
+extern BOOL CLOCK_ClearOverlay( CLOCK_LAYER_E layer_E );
+extern BOOL CLOCK_ResolvePhrase( const CHAR* phrase_str, CLOCK_WORD_TYPE word_type_E, CLOCK_PHRASE_PLACEMENT* placement_S );
+extern BOOL CLOCK_UpdateTime( const struct tm* time_S );
+extern BOOL CLOCK_TestWords( RGB_LED_DEFAULT_COLOR_E color_E );
+
+#if CLOCK_EFFECT_BENCHMARK == 1
+extern void CLOCK_EffectBenchmark( void );
+#endif
 
 /* End */
 #define WC_TASK_DISPLAY_H
@@ -0,0 +1,154 @@
+"""
+Compiles the time grammar of a clock face.
+
+The grammar is the [grammar] section of the word list. It gives the phrase
+of every 5-minute slot and the hour words:
+
+    hours[:form]  <word for 0/12> <word for 1> ... <word for 11>
+    :MM           <phrase>
+
+A phrase marks where the hour goes with {hour} (current hour) or {next}
+(upcoming hour, e.g. "twenty to {next}", "halb {next}"). A form picks
+another list of hour words for languages that change the hour word in some
+phrases, e.g. German "es ist {hour:uhr} uhr" with "hours:uhr ... ein ...".
+Words before the hour are looked up as prefixes, words after it as
+suffixes, for example:
+
+    hours      twaalf een twee drie vier vijf zes zeven acht negen tien elf
+    :00        het is {hour} uur
+    :25        het is vijf voor half {next}
+
+Each slot compiles to a list of word indexes plus the hour offset and form,
+and each hour form to one word index per hour, so the firmware shows any
+minute with one slot lookup and one hour lookup, whatever the language.
+Every minute of the day is checked while compiling: the words must exist,
+must not share a pixel and must read in order (top row first, then left to
+right), otherwise the build stops.
+"""
+
+import re
+import sys
+
+NUM_SLOTS = 12
+NUM_HOURS = 12
+DEFAULT_FORM = ""
+
+HOUR_PATTERN = re.compile(r"^\{(hour|next)(?::(\w+))?\}$")
+
+
+def fail(message):
+    print(f"clock_grammar.py: error: {message}", file=sys.stderr)
+    sys.exit(1)
+
+
+# (1) Parsing the [grammar] section, lines are (fields, where) from the word list
+def parse_grammar(lines, where):
+    hours = {}
+    slots = [None] * NUM_SLOTS
+
+    for fields, line_where in lines:
+        keyword = fields[0]
+        if keyword == "hours" or keyword.startswith("hours:"):
+            form = keyword[len("hours:"):] if ":" in keyword else DEFAULT_FORM
+            if len(fields) != NUM_HOURS + 1:
+                fail(f"{line_where}: expected {NUM_HOURS} hour words")
+            if form in hours:
+                fail(f"{line_where}: hours{':' + form if form else ''} is listed twice")
+            hours[form] = {"words": [word.lower() for word in fields[1:]], "where": line_where}
+        elif re.fullmatch(r":\d\d", keyword):
+            minute = int(keyword[1:])
+            if minute % 5 != 0 or minute > 55:
+                fail(f"{line_where}: phrases are given for :00, :05, ... :55")
+            if slots[minute // 5] is not None:
+                fail(f"{line_where}: {keyword} is listed twice")
+            slots[minute // 5] = parse_phrase(fields[1:], line_where)
+        else:
+            fail(f"{line_where}: expected \"hours[:form] <words>\" or \":MM <phrase>\"")
+
+    if DEFAULT_FORM not in hours:
+        fail(f"{where}: [grammar] has no hours line")
+    for slot, phrase in enumerate(slots):
+        if phrase is None:
+            fail(f"{where}: [grammar] has no phrase for :{slot * 5:02d}")
+        if phrase["form"] not in hours:
+            fail(f"{phrase['where']}: no hours:{phrase['form']} line")
+
+    return {"hours": hours, "slots": slots}
+
+
+def parse_phrase(tokens, where):
+    prefix, suffix, hour = [], [], None
+    for token in tokens:
+        match = HOUR_PATTERN.match(token)
+        if match:
+            if hour is not None:
+                fail(f"{where}: only one {{hour}} or {{next}} per phrase")
+            hour = match
+        elif token.startswith("{"):
+            fail(f"{where}: unknown placeholder {token}, use {{hour}} or {{next}}")
+        else:
+            (suffix if hour else prefix).append(token.lower())
+
+    if hour is None:
+        fail(f"{where}: phrase has no {{hour}} or {{next}}")
+
+    return {
+        "prefix": prefix,
+        "suffix": suffix,
+        "offset": 1 if hour.group(1) == "next" else 0,
+        "form": hour.group(2) or DEFAULT_FORM,
+        "text": " ".join(tokens),
+        "where": where,
+    }
+
+
+# (2) Resolving the grammar against the words of the face
+def find_word(words, word, word_type, where):
+    for index, (name, name_type, _) in enumerate(words):
+        if name == word and name_type == word_type:
+            return index
+    fail(f"{where}: \"{word}\" ({word_type}) is not on the clock face")
+
+
+def compile_grammar(grammar, words, read_position):
+    """
+    words: (name, "WORD_*" type, pixels) per word of the face
+    read_position: reading position of each pixel
+
+    Returns the slots as (word indexes, hour offset, form index, text), the
+    forms in table order and the hour word index of each form and hour.
+    """
+    forms = [DEFAULT_FORM] + sorted(form for form in grammar["hours"] if form != DEFAULT_FORM)
+    hour_words = [[find_word(words, word, "WORD_HOUR", grammar["hours"][form]["where"])
+                   for word in grammar["hours"][form]["words"]] for form in forms]
+
+    slots = []
+    for phrase in grammar["slots"]:
+        slot_words = ([find_word(words, word, "WORD_PREFIX", phrase["where"]) for word in phrase["prefix"]]
+                      + [find_word(words, word, "WORD_SUFFIX", phrase["where"]) for word in phrase["suffix"]])
+        slots.append((slot_words, phrase["offset"], forms.index(phrase["form"]), phrase["text"]))
+
+    # Every minute of the day, as the firmware will show it
+    for minute in range(24 * 60):
+        phrase = grammar["slots"][(minute % 60) // 5]
+        slot_words, offset, form, _ = slots[(minute % 60) // 5]
+        hour = hour_words[form][(minute // 60 + offset) % NUM_HOURS]
+        shown = slot_words[:len(phrase["prefix"])] + [hour] + slot_words[len(phrase["prefix"]):]
+        check_minute(words, shown, read_position, f"{phrase['where']}: {minute // 60:02d}:{minute % 60:02d}")
+
+    return slots, forms, hour_words
+
+
+def check_minute(words, shown, read_position, where):
+    lit = set()
+    previous_end = -1
+    for index in shown:
+        name, _, pixels = words[index]
+        if lit & set(pixels):
+            fail(f"{where}: \"{name}\" shares a letter with another word of the phrase")
+        lit |= set(pixels)
+
+        start = min(read_position[p] for p in pixels)
+        if start <= previous_end:
+            fail(f"{where}: \"{name}\" does not read after the word before it")
+        previous_end = max(read_position[p] for p in pixels)
@@ -0,0 +1,178 @@
+"""
+Packs clock faces into a binary image for the "faces" flash partition.
+
+Every face is compiled from a character layout and a word list, in the same
+way as the built-in face (gen_clock_layout.py, gen_clock_masks.py), and
+written with the same tables the firmware uses: word table, per-word, slot
+and hour masks compiled from the time grammar of the word list, grid to
+LED maps, perfect hash, spelling trie and reading positions. Faces in other
+languages only need their own layout and word list. The firmware memory-maps the partition and reads the tables in
+place, see clock_face.c.
+
+Image layout (little endian, offsets in bytes):
+    image header    magic "WCFC", version, face count, image size, CRC-32
+                    of everything after the header
+    directory       offset of each face from the start of the image
+    faces           CLOCK_FACE_HEADER followed by its tables, table offsets
+                    are from the start of the face, 8-byte aligned
+
+The C structures are in clock_face.h and must match the formats below.
+
+Usage: python gen_clock_faces.py <rgb_rmt.h> <output.bin> <layout.txt> <words.txt> [<layout.txt> <words.txt> ...]
+"""
+
+import os
+import re
+import struct
+import sys
+import zlib
+
+import gen_clock_layout as layout
+import gen_clock_masks as masks
+
+IMAGE_MAGIC = b"WCFC"
+IMAGE_VERSION = 2
+IMAGE_HEADER = struct.Struct("<4sHHII")         # CLOCK_FACE_IMAGE_HEADER
+FACE_HEADER = struct.Struct("<16s8sIHBBBBBBBBHHHHHHH17I")  # CLOCK_FACE_HEADER
+FACE_WORD = struct.Struct("<HHBB")              # CLOCK_FACE_WORD
+TRIE_NODE = struct.Struct("<cxHHHBx")           # CLOCK_TRIE_NODE
+ALIGNMENT = 8
+
+# Table order of CLOCK_FACE_TABLE_E
+TABLES = (
+    "words", "names", "pixels", "xy_pixel", "pixel_x", "pixel_y", "word_masks", "slot_masks",
+    "slot_hour_offset", "slot_hour_form", "hour_masks", "hash_seed", "hash_slot", "trie", "trie_words",
+    "read_start", "read_end",
+)
+
+LED_TYPE_PATTERN = re.compile(r"typedef\s+enum\s*\{([^}]*)\}\s*RGB_LED_TYPE_E\s*;")
+
+
+def fail(message):
+    print(f"gen_clock_faces.py: error: {message}", file=sys.stderr)
+    sys.exit(1)
+
+
+def parse_led_types(header_path):
+    with open(header_path, "r") as f:
+        match = LED_TYPE_PATTERN.search(f.read())
+    if not match:
+        fail(f"RGB_LED_TYPE_E not found in {header_path}")
+
+    names = [entry.split("=")[0].strip() for entry in match.group(1).split(",")]
+    return {name: value for value, name in enumerate(n for n in names if n)}
+
+
+def pad(data):
+    return data + bytes(-len(data) % ALIGNMENT)
+
+
+def pack_masks(mask_list, mask_words):
+    return b"".join(mask.to_bytes(8 * mask_words, "little") for mask in mask_list)
+
+
+# (1) Compiling one face into its tables
+def build_face(layout_path, words_path, led_types):
+    config, xy, placed, _ = layout.compile_layout(layout_path, words_path)
+    width, height = len(xy), len(xy[0])
+    led_count = width * height
+    mask_words = (led_count + 63) // 64
+
+    if config["led_type"] not in led_types:
+        fail(f"{words_path}: unknown led_type {config['led_type']}")
+    for key, limit in (("name", 15), ("language", 7)):
+        if not config[key] or len(config[key]) > limit:
+            fail(f"{words_path}: {key} must be 1 to {limit} characters")
+
+    types = {name: value for name, value, _ in layout.WORD_TYPES.values()}
+    words = [(word, layout.WORD_TYPES[word_type][0], pixels) for word, word_type, pixels, _ in placed]
+    read_position = masks.grid_read_positions(xy)
+    seeds, slots = masks.build_hash(words, types)
+    nodes, trie_words = masks.build_trie(words, read_position)
+    word_table, names, pixels = masks.face_word_table(words)
+    time = masks.compile_time(config["grammar"], words_path, words, read_position)
+
+    pixel_x = [0] * led_count
+    pixel_y = [0] * led_count
+    for x in range(width):
+        for y in range(height):
+            pixel_x[xy[x][y]] = x
+            pixel_y[xy[x][y]] = y
+
+    tables = {
+        "words": b"".join(FACE_WORD.pack(name, first, length, types[word_type])
+                          for name, first, length, word_type in word_table),
+        "names": names,
+        "pixels": bytes(pixels),
+        "xy_pixel": bytes(p for column in xy for p in column),
+        "pixel_x": bytes(pixel_x),
+        "pixel_y": bytes(pixel_y),
+        "word_masks": pack_masks([masks.word_mask(w[2]) for w in words], mask_words),
+        "slot_masks": pack_masks(time["slot_masks"], mask_words),
+        "slot_hour_offset": bytes(offset for _, offset, _, _ in time["slots"]),
+        "slot_hour_form": bytes(form for _, _, form, _ in time["slots"]),
+        "hour_masks": pack_masks(time["hour_masks"], mask_words),
+        "hash_seed": b"".join(struct.pack("<H", seed) for seed in seeds),
+        "hash_slot": bytes(slots),
+        "trie": b"".join(TRIE_NODE.pack(node["char"].encode("ascii") or b"\0", node["child"], node["sibling"],
+                                        node["first_word"], len(node["words"])) for node in nodes),
+        "trie_words": bytes(trie_words),
+        "read_start": b"".join(struct.pack("<H", min(read_position[p] for p in w[2])) for w in words),
+        "read_end": b"".join(struct.pack("<H", max(read_position[p] for p in w[2])) for w in words),
+    }
+
+    # Tables follow the header, each one aligned for its widest element
+    body = pad(bytes(FACE_HEADER.size))
+    offsets = []
+    for name in TABLES:
+        offsets.append(len(body))
+        body = pad(body + tables[name])
+
+    header = FACE_HEADER.pack(
+        config["name"].encode("ascii"), config["language"].encode("ascii"), len(body),
+        led_count, width, height, led_types[config["led_type"]], mask_words, len(words),
+        len(time["slots"]), len(time["hour_masks"]) // len(time["forms"]), len(time["forms"]),
+        len(seeds), len(slots), len(nodes), len(trie_words), len(names), len(pixels), 0,
+        *offsets)
+
+    return config["name"], header + body[FACE_HEADER.size:]
+
+
+# (2) Writing the image
+def build_image(faces):
+    directory_size = len(pad(bytes(IMAGE_HEADER.size + 4 * len(faces)))) - IMAGE_HEADER.size
+    offsets = []
+    position = IMAGE_HEADER.size + directory_size
+    for face in faces:
+        offsets.append(position)
+        position += len(face)
+
+    directory = struct.pack(f"<{len(faces)}I", *offsets)
+    payload = directory + bytes(directory_size - len(directory)) + b"".join(faces)
+    header = IMAGE_HEADER.pack(IMAGE_MAGIC, IMAGE_VERSION, len(faces), IMAGE_HEADER.size + len(payload),
+                               zlib.crc32(payload))
+    return header + payload
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 5 or len(sys.argv) % 2 != 1:
+        fail("usage: gen_clock_faces.py <rgb_rmt.h> <output.bin> <layout.txt> <words.txt> [...]")
+
+    led_type_values = parse_led_types(sys.argv[1])
+    out_path = sys.argv[2]
+    os.makedirs(os.path.dirname(os.path.abspath(out_path)), exist_ok=True)
+
+    face_list = []
+    face_names = set()
+    for layout_file, words_file in zip(sys.argv[3::2], sys.argv[4::2]):
+        face_name, face = build_face(layout_file, words_file, led_type_values)
+        if face_name in face_names:
+            fail(f"{words_file}: face \"{face_name}\" is listed twice")
+        face_names.add(face_name)
+        face_list.append(face)
+
+    image = build_image(face_list)
+    with open(out_path, "wb") as f:
+        f.write(image)
+
+    print(f"gen_clock_faces.py: {len(face_list)} face(s), {len(image)} bytes")
@@ -0,0 +1,317 @@
+"""
+Compiles the clock face layout into the firmware clock configuration.
+
+Reads the character layout used for the mechanical clock body
+(mechanical/make_clock_body_characters.txt) and the word list of the
+firmware (main/cfg_clock_words.txt), finds every word on the face, and
+writes cfg_clock.c / cfg_clock.h with:
+    - the word table (CLOCK_words_S) with the LED index of every letter
+    - the grid to LED map (CLOCK_xy_pixel_u8) from the LED chain wiring
+    - the inverse LED to grid maps (CLOCK_pixel_x_u8, CLOCK_pixel_y_u8)
+    - the LED geometry (WC_RGB_LED_*) the driver is initialized with
+
+Words sharing a letter are reported as overlap diagnostics. Missing or
+ambiguous words stop the build.
+
+Usage: python gen_clock_layout.py <layout.txt> <words.txt> <output directory>
+"""
+
+import os
+import sys
+
+# Word list keywords for the CLOCK_WORD_TYPE values: (enum name, value, table comment)
+WORD_TYPES = {
+    "prefix": ("WORD_PREFIX", 0x01, "prefixes"),
+    "custom": ("WORD_CUSTOM", 0x02, "custom"),
+    "hour":   ("WORD_HOUR",   0x04, "hours"),
+    "suffix": ("WORD_SUFFIX", 0x08, "suffixes"),
+}
+
+# Default settings, overridden by the [settings] section of the word list
+DEFAULT_SETTINGS = {
+    "led_pin": "7",
+    "led_type": "LED_WS2812B_V1",
+    "wiring": "columns serpentine bottom-right",
+    "leds_per_cell": "1",
+    "led_backend": "rmt",
+    "power_budget_ma": "800",
+    "rtc_int_pin": "none",
+    "name": "default",
+    "language": "en",
+}
+
+CORNERS = ("bottom-right", "bottom-left", "top-right", "top-left")
+
+
+def fail(message):
+    print(f"gen_clock_layout.py: error: {message}", file=sys.stderr)
+    sys.exit(1)
+
+
+def note(message):
+    print(f"gen_clock_layout.py: note: {message}")
+
+
+# (1) Parsing the input files
+def parse_layout(layout_path):
+    with open(layout_path, "r") as f:
+        lines = [line.strip() for line in f.readlines()]
+
+    if "<BEGIN>" not in lines or "<END>" not in lines:
+        fail(f"{layout_path} has no <BEGIN> ... <END> section")
+
+    rows = [line.lower().split() for line in lines[lines.index("<BEGIN>") + 1:lines.index("<END>")]]
+    if not rows or any(len(row) != len(rows[0]) for row in rows):
+        fail(f"{layout_path} is not a rectangular grid of characters")
+
+    return rows
+
+
+def parse_words(words_path):
+    settings = dict(DEFAULT_SETTINGS)
+    words = []
+    grammar = []
+    section = "words"
+
+    with open(words_path, "r") as f:
+        for number, line in enumerate(f.readlines(), start=1):
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            if line.startswith("[") and line.endswith("]"):
+                section = line[1:-1].strip()
+                continue
+
+            fields = line.split()
+            where = f"{words_path}:{number}"
+            if section == "settings":
+                settings[fields[0]] = " ".join(fields[1:])
+            elif section == "words":
+                if fields[0] not in WORD_TYPES or len(fields) not in (2, 3):
+                    fail(f"{where}: expected \"<{'|'.join(WORD_TYPES)}> <word> [@row[,column]]\"")
+                position = None
+                if len(fields) == 3:
+                    if not fields[2].startswith("@"):
+                        fail(f"{where}: position must look like @row or @row,column")
+                    position = [int(p) for p in fields[2][1:].split(",")]
+                words.append((fields[1].lower(), fields[0], position, where))
+            elif section == "grammar":
+                grammar.append((fields, where))
+            else:
+                fail(f"{where}: unknown section [{section}]")
+
+    return settings, words, grammar
+
+
+# (2) Placing the words, rows are numbered from the top, words read left to right
+def find_word(rows, word, position, where):
+    found = []
+    for row, letters in enumerate(rows):
+        for column in range(len(letters) - len(word) + 1):
+            if "".join(letters[column:column + len(word)]) == word:
+                found.append((row, column))
+
+    if position is not None:
+        found = [f for f in found if list(f[:len(position)]) == position]
+    if not found:
+        fail(f"{where}: \"{word}\" is not on the face" + (f" at @{position}" if position else ""))
+    if len(found) > 1:
+        places = ", ".join(f"@{r},{c}" for r, c in found)
+        fail(f"{where}: \"{word}\" is on the face more than once ({places}), add one of them")
+
+    return found[0]
+
+
+# (3) Numbering the LED chain
+def wire_chain(width, height, wiring, where):
+    fields = wiring.split()
+    if (len(fields) != 3 or fields[0] not in ("columns", "rows")
+            or fields[1] not in ("serpentine", "progressive") or fields[2] not in CORNERS):
+        fail(f"{where}: wiring must be \"<columns|rows> <serpentine|progressive> <{'|'.join(CORNERS)}>\"")
+    order, pattern, corner = fields
+
+    # Grid coordinates: x = 0 is the left column, y = 0 is the bottom row
+    xs = list(range(width)) if corner.endswith("left") else list(reversed(range(width)))
+    ys = list(range(height)) if corner.startswith("bottom") else list(reversed(range(height)))
+    outer, inner = (xs, ys) if order == "columns" else (ys, xs)
+
+    xy_pixel = [[0] * height for _ in range(width)]
+    pixel = 0
+    for line, a in enumerate(outer):
+        run = inner if (pattern == "progressive" or line % 2 == 0) else list(reversed(inner))
+        for b in run:
+            x, y = (a, b) if order == "columns" else (b, a)
+            xy_pixel[x][y] = pixel
+            pixel += 1
+
+    return xy_pixel
+
+
+# Geometry macros of the driver (RGB_LED_GEOMETRY) for the wiring
+def geometry_macros(settings):
+    order, pattern, corner = settings["wiring"].split()
+    pins = settings["led_pin"].split()
+    return {
+        "WC_RGB_LED_BACKEND": "LED_BACKEND_" + settings["led_backend"].upper(),
+        "WC_RGB_LED_STRIPS": str(len(pins)),
+        "WC_RGB_LED_STRIP_PINS": "{ " + ", ".join(pins) + " }",
+        "WC_RGB_LEDS_PER_CELL": settings["leds_per_cell"],
+        "WC_RGB_LED_MAP": "LED_MAP_SERPENTINE" if pattern == "serpentine" else "LED_MAP_PROGRESSIVE",
+        "WC_RGB_LED_COLUMNS": "TRUE" if order == "columns" else "FALSE",
+        "WC_RGB_LED_START_RIGHT": "TRUE" if corner.endswith("right") else "FALSE",
+        "WC_RGB_LED_START_TOP": "TRUE" if corner.startswith("top") else "FALSE",
+    }
+
+
+# (4) Writing the configuration
+def write_header(path, settings, width, height, max_length):
+    mask_words = (width * height + 63) // 64
+    with open(path, "w") as f:
+        f.write("/* Auto-generated header file for clock configuration, do not edit */\n")
+        f.write("/* Source: the clock layout and word list, see tools/gen_clock_layout.py */\n\n")
+        f.write("#ifndef AUTOGEN_CONFIG_CLOCK_H\n\n")
+        f.write("#include \"rgb_rmt.h\"\n")
+        f.write("#include \"time.h\"\n\n")
+        f.write(f"#define MAX_WORD_LENGTH ({max_length})\n")
+        f.write(f"#define CLOCK_MASK_WORDS ({mask_words})    /* 64-bit words per packed pixel mask */\n\n")
+        f.write("typedef enum{\n")
+        entries = sorted(WORD_TYPES.values(), key=lambda t: t[1])
+        for number, (name, value, _) in enumerate(entries):
+            f.write(f"    {name:<20}= 0x{value:02X}{',' if number < len(entries) - 1 else ''}\n")
+        f.write("} CLOCK_WORD_TYPE;\n\n")
+        f.write("typedef struct{\n")
+        f.write("    STRING              word_str;\n")
+        f.write("    UINT8               word_length_u8;\n")
+        f.write("    CLOCK_WORD_TYPE     word_type_E;\n")
+        f.write("    UINT8               word_pixels_u8[ MAX_WORD_LENGTH ];\n")
+        f.write("} CLOCK_WORD;\n\n")
+        f.write("/* Packed pixel mask, bit N set = pixel N lit */\n")
+        f.write("typedef struct{\n")
+        f.write("    UINT64              bits_u64[ CLOCK_MASK_WORDS ];\n")
+        f.write("} CLOCK_PIXEL_MASK;\n\n")
+        f.write("typedef struct{\n")
+        f.write("    struct tm           last_time_s;\n")
+        f.write("} CLOCK_CONFIG;\n\n")
+        f.write("extern const CLOCK_WORD     CLOCK_words_S[];\n")
+        f.write("extern const UINT8          CLOCK_num_words_u8;\n")
+        f.write(f"#define CLOCK_GRID_WIDTH    ({width})\n")
+        f.write(f"#define CLOCK_GRID_HEIGHT   ({height})\n\n")
+        f.write("extern const UINT8          CLOCK_xy_pixel_u8[ CLOCK_GRID_WIDTH ][ CLOCK_GRID_HEIGHT ];   /* [x][y], y = 0 is the bottom row */\n")
+        f.write("extern const UINT8          CLOCK_pixel_x_u8[];    /* Column of each pixel (0 = left) */\n")
+        f.write("extern const UINT8          CLOCK_pixel_y_u8[];    /* Row of each pixel (0 = bottom) */\n\n")
+        f.write(f"#define WC_RGB_LED_PIN      ({settings['led_pin'].split()[0]})\n")
+        f.write(f"#define WC_RGB_LED_COUNT    ({width * height})    /* Pixels, one per grid cell */\n")
+        f.write(f"#define WC_RGB_LED_TYPE     ({settings['led_type']})\n")
+        f.write(f"#define WC_RGB_LED_POWER_MA ({settings['power_budget_ma']})    /* LED current budget, 0 = unlimited */\n")
+        rtc_int_pin = "-1" if settings["rtc_int_pin"] == "none" else settings["rtc_int_pin"]
+        f.write(f"#define WC_RTC_INT_PIN      ({rtc_int_pin})    /* GPIO on the RTC ~INTA, -1 = not wired, the RTC is polled */\n")
+        for name, value in geometry_macros(settings).items():
+            f.write(f"#define {name:<23}{value if value.startswith('{') else f'({value})'}\n")
+        f.write("\n")
+        f.write(f"#define CLOCK_FACE_NAME     \"{settings['name']}\"\n")
+        f.write(f"#define CLOCK_FACE_LANGUAGE \"{settings['language']}\"\n\n")
+        f.write("#define AUTOGEN_CONFIG_CLOCK_H\n")
+        f.write("#endif\n")
+
+
+def write_source(path, placed, xy_pixel, overlaps):
+    width, height = len(xy_pixel), len(xy_pixel[0])
+    with open(path, "w") as f:
+        f.write("/* Auto-generated source file for clock configuration, do not edit */\n")
+        f.write("/* Source: the clock layout and word list, see tools/gen_clock_layout.py */\n\n")
+        f.write("#include \"cfg_clock.h\"\n\n")
+
+        f.write("const CLOCK_WORD CLOCK_words_S[] = {\n")
+        last_type = None
+        for number, (word, word_type, pixels, _) in enumerate(placed):
+            if word_type != last_type:
+                if last_type is not None:
+                    f.write("\n")
+                f.write(f"    /* Type - {WORD_TYPES[word_type][2]} */\n")
+                last_type = word_type
+            name = f"\"{word}\","
+            separator = "," if number < len(placed) - 1 else ""
+            f.write(f"    {{ {name:<13} {len(word)}, {WORD_TYPES[word_type][0] + ',':<12} "
+                    f"{{{', '.join(str(p) for p in pixels)}}} }}{separator}\n")
+        f.write("};\n\n")
+        f.write("const UINT8 CLOCK_num_words_u8 = ( sizeof( CLOCK_words_S ) / sizeof( CLOCK_WORD ) );\n\n")
+
+        if overlaps:
+            f.write("/* Letters shared between words:\n")
+            for line in overlaps:
+                f.write(f" *  {line}\n")
+            f.write(" */\n\n")
+
+        f.write("const UINT8 CLOCK_xy_pixel_u8[ CLOCK_GRID_WIDTH ][ CLOCK_GRID_HEIGHT ] = {\n")
+        for column in xy_pixel:
+            f.write("    { " + ", ".join(f"{p:2d}u" for p in column) + " },\n")
+        f.write("};\n\n")
+
+        pixel_x = [0] * (width * height)
+        pixel_y = [0] * (width * height)
+        for x in range(width):
+            for y in range(height):
+                pixel_x[xy_pixel[x][y]] = x
+                pixel_y[xy_pixel[x][y]] = y
+        for name, values in (("CLOCK_pixel_x_u8", pixel_x), ("CLOCK_pixel_y_u8", pixel_y)):
+            f.write(f"const UINT8 {name}[ WC_RGB_LED_COUNT ] = {{\n")
+            for start in range(0, len(values), width):
+                f.write("    " + ", ".join(f"{v}u" for v in values[start:start + width]) + ",\n")
+            f.write("};\n\n")
+
+
+# (5) Compiling one face
+def compile_layout(layout_path, words_path):
+    layout = parse_layout(layout_path)
+    config, word_list, grammar = parse_words(words_path)
+    grid_width, grid_height = len(layout[0]), len(layout)
+    if grid_width * grid_height > 256:
+        fail(f"{grid_width}x{grid_height} pixels do not fit the 8-bit LED indexes")
+    leds_per_cell = config["leds_per_cell"]
+    if not leds_per_cell.isdigit() or not 1 <= int(leds_per_cell) <= 255:
+        fail(f"{words_path}: leds_per_cell must be 1 - 255")
+    if not config["led_pin"] or not all(pin.isdigit() for pin in config["led_pin"].split()):
+        fail(f"{words_path}: led_pin must be one GPIO number per LED strip")
+    if config["led_backend"] not in ("rmt", "spi"):
+        fail(f"{words_path}: led_backend must be rmt or spi")
+    if not config["power_budget_ma"].isdigit():
+        fail(f"{words_path}: power_budget_ma must be a current in mA, 0 = unlimited")
+    if config["rtc_int_pin"] != "none" and not config["rtc_int_pin"].isdigit():
+        fail(f"{words_path}: rtc_int_pin must be a GPIO number, or none")
+    xy = wire_chain(grid_width, grid_height, config["wiring"], words_path)
+
+    # Place every word, and note letters shared with an earlier word
+    placed = []
+    owners = {}
+    overlap_notes = []
+    for word, word_type, position, where in word_list:
+        row, column = find_word(layout, word, position, where)
+        y = grid_height - 1 - row
+        pixels = [xy[column + i][y] for i in range(len(word))]
+        for i, pixel in enumerate(pixels):
+            for other in owners.get(pixel, []):
+                overlap_notes.append(f"\"{other}\" and \"{word}\" share '{word[i]}' "
+                                     f"at @{row},{column + i} (pixel {pixel})")
+            owners.setdefault(pixel, []).append(word)
+        placed.append((word, word_type, pixels, where))
+
+    # The time grammar is compiled with the masks, see clock_grammar.py
+    config["grammar"] = grammar
+
+    return config, xy, placed, overlap_notes
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 4:
+        fail("usage: gen_clock_layout.py <layout.txt> <words.txt> <output directory>")
+
+    layout_path, words_path, out_dir = sys.argv[1], sys.argv[2], sys.argv[3]
+    os.makedirs(out_dir, exist_ok=True)
+
+    config, xy, placed, overlap_notes = compile_layout(layout_path, words_path)
+    for line in overlap_notes:
+        note(line)
+
+    write_header(os.path.join(out_dir, "cfg_clock.h"), config, len(xy), len(xy[0]),
+                 max(len(w[0]) for w in placed))
+    write_source(os.path.join(out_dir, "cfg_clock.c"), placed, xy, overlap_notes)
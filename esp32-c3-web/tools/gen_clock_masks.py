@@ -0,0 +1,418 @@
+"""
+Generates flash-resident pixel mask tables from the clock configuration.
+
+Reads the word table (CLOCK_words_S) from cfg_clock.c and compiles the time
+grammar of the word list (see clock_grammar.py) into a packed pixel mask
+for every 5-minute time slot and every hour word, so the firmware can
+display the time with two mask lookups instead of parsing phrases at
+runtime, whatever the language of the face.
+
+Also emits a collision-free (perfect) hash over the (word, type) pairs, so
+DisplayWord() finds any word with one hash and one strcmp. The word types
+are read from cfg_clock.h, next to cfg_clock.c.
+
+Finally emits a trie over the word spellings. Each trie node lists the words
+ending there sorted in reading order (top row first, then left to right,
+from CLOCK_xy_pixel_u8), for the phrase resolver in task_display.c.
+
+The word table is also written without pointers (CLOCK_face_words_S), in the
+layout clock face images use, so the built-in face and the faces loaded from
+flash are read the same way (see gen_clock_faces.py).
+
+Usage: python gen_clock_masks.py <path/to/cfg_clock.c> <words.txt> <output directory>
+"""
+
+import os
+import re
+import sys
+
+import clock_grammar
+import gen_clock_layout
+
+# Number of 64-bit words in a packed pixel mask, read from cfg_clock.h
+MASK_WORDS = 2
+MASK_WORDS_PATTERN = re.compile(r"#define\s+CLOCK_MASK_WORDS\s+\(\s*(\d+)\s*\)")
+
+XY_PATTERN = re.compile(r'\{([\d\su,]+)\}')
+TYPE_PATTERN = re.compile(r'(WORD_\w+)\s*=\s*(0x[0-9A-Fa-f]+|\d+)')
+
+# Perfect hash search limits
+HASH_SEED_LIMIT = 0x10000
+HASH_EMPTY = 0xFF
+
+WORD_PATTERN = re.compile(
+    r'\{\s*"(\w+)"\s*,\s*(\d+)\s*,\s*(WORD_\w+)\s*,\s*\{([^}]*)\}\s*\}'
+)
+
+
+def fail(message):
+    print(f"gen_clock_masks.py: error: {message}", file=sys.stderr)
+    sys.exit(1)
+
+
+# (1) Parsing the word table from the configuration source
+def parse_words(cfg_path):
+    with open(cfg_path, "r") as f:
+        source = f.read()
+
+    start = source.find("CLOCK_words_S[]")
+    if start < 0:
+        fail(f"CLOCK_words_S not found in {cfg_path}")
+    end = source.find("};", start)
+
+    words = []
+    for match in WORD_PATTERN.finditer(source[start:end]):
+        word, length, word_type, pixels = match.groups()
+        pixels = [int(p) for p in pixels.replace(" ", "").split(",") if p]
+        if len(pixels) != int(length):
+            fail(f"\"{word}\" declares {length} pixels but lists {len(pixels)}")
+        words.append((word, word_type, pixels))
+
+    if not words:
+        fail(f"no words parsed from {cfg_path}")
+
+    return words
+
+
+def parse_grid(cfg_path):
+    with open(cfg_path, "r") as f:
+        source = f.read()
+
+    start = source.find("CLOCK_xy_pixel_u8")
+    if start < 0:
+        fail(f"CLOCK_xy_pixel_u8 not found in {cfg_path}")
+    end = source.find("};", start)
+
+    # Rows of the table are x, entries within a row are y (0 = bottom)
+    columns = []
+    for match in XY_PATTERN.finditer(source[start:end]):
+        columns.append([int(p.strip().rstrip("u")) for p in match.group(1).split(",") if p.strip()])
+    if not columns or any(len(c) != len(columns[0]) for c in columns):
+        fail(f"CLOCK_xy_pixel_u8 in {cfg_path} is not a rectangular grid")
+
+    return grid_read_positions(columns)
+
+
+def grid_read_positions(columns):
+    # Reading position of each pixel: row from the top * width + x
+    width, height = len(columns), len(columns[0])
+    read_position = {}
+    for x, column in enumerate(columns):
+        for y, pixel in enumerate(column):
+            read_position[pixel] = (height - 1 - y) * width + x
+
+    return read_position
+
+
+def parse_types(header_path):
+    with open(header_path, "r") as f:
+        source = f.read()
+
+    types = {name: int(value, 0) for name, value in TYPE_PATTERN.findall(source)}
+    if not types:
+        fail(f"no CLOCK_WORD_TYPE values parsed from {header_path}")
+
+    mask_words = MASK_WORDS_PATTERN.search(source)
+    if not mask_words:
+        fail(f"no CLOCK_MASK_WORDS parsed from {header_path}")
+
+    return types, int(mask_words.group(1))
+
+
+def word_mask(pixels):
+    mask = 0
+    for pixel in pixels:
+        mask |= 1 << pixel
+    return mask
+
+
+# (2) Compiling the time grammar into slot and hour masks
+def compile_time(lines, words_path, words, read_position):
+    grammar = clock_grammar.parse_grammar(lines, words_path)
+    slots, forms, hour_words = clock_grammar.compile_grammar(grammar, words, read_position)
+
+    slot_masks = []
+    for slot_words, _, _, _ in slots:
+        mask = 0
+        for index in slot_words:
+            mask |= word_mask(words[index][2])
+        slot_masks.append(mask)
+
+    # Hour masks of every form one after the other, CLOCK_NUM_HOURS per form
+    hour_masks = [word_mask(words[index][2]) for form in hour_words for index in form]
+
+    return {
+        "slots": slots,
+        "forms": forms,
+        "hour_words": hour_words,
+        "slot_masks": slot_masks,
+        "hour_masks": hour_masks,
+    }
+
+
+# (3) Building the perfect hash, must match WordHash() in task_display.c
+def hash_key(word, type_value):
+    # FNV-1a over the word, then the type
+    h = 0x811C9DC5
+    for byte in word.encode("ascii") + bytes([type_value]):
+        h = ((h ^ byte) * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+def hash_slot(key, seed, num_slots):
+    h = ((key ^ seed) * 0x9E3779B1) & 0xFFFFFFFF
+    h ^= h >> 16
+    return h & (num_slots - 1)
+
+
+def next_pow2(value):
+    power = 1
+    while power < value:
+        power <<= 1
+    return power
+
+
+def build_hash(words, types):
+    # Hash and displace: keys go into buckets, each bucket gets a seed
+    # that sends all of its keys to free slots
+    num_slots = next_pow2(len(words) + (len(words) >> 2))
+    num_buckets = max(1, num_slots >> 2)
+    if len(words) >= HASH_EMPTY:
+        fail(f"{len(words)} words do not fit an 8-bit hash slot table")
+
+    keys = {}
+    for index, (word, word_type, _) in enumerate(words):
+        key = hash_key(word, types[word_type])
+        if (word, word_type) in keys:
+            fail(f"\"{word}\" ({word_type}) is listed twice")
+        keys[(word, word_type)] = (index, key)
+
+    buckets = [[] for _ in range(num_buckets)]
+    for index, key in keys.values():
+        buckets[key & (num_buckets - 1)].append((index, key))
+
+    seeds = [0] * num_buckets
+    slots = [HASH_EMPTY] * num_slots
+    for bucket in sorted(range(num_buckets), key=lambda b: -len(buckets[b])):
+        if not buckets[bucket]:
+            continue
+        for seed in range(HASH_SEED_LIMIT):
+            chosen = [hash_slot(key, seed, num_slots) for _, key in buckets[bucket]]
+            if len(set(chosen)) == len(chosen) and all(slots[c] == HASH_EMPTY for c in chosen):
+                break
+        else:
+            fail(f"no perfect hash seed found for bucket {bucket}")
+        seeds[bucket] = seed
+        for (index, _), slot in zip(buckets[bucket], chosen):
+            slots[slot] = index
+
+    return seeds, slots
+
+
+# (4) Building the spelling trie, node 0 is the root
+def build_trie(words, read_position):
+    nodes = [{"char": "", "children": {}, "words": []}]
+    for index, (word, _, pixels) in enumerate(words):
+        node = 0
+        for char in word:
+            if char not in nodes[node]["children"]:
+                nodes.append({"char": char, "children": {}, "words": []})
+                nodes[node]["children"][char] = len(nodes) - 1
+            node = nodes[node]["children"][char]
+        nodes[node]["words"].append(index)
+
+    for node in nodes:
+        node["words"].sort(key=lambda i: min(read_position[p] for p in words[i][2]))
+
+    # Link children and siblings in alphabetical order, and list the words of
+    # every node one after another
+    word_lists = []
+    for node in nodes:
+        node["sibling"] = 0
+    for node in nodes:
+        children = [child for _, child in sorted(node["children"].items())]
+        node["child"] = children[0] if children else 0
+        for child, sibling in zip(children, children[1:]):
+            nodes[child]["sibling"] = sibling
+    for node in nodes:
+        node["first_word"] = len(word_lists)
+        word_lists.extend(node["words"])
+
+    return nodes, word_lists
+
+
+# (5) Position independent word table: name and pixel offsets instead of pointers
+def face_word_table(words):
+    names = b""
+    pixels = []
+    table = []
+    for word, word_type, word_pixels in words:
+        table.append((len(names), len(pixels), len(word), word_type))
+        names += word.encode("ascii") + b"\0"
+        pixels.extend(word_pixels)
+
+    return table, names, pixels
+
+
+# (6) Writing the C tables
+def format_mask(mask):
+    parts = []
+    for word in range(MASK_WORDS):
+        value = (mask >> (64 * word)) & 0xFFFFFFFFFFFFFFFF
+        parts.append(f"0x{value:016X}ull")
+    return "{ { " + ", ".join(parts) + " } }"
+
+
+def write_header(path, seeds, slots, nodes, word_lists, words, time):
+    with open(path, "w") as f:
+        f.write("/* Auto-generated header file for clock pixel masks, do not edit */\n\n")
+        f.write("#ifndef AUTOGEN_CONFIG_CLOCK_MASKS_H\n\n")
+        f.write("#include \"cfg_clock.h\"\n\n")
+        f.write("#define CLOCK_NUM_TIME_SLOTS    (12)    /* One slot per 5 minutes */\n")
+        f.write("#define CLOCK_NUM_HOURS         (12)\n")
+        f.write(f"#define CLOCK_NUM_HOUR_FORMS    ({len(time['forms'])})     /* Hour word lists of the grammar */\n\n")
+        f.write(f"#define CLOCK_WORD_HASH_BUCKETS ({len(seeds)})\n")
+        f.write(f"#define CLOCK_WORD_HASH_SLOTS   ({len(slots)})\n")
+        f.write(f"#define CLOCK_WORD_HASH_EMPTY   (0x{HASH_EMPTY:02X})  /* Slot without a word */\n")
+        f.write(f"#define CLOCK_TRIE_NODES        ({len(nodes)})\n")
+        f.write(f"#define CLOCK_NUM_WORDS         ({len(words)})    /* Entries in CLOCK_words_S */\n")
+        f.write(f"#define CLOCK_TRIE_WORDS        ({len(word_lists)})\n")
+        _, names, pixels = face_word_table(words)
+        f.write(f"#define CLOCK_FACE_NAMES_SIZE   ({len(names)})\n")
+        f.write(f"#define CLOCK_FACE_PIXELS_SIZE  ({len(pixels)})\n\n")
+        f.write("/* Spelling trie node, node 0 is the root */\n")
+        f.write("typedef struct{\n")
+        f.write("    CHAR    char_c;         /* Letter leading to this node */\n")
+        f.write("    UINT16  child_u16;      /* First child, 0 = none */\n")
+        f.write("    UINT16  sibling_u16;    /* Next sibling, 0 = none */\n")
+        f.write("    UINT16  words_u16;      /* First word in CLOCK_trie_words_u8 */\n")
+        f.write("    UINT8   num_words_u8;   /* Words spelled by this node, in reading order */\n")
+        f.write("} CLOCK_TRIE_NODE;\n\n")
+        f.write("/* Clock word without pointers, the layout used by clock face images */\n")
+        f.write("typedef struct{\n")
+        f.write("    UINT16  name_u16;       /* Offset of the word in the name table */\n")
+        f.write("    UINT16  pixels_u16;     /* Offset of the first LED index in the pixel table */\n")
+        f.write("    UINT8   length_u8;      /* Letters (and LED indexes) in the word */\n")
+        f.write("    UINT8   type_u8;        /* CLOCK_WORD_TYPE */\n")
+        f.write("} CLOCK_FACE_WORD;\n\n")
+        f.write("extern const CLOCK_PIXEL_MASK  CLOCK_word_masks_S[];\n")
+        f.write("extern const CLOCK_PIXEL_MASK  CLOCK_slot_masks_S[ CLOCK_NUM_TIME_SLOTS ];\n")
+        f.write("extern const UINT8             CLOCK_slot_hour_offset_u8[ CLOCK_NUM_TIME_SLOTS ];\n")
+        f.write("extern const UINT8             CLOCK_slot_hour_form_u8[ CLOCK_NUM_TIME_SLOTS ];\n")
+        f.write("extern const CLOCK_PIXEL_MASK  CLOCK_hour_masks_S[ CLOCK_NUM_HOUR_FORMS * CLOCK_NUM_HOURS ];\n")
+        f.write("extern const UINT16            CLOCK_word_hash_seed_u16[ CLOCK_WORD_HASH_BUCKETS ];\n")
+        f.write("extern const UINT8             CLOCK_word_hash_slot_u8[ CLOCK_WORD_HASH_SLOTS ];\n")
+        f.write("extern const CLOCK_TRIE_NODE   CLOCK_trie_S[ CLOCK_TRIE_NODES ];\n")
+        f.write("extern const UINT8             CLOCK_trie_words_u8[ CLOCK_TRIE_WORDS ];\n")
+        f.write("extern const UINT16            CLOCK_word_read_start_u16[];\n")
+        f.write("extern const UINT16            CLOCK_word_read_end_u16[];\n")
+        f.write("extern const CLOCK_FACE_WORD   CLOCK_face_words_S[];\n")
+        f.write("extern const CHAR              CLOCK_face_names_c[ CLOCK_FACE_NAMES_SIZE ];\n")
+        f.write("extern const UINT8             CLOCK_face_pixels_u8[ CLOCK_FACE_PIXELS_SIZE ];\n\n")
+        f.write("#define AUTOGEN_CONFIG_CLOCK_MASKS_H\n")
+        f.write("#endif\n")
+
+
+def write_source(path, words, seeds, slots, nodes, word_lists, read_position, time):
+    with open(path, "w") as f:
+        f.write("/* Auto-generated source file for clock pixel masks, do not edit */\n\n")
+        f.write("#include \"cfg_clock_masks.h\"\n\n")
+
+        f.write("/* Pixel mask of each entry in CLOCK_words_S */\n")
+        f.write("const CLOCK_PIXEL_MASK CLOCK_word_masks_S[] = {\n")
+        for word, word_type, pixels in words:
+            f.write(f"    {format_mask(word_mask(pixels))}, /* {word} ({word_type}) */\n")
+        f.write("};\n\n")
+
+        f.write("/* Prefix and suffix words for each 5-minute slot, from the [grammar] of the word list */\n")
+        f.write("const CLOCK_PIXEL_MASK CLOCK_slot_masks_S[ CLOCK_NUM_TIME_SLOTS ] = {\n")
+        for slot, (mask, (slot_words, _, _, text)) in enumerate(zip(time["slot_masks"], time["slots"])):
+            indexes = " ".join(str(index) for index in slot_words)
+            f.write(f"    {format_mask(mask)}, /* :{slot * 5:02d} \"{text}\" words {indexes} */\n")
+        f.write("};\n\n")
+
+        f.write("/* Hour offset for each 5-minute slot (1 = upcoming hour) */\n")
+        f.write("const UINT8 CLOCK_slot_hour_offset_u8[ CLOCK_NUM_TIME_SLOTS ] = {\n    ")
+        f.write(", ".join(f"{offset}u" for _, offset, _, _ in time["slots"]))
+        f.write("\n};\n\n")
+
+        f.write("/* Hour word form for each 5-minute slot, selects a block of CLOCK_hour_masks_S */\n")
+        f.write("const UINT8 CLOCK_slot_hour_form_u8[ CLOCK_NUM_TIME_SLOTS ] = {\n    ")
+        f.write(", ".join(f"{form}u" for _, _, form, _ in time["slots"]))
+        f.write("\n};\n\n")
+
+        f.write("/* Hour words, indexed by (form * CLOCK_NUM_HOURS) + (hour % 12) */\n")
+        f.write("const CLOCK_PIXEL_MASK CLOCK_hour_masks_S[ CLOCK_NUM_HOUR_FORMS * CLOCK_NUM_HOURS ] = {\n")
+        for form, form_words in zip(time["forms"], time["hour_words"]):
+            for hour, index in enumerate(form_words):
+                name = words[index][0] + (f" ({form})" if form else "")
+                f.write(f"    {format_mask(word_mask(words[index][2]))}, /* {hour:2d} \"{name}\" */\n")
+        f.write("};\n\n")
+
+        f.write("/* Perfect hash seed for each bucket of (word, type) keys */\n")
+        f.write("const UINT16 CLOCK_word_hash_seed_u16[ CLOCK_WORD_HASH_BUCKETS ] = {\n    ")
+        f.write(", ".join(f"{seed}u" for seed in seeds))
+        f.write("\n};\n\n")
+
+        f.write("/* CLOCK_words_S index stored in each hash slot */\n")
+        f.write("const UINT8 CLOCK_word_hash_slot_u8[ CLOCK_WORD_HASH_SLOTS ] = {\n")
+        for slot, index in enumerate(slots):
+            name = "empty" if index == HASH_EMPTY else f"{words[index][0]} ({words[index][1]})"
+            f.write(f"    0x{index:02X}, /* {slot:3d}: {name} */\n")
+        f.write("};\n\n")
+
+        f.write("/* Spelling trie, children and siblings in alphabetical order */\n")
+        f.write("const CLOCK_TRIE_NODE CLOCK_trie_S[ CLOCK_TRIE_NODES ] = {\n")
+        for number, node in enumerate(nodes):
+            char = f"'{node['char']}'" if node["char"] else "'\\0'"
+            f.write(f"    {{ {char:>5}, {node['child']:3d}u, {node['sibling']:3d}u, "
+                    f"{node['first_word']:3d}u, {len(node['words'])}u }}, /* {number:3d} */\n")
+        f.write("};\n\n")
+
+        f.write("/* Words spelled by each trie node, in reading order */\n")
+        f.write("const UINT8 CLOCK_trie_words_u8[ CLOCK_TRIE_WORDS ] = {\n")
+        for index in word_lists:
+            f.write(f"    {index:3d}u, /* {words[index][0]} ({words[index][1]}) */\n")
+        f.write("};\n\n")
+
+        f.write("/* First and last reading position of each word (row from the top * width + x) */\n")
+        f.write("const UINT16 CLOCK_word_read_start_u16[] = {\n    ")
+        f.write(", ".join(f"{min(read_position[p] for p in w[2])}u" for w in words))
+        f.write("\n};\n\n")
+        f.write("const UINT16 CLOCK_word_read_end_u16[] = {\n    ")
+        f.write(", ".join(f"{max(read_position[p] for p in w[2])}u" for w in words))
+        f.write("\n};\n\n")
+
+        table, names, pixels = face_word_table(words)
+        f.write("/* CLOCK_words_S in the clock face image layout, see clock_face.h */\n")
+        f.write("const CLOCK_FACE_WORD CLOCK_face_words_S[] = {\n")
+        for (name, first, length, word_type), (word, _, _) in zip(table, words):
+            f.write(f"    {{ {name:3d}u, {first:3d}u, {length}u, {word_type} }}, /* {word} */\n")
+        f.write("};\n\n")
+        f.write("const CHAR CLOCK_face_names_c[ CLOCK_FACE_NAMES_SIZE ] =\n")
+        f.write("\n".join(f"    \"{word}\\0\"" for word, _, _ in words))
+        f.write(";\n\n")
+        f.write("const UINT8 CLOCK_face_pixels_u8[ CLOCK_FACE_PIXELS_SIZE ] = {\n")
+        for word, _, word_pixels in words:
+            f.write("    " + " ".join(f"{p}u," for p in word_pixels) + f" /* {word} */\n")
+        f.write("};\n")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 4:
+        fail("usage: gen_clock_masks.py <cfg_clock.c> <words.txt> <output directory>")
+
+    cfg_path, words_path, out_dir = sys.argv[1], sys.argv[2], sys.argv[3]
+    os.makedirs(out_dir, exist_ok=True)
+
+    clock_words = parse_words(cfg_path)
+    clock_types, MASK_WORDS = parse_types(os.path.join(os.path.dirname(cfg_path), "cfg_clock.h"))
+    clock_read_position = parse_grid(cfg_path)
+    hash_seeds, hash_slots = build_hash(clock_words, clock_types)
+    trie_nodes, trie_words = build_trie(clock_words, clock_read_position)
+    _, _, grammar_lines = gen_clock_layout.parse_words(words_path)
+    clock_time = compile_time(grammar_lines, words_path, clock_words, clock_read_position)
+    write_header(os.path.join(out_dir, "cfg_clock_masks.h"), hash_seeds, hash_slots, trie_nodes, trie_words,
+                 clock_words, clock_time)
+    write_source(os.path.join(out_dir, "cfg_clock_masks.c"), clock_words, hash_seeds, hash_slots,
+                 trie_nodes, trie_words, clock_read_position, clock_time)
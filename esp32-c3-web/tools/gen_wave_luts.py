@@ -0,0 +1,112 @@
+"""
+Generates integer waveform lookup tables for the display effects.
+
+The ESP32-C3 has no FPU, so sinf()/expf() and HSV conversion at runtime go
+through soft-float libm. The effects instead index these tables with an
+8-bit phase and only use integer arithmetic.
+
+Usage: python gen_wave_luts.py <output directory>
+"""
+
+import math
+import os
+import sys
+
+# Number of entries in each table, one full period for an 8-bit phase
+LUT_SIZE = 256
+
+# Steepness of the exponential ease, larger = longer dark section
+EASE_STEEPNESS = 4.0
+
+
+def fail(message):
+    print(f"gen_wave_luts.py: error: {message}", file=sys.stderr)
+    sys.exit(1)
+
+
+# (1) Computing the tables
+def sine_table():
+    # One full period, offset to 0 - 255, starting at the minimum
+    return [
+        round(127.5 - 127.5 * math.cos(2.0 * math.pi * i / LUT_SIZE))
+        for i in range(LUT_SIZE)
+    ]
+
+
+def ease_table():
+    # Exponential ease-in from 0 to 255, perceived as a linear fade
+    scale = math.exp(EASE_STEEPNESS) - 1.0
+    return [
+        round(255.0 * (math.exp(EASE_STEEPNESS * i / (LUT_SIZE - 1)) - 1.0) / scale)
+        for i in range(LUT_SIZE)
+    ]
+
+
+def hue_table():
+    # Fully saturated HSV hue wheel at full value
+    colors = []
+    for i in range(LUT_SIZE):
+        hue = 6.0 * i / LUT_SIZE
+        sector = int(hue)
+        rise = round(255.0 * (hue - sector))
+        fall = 255 - rise
+        colors.append([
+            (255, rise, 0),
+            (fall, 255, 0),
+            (0, 255, rise),
+            (0, fall, 255),
+            (rise, 0, 255),
+            (255, 0, fall),
+        ][sector])
+    return colors
+
+
+# (2) Writing the C tables
+def write_values(f, values, per_line):
+    for start in range(0, len(values), per_line):
+        f.write("    " + ", ".join(values[start:start + per_line]) + ",\n")
+
+
+def write_header(path):
+    with open(path, "w") as f:
+        f.write("/* Auto-generated header file for effect waveform tables, do not edit */\n\n")
+        f.write("#ifndef AUTOGEN_CONFIG_WAVE_LUTS_H\n\n")
+        f.write("#include \"rgb_rmt.h\"\n\n")
+        f.write(f"#define WAVE_LUT_SIZE   ({LUT_SIZE})   /* Indexed by an 8-bit phase */\n\n")
+        f.write("extern const UINT8      WAVE_sine_u8[ WAVE_LUT_SIZE ];\n")
+        f.write("extern const UINT8      WAVE_ease_u8[ WAVE_LUT_SIZE ];\n")
+        f.write("extern const RGB_COLOR  WAVE_hue_S[ WAVE_LUT_SIZE ];\n\n")
+        f.write("#define AUTOGEN_CONFIG_WAVE_LUTS_H\n")
+        f.write("#endif\n")
+
+
+def write_source(path):
+    with open(path, "w") as f:
+        f.write("/* Auto-generated source file for effect waveform tables, do not edit */\n\n")
+        f.write("#include \"cfg_wave_luts.h\"\n\n")
+
+        f.write("/* Raised cosine, 0 at phase 0, 255 at phase 128 */\n")
+        f.write("const UINT8 WAVE_sine_u8[ WAVE_LUT_SIZE ] = {\n")
+        write_values(f, [f"{v:3d}" for v in sine_table()], 16)
+        f.write("};\n\n")
+
+        f.write(f"/* Exponential ease-in, steepness {EASE_STEEPNESS} */\n")
+        f.write("const UINT8 WAVE_ease_u8[ WAVE_LUT_SIZE ] = {\n")
+        write_values(f, [f"{v:3d}" for v in ease_table()], 16)
+        f.write("};\n\n")
+
+        f.write("/* HSV hue wheel, full saturation and value, red at phase 0 */\n")
+        f.write("const RGB_COLOR WAVE_hue_S[ WAVE_LUT_SIZE ] = {\n")
+        write_values(f, [f"{{ {r:3d}, {g:3d}, {b:3d} }}" for r, g, b in hue_table()], 4)
+        f.write("};\n")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        fail("usage: gen_wave_luts.py <output directory>")
+
+    out_dir = sys.argv[1]
+    os.makedirs(out_dir, exist_ok=True)
+
+    write_header(os.path.join(out_dir, "cfg_wave_luts.h"))
+    write_source(os.path.join(out_dir, "cfg_wave_luts.c"))
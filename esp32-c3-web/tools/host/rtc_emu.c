@@ -0,0 +1,748 @@
+/*==============================================================================
+ *==============================================================================
+ * NAME:
+ *      rtc_emu.c
+ *
+ * PURPOSE:
+ *      Emulated PCF85263A for the host tests of rtc.c, see rtc_emu.h.
+ *
+ *      Modelled: the time and date registers with the 100th seconds, the
+ *      weekday register (free running), STOP and the prescaler reset, the
+ *      periodic interrupt, alarm 1, the flags (written 0 clears) and ~INTA
+ *      in level mode. Everything else is plain storage.
+ *
+ * DEPENDENCIES:
+ *      rtc_emu.h
+ *
+ *==============================================================================
+ * (C) Andrew Bright 2024, github.com/e5h
+ *==============================================================================
+ *=============================================================================*/
+
+/*=============================================================================*/
+/*][ Include Files ][==========================================================*/
+/*=============================================================================*/
+
+#include "rtc_emu.h"
+#include "driver/i2c_master.h"
+#include "driver/gpio.h"
+#include "esp_sleep.h"
+
+/*=============================================================================*/
+/*][ LOCAL : Constants and Types ][============================================*/
+/*=============================================================================*/
+
+#define EMU_REG_COUNT       (0x30)
+#define EMU_TIME_REG_LAST   (RTC_REG_ADDR_YEARS)
+
+typedef struct{
+    UINT8 reg_u8[EMU_REG_COUNT];
+
+    INT64 cpu_us_i64;               // Emulated TIMER_GetTimeUs()
+    INT64 base_cpu_us_i64;          // CPU time of base_rtc_us_i64
+    INT64 base_rtc_us_i64;          // RTC time, us since 2000-01-01 00:00:00
+    INT32 drift_ppb_i32;            // RTC crystal against the CPU timer
+    UINT8 wday_offset_u8;           // Weekday register against the weekday of the date
+    BOOL running_b;                 // FALSE while STOP is set
+
+    INT32 int_gpio_i32;             // GPIO of the ISR, ~INTA is wired to it
+    gpio_isr_t isr;
+    void* isr_arg;
+    BOOL intr_enabled_b;
+    BOOL level_wakeup_b;            // gpio_wakeup_enable() low level
+    BOOL isr_service_b;
+    UINT32 isr_count_u32;
+    EventBits_t event_bits;         // Bits set by the ISR
+
+    BOOL in_isr_b;
+} RTC_EMU_T;
+
+/*=============================================================================*/
+/*][ LOCAL : Variables ][======================================================*/
+/*=============================================================================*/
+
+static RTC_EMU_T emu_s;
+static const UINT8 emu_month_days_u8[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+/*=============================================================================*/
+/*][ LOCAL : Functions ][======================================================*/
+/*=============================================================================*/
+
+static UINT8 to_bcd(INT32 value_i32)
+{
+    return (UINT8)(((value_i32 / 10) << 4) | (value_i32 % 10));
+}
+
+static INT32 from_bcd(UINT8 bcd_u8)
+{
+    return (bcd_u8 >> 4) * 10 + (bcd_u8 & 0x0F);
+}
+
+static INT32 month_days(INT32 year_i32, INT32 month_i32)
+{
+    // Years 2000-2099, every fourth one is a leap year
+    return emu_month_days_u8[month_i32 - 1] + ((month_i32 == 2 && year_i32 % 4 == 0) ? 1 : 0);
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      us_to_fields() - calendar of an RTC time
+ *
+ * SUMMARY:
+ *      Counts the days through the calendar instead of the arithmetic
+ *      rtc.c uses, so the two are checked against each other.
+ *
+ * INPUT REQUIREMENTS:
+ *      rtc_us_i64 >= 0
+ *
+ * OUTPUT GUARANTEES:
+ *      p_time_s holds the register values (see RTC_get_time())
+ **===< local >================================================================*/
+static void us_to_fields(INT64 rtc_us_i64, struct tm* p_time_s)
+{
+    INT64 seconds_i64 = rtc_us_i64 / 1000000;
+    INT32 days_i32 = (INT32)(seconds_i64 / 86400);
+    INT32 second_of_day_i32 = (INT32)(seconds_i64 % 86400);
+    INT32 year_i32 = 0;
+    INT32 month_i32 = 1;
+
+    // 2000-01-01 was a saturday (6)
+    p_time_s->tm_wday = (days_i32 + 6 + emu_s.wday_offset_u8) % 7;
+
+    while(days_i32 >= ((year_i32 % 4 == 0) ? 366 : 365))
+    {
+        days_i32 -= (year_i32 % 4 == 0) ? 366 : 365;
+        year_i32++;
+    }
+    while(days_i32 >= month_days(year_i32, month_i32))
+    {
+        days_i32 -= month_days(year_i32, month_i32);
+        month_i32++;
+    }
+
+    p_time_s->tm_year = year_i32 % 100;
+    p_time_s->tm_mon = month_i32;
+    p_time_s->tm_mday = days_i32 + 1;
+    p_time_s->tm_hour = second_of_day_i32 / 3600;
+    p_time_s->tm_min = second_of_day_i32 / 60 % 60;
+    p_time_s->tm_sec = second_of_day_i32 % 60;
+}
+
+static INT64 rtc_at(INT64 cpu_us_i64)
+{
+    if(emu_s.running_b != TRUE)
+    {
+        return emu_s.base_rtc_us_i64;
+    }
+
+    INT64 elapsed_us_i64 = cpu_us_i64 - emu_s.base_cpu_us_i64;
+
+    return emu_s.base_rtc_us_i64 + elapsed_us_i64 + elapsed_us_i64 * emu_s.drift_ppb_i32 / 1000000000;
+}
+
+static void rebase(INT64 rtc_us_i64)
+{
+    emu_s.base_cpu_us_i64 = emu_s.cpu_us_i64;
+    emu_s.base_rtc_us_i64 = rtc_us_i64;
+}
+
+static BOOL inta_low(void)
+{
+    UINT8 inta_u8 = emu_s.reg_u8[CTRL_REG_ADDR_INTA_ENABLE];
+    UINT8 flags_u8 = emu_s.reg_u8[CTRL_REG_ADDR_FLAGS];
+
+    if((emu_s.reg_u8[CTRL_REG_ADDR_PIN_IO] & CTRL_REG_PIN_IO_M_INTAPM) != PIN_IO_INTAPM_N_INTA_OUT
+    || (inta_u8 & CTRL_REG_INTA_ENABLE_M_ILPA) == 0)
+    {
+        // Pulse mode is not modelled, a pulse may be missed in light sleep
+        return FALSE;
+    }
+
+    return (((inta_u8 & CTRL_REG_INTA_ENABLE_M_PIEA) && (flags_u8 & CTRL_REG_FLAGS_M_PIF))
+         || ((inta_u8 & CTRL_REG_INTA_ENABLE_M_A1IEA) && (flags_u8 & CTRL_REG_FLAGS_M_A1F))) ? TRUE : FALSE;
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      isr_check() - level interrupt on ~INTA
+ *
+ * SUMMARY:
+ *      Called on every change of the pin or of the interrupt enable. The
+ *      ISR masks the interrupt, or it would be called again right away.
+ **===< local >================================================================*/
+static void isr_check(void)
+{
+    while(emu_s.in_isr_b != TRUE && emu_s.intr_enabled_b == TRUE && emu_s.level_wakeup_b == TRUE
+       && emu_s.isr != NULL && inta_low() == TRUE)
+    {
+        emu_s.isr_count_u32++;
+
+        emu_s.in_isr_b = TRUE;
+        emu_s.isr(emu_s.isr_arg);
+        emu_s.in_isr_b = FALSE;
+
+        if(emu_s.intr_enabled_b == TRUE)
+        {
+            fprintf(stderr, "rtc_emu: the ISR left the level interrupt enabled, it would never return\n");
+            abort();
+        }
+    }
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      second_edge() - the RTC counts a second
+ *
+ * SUMMARY:
+ *      Raises the periodic interrupt and alarm 1 flags.
+ **===< local >================================================================*/
+static void second_edge(INT64 rtc_us_i64)
+{
+    struct tm time_s;
+    UINT8 pi_u8 = emu_s.reg_u8[CTRL_REG_ADDR_FUNCTION] & CTRL_REG_FUNC_M_PI;
+    UINT8 enables_u8 = emu_s.reg_u8[RTC_REG_ADDR_ALARM_ENABLES];
+
+    us_to_fields(rtc_us_i64, &time_s);
+
+    if((pi_u8 == FUNC_PI_SECOND)
+    || (pi_u8 == FUNC_PI_MINUTE && time_s.tm_sec == 0)
+    || (pi_u8 == FUNC_PI_HOUR && time_s.tm_sec == 0 && time_s.tm_min == 0))
+    {
+        emu_s.reg_u8[CTRL_REG_ADDR_FLAGS] |= CTRL_REG_FLAGS_M_PIF;
+    }
+
+    if((enables_u8 & 0x1F) != 0
+    && (!(enables_u8 & RTC_REG_ALARM_EN_M_SEC_A1E)
+        || from_bcd(emu_s.reg_u8[RTC_REG_ADDR_SECOND_ALARM1] & RTC_REG_SECOND_ALARM1_M) == time_s.tm_sec)
+    && (!(enables_u8 & RTC_REG_ALARM_EN_M_MIN_A1E)
+        || from_bcd(emu_s.reg_u8[RTC_REG_ADDR_MINUTE_ALARM1] & RTC_REG_MINUTE_ALARM1_M) == time_s.tm_min)
+    && (!(enables_u8 & RTC_REG_ALARM_EN_M_HR_A1E)
+        || from_bcd(emu_s.reg_u8[RTC_REG_ADDR_HOUR_ALARM1] & RTC_REG_HOUR_ALARM1_M_HR24) == time_s.tm_hour)
+    && (!(enables_u8 & RTC_REG_ALARM_EN_M_DAY_A1E)
+        || from_bcd(emu_s.reg_u8[RTC_REG_ADDR_DAY_ALARM1] & RTC_REG_DAY_ALARM1_M) == time_s.tm_mday)
+    && (!(enables_u8 & RTC_REG_ALARM_EN_M_MON_A1E)
+        || from_bcd(emu_s.reg_u8[RTC_REG_ADDR_MONTH_ALARM1] & RTC_REG_MONTH_ALARM1_M) == time_s.tm_mon))
+    {
+        emu_s.reg_u8[CTRL_REG_ADDR_FLAGS] |= CTRL_REG_FLAGS_M_A1F;
+    }
+
+    isr_check();
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      latch() - copy the time into the time registers
+ *
+ * SUMMARY:
+ *      The PCF85263A latches the time at the start of a read, it does not
+ *      change during the transfer.
+ **===< local >================================================================*/
+static void latch(void)
+{
+    struct tm time_s;
+    INT64 rtc_us_i64 = rtc_at(emu_s.cpu_us_i64);
+
+    us_to_fields(rtc_us_i64, &time_s);
+
+    emu_s.reg_u8[RTC_REG_ADDR_100TH_SECONDS] = (emu_s.reg_u8[CTRL_REG_ADDR_FUNCTION] & CTRL_REG_FUNC_M_1OOTH)
+                                             ? to_bcd((INT32)(rtc_us_i64 % 1000000 / 10000)) : 0;
+    emu_s.reg_u8[RTC_REG_ADDR_SECONDS] = to_bcd(time_s.tm_sec);
+    emu_s.reg_u8[RTC_REG_ADDR_MINUTES] = to_bcd(time_s.tm_min);
+    emu_s.reg_u8[RTC_REG_ADDR_HOURS] = to_bcd(time_s.tm_hour);
+    emu_s.reg_u8[RTC_REG_ADDR_DAYS] = to_bcd(time_s.tm_mday);
+    emu_s.reg_u8[RTC_REG_ADDR_WEEKDAYS] = to_bcd(time_s.tm_wday);
+    emu_s.reg_u8[RTC_REG_ADDR_MONTHS] = to_bcd(time_s.tm_mon);
+    emu_s.reg_u8[RTC_REG_ADDR_YEARS] = to_bcd(time_s.tm_year);
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      time_write() - the time registers were written
+ *
+ * SUMMARY:
+ *      The registers written replace their part of the time, the others
+ *      keep theirs. The 100th seconds are kept unless written.
+ **===< local >================================================================*/
+static void time_write(const UINT8* value_u8, UINT8 first_u8, UINT8 last_u8)
+{
+    struct tm time_s;
+    INT64 rtc_us_i64 = rtc_at(emu_s.cpu_us_i64);
+    INT32 subsecond_us_i32 = (INT32)(rtc_us_i64 % 1000000);
+    INT32 fields_i32[EMU_TIME_REG_LAST + 1];
+
+    us_to_fields(rtc_us_i64, &time_s);
+    fields_i32[RTC_REG_ADDR_100TH_SECONDS] = subsecond_us_i32 / 10000;
+    fields_i32[RTC_REG_ADDR_SECONDS] = time_s.tm_sec;
+    fields_i32[RTC_REG_ADDR_MINUTES] = time_s.tm_min;
+    fields_i32[RTC_REG_ADDR_HOURS] = time_s.tm_hour;
+    fields_i32[RTC_REG_ADDR_DAYS] = time_s.tm_mday;
+    fields_i32[RTC_REG_ADDR_WEEKDAYS] = time_s.tm_wday;
+    fields_i32[RTC_REG_ADDR_MONTHS] = time_s.tm_mon;
+    fields_i32[RTC_REG_ADDR_YEARS] = time_s.tm_year;
+
+    for(UINT8 reg_u8 = first_u8; reg_u8 <= last_u8; reg_u8++)
+    {
+        fields_i32[reg_u8] = from_bcd(value_u8[reg_u8 - first_u8]);
+    }
+
+    if(first_u8 == RTC_REG_ADDR_100TH_SECONDS)
+    {
+        subsecond_us_i32 = fields_i32[RTC_REG_ADDR_100TH_SECONDS] * 10000;
+    }
+
+    rtc_us_i64 = RTC_EMU_date_to_us(fields_i32[RTC_REG_ADDR_YEARS], fields_i32[RTC_REG_ADDR_MONTHS],
+                                    fields_i32[RTC_REG_ADDR_DAYS], fields_i32[RTC_REG_ADDR_HOURS],
+                                    fields_i32[RTC_REG_ADDR_MINUTES], fields_i32[RTC_REG_ADDR_SECONDS])
+               + subsecond_us_i32;
+
+    emu_s.wday_offset_u8 = 0;
+    us_to_fields(rtc_us_i64, &time_s);
+    emu_s.wday_offset_u8 = (UINT8)((fields_i32[RTC_REG_ADDR_WEEKDAYS] + 7 - time_s.tm_wday) % 7);
+    rebase(rtc_us_i64);
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      reg_write() - a control register was written
+ **===< local >================================================================*/
+static void reg_write(UINT8 reg_addr_u8, UINT8 value_u8)
+{
+    switch(reg_addr_u8)
+    {
+        case CTRL_REG_ADDR_FLAGS:
+            // Writing 0 clears a flag, 1 leaves it
+            emu_s.reg_u8[reg_addr_u8] &= value_u8;
+            break;
+
+        case CTRL_REG_ADDR_STOP_ENABLE:
+            if((value_u8 & CTRL_REG_STOP_ENABLE_M_STOP) && emu_s.running_b == TRUE)
+            {
+                rebase(rtc_at(emu_s.cpu_us_i64));
+                emu_s.running_b = FALSE;
+            }
+            else if(!(value_u8 & CTRL_REG_STOP_ENABLE_M_STOP) && emu_s.running_b != TRUE)
+            {
+                rebase(emu_s.base_rtc_us_i64);
+                emu_s.running_b = TRUE;
+            }
+            emu_s.reg_u8[reg_addr_u8] = value_u8;
+            break;
+
+        case CTRL_REG_ADDR_RESETS:
+            // The prescaler restarts the second, the 100th seconds are cleared
+            if((value_u8 & CTRL_REG_RESET_BASE) == CTRL_REG_RESET_BASE && (value_u8 & REG_RESET_BIT_CPR))
+            {
+                INT64 rtc_us_i64 = rtc_at(emu_s.cpu_us_i64);
+
+                rebase(rtc_us_i64 - rtc_us_i64 % 1000000);
+            }
+            break;
+
+        default:
+            emu_s.reg_u8[reg_addr_u8] = value_u8;
+            break;
+    }
+}
+
+static void bus_time(size_t bytes)
+{
+    RTC_EMU_run_until(emu_s.cpu_us_i64 + (INT64)bytes * RTC_EMU_I2C_BYTE_US);
+}
+
+/*=============================================================================*/
+/*][ GLOBAL : Functions ][=====================================================*/
+/*=============================================================================*/
+
+/**===< global >===============================================================
+ * NAME:
+ *      RTC_EMU_start() - Power up the emulated RTC
+ *
+ * SUMMARY:
+ *      All registers read 0 (no interrupts, 24 h, 100th seconds off), the
+ *      CPU timer starts at 0.
+ *
+ * INPUT REQUIREMENTS:
+ *      rtc_us_i64 is the time in us since 2000-01-01 00:00:00, wday_u8 the
+ *      weekday register (0-6), drift_ppb_i32 how fast the RTC crystal runs
+ *      against the CPU timer
+ *
+ * OUTPUT GUARANTEES:
+ *      ---
+ **===< global >===============================================================*/
+void RTC_EMU_start(INT64 rtc_us_i64, UINT8 wday_u8, INT32 drift_ppb_i32)
+{
+    struct tm time_s;
+
+    memset(&emu_s, 0, sizeof(emu_s));
+    emu_s.int_gpio_i32 = -1;
+    emu_s.drift_ppb_i32 = drift_ppb_i32;
+    emu_s.running_b = TRUE;
+    rebase(rtc_us_i64);
+
+    us_to_fields(rtc_us_i64, &time_s);
+    emu_s.wday_offset_u8 = (UINT8)((wday_u8 + 7 - time_s.tm_wday) % 7);
+}
+
+/**===< global >===============================================================
+ * NAME:
+ *      RTC_EMU_run_until() - Let the CPU timer run
+ *
+ * SUMMARY:
+ *      Every second edge of the RTC on the way is counted, and may call the
+ *      ISR. Nothing happens if cpu_us_i64 is in the past.
+ **===< global >===============================================================*/
+void RTC_EMU_run_until(INT64 cpu_us_i64)
+{
+    while(emu_s.running_b == TRUE)
+    {
+        INT64 edge_rtc_us_i64 = (rtc_at(emu_s.cpu_us_i64) / 1000000 + 1) * 1000000;
+        INT64 edge_cpu_us_i64 = RTC_EMU_get_cpu_at(edge_rtc_us_i64);
+
+        if(edge_cpu_us_i64 > cpu_us_i64)
+        {
+            break;
+        }
+
+        emu_s.cpu_us_i64 = edge_cpu_us_i64;
+        second_edge(edge_rtc_us_i64);
+    }
+
+    if(cpu_us_i64 > emu_s.cpu_us_i64)
+    {
+        emu_s.cpu_us_i64 = cpu_us_i64;
+    }
+}
+
+/**===< global >===============================================================
+ * NAME:
+ *      RTC_EMU_wait_bits() - Sleep until the ISR wakes the task
+ *
+ * SUMMARY:
+ *      Runs until the ISR set event bits, or until until_cpu_us_i64.
+ *
+ * OUTPUT GUARANTEES:
+ *      Returns the CPU time it woke at
+ **===< global >===============================================================*/
+INT64 RTC_EMU_wait_bits(INT64 until_cpu_us_i64)
+{
+    while(emu_s.event_bits == 0 && emu_s.cpu_us_i64 < until_cpu_us_i64)
+    {
+        INT64 edge_rtc_us_i64 = (rtc_at(emu_s.cpu_us_i64) / 1000000 + 1) * 1000000;
+        INT64 step_us_i64 = (emu_s.running_b == TRUE) ? RTC_EMU_get_cpu_at(edge_rtc_us_i64) : until_cpu_us_i64;
+
+        RTC_EMU_run_until((step_us_i64 < until_cpu_us_i64) ? step_us_i64 : until_cpu_us_i64);
+    }
+
+    return emu_s.cpu_us_i64;
+}
+
+/**===< global >===============================================================
+ * NAME:
+ *      RTC_EMU_take_bits() - Read and clear the bits set by the ISR
+ **===< global >===============================================================*/
+EventBits_t RTC_EMU_take_bits(void)
+{
+    EventBits_t bits = emu_s.event_bits;
+
+    emu_s.event_bits = 0;
+
+    return bits;
+}
+
+INT64 RTC_EMU_get_cpu_us(void)
+{
+    return emu_s.cpu_us_i64;
+}
+
+INT64 RTC_EMU_get_rtc_us(void)
+{
+    return rtc_at(emu_s.cpu_us_i64);
+}
+
+/**===< global >===============================================================
+ * NAME:
+ *      RTC_EMU_get_cpu_at() - CPU time the running RTC reaches a time
+ *
+ * OUTPUT GUARANTEES:
+ *      Returns the first CPU us at which the RTC is at or past rtc_us_i64,
+ *      INT64_MAX while it is stopped
+ **===< global >===============================================================*/
+INT64 RTC_EMU_get_cpu_at(INT64 rtc_us_i64)
+{
+    if(emu_s.running_b != TRUE)
+    {
+        return INT64_MAX;
+    }
+
+    double rate_f64 = 1.0 + emu_s.drift_ppb_i32 * 1e-9;
+    INT64 cpu_us_i64 = emu_s.base_cpu_us_i64 + (INT64)((rtc_us_i64 - emu_s.base_rtc_us_i64) / rate_f64);
+
+    // The integer rate of rtc_at() decides
+    while(rtc_at(cpu_us_i64) < rtc_us_i64)
+    {
+        cpu_us_i64++;
+    }
+    while(rtc_at(cpu_us_i64 - 1) >= rtc_us_i64)
+    {
+        cpu_us_i64--;
+    }
+
+    return cpu_us_i64;
+}
+
+/**===< global >===============================================================
+ * NAME:
+ *      RTC_EMU_get_time() - Time of the RTC now, in the register ranges
+ **===< global >===============================================================*/
+void RTC_EMU_get_time(struct tm* p_timestamp_s)
+{
+    us_to_fields(rtc_at(emu_s.cpu_us_i64), p_timestamp_s);
+}
+
+UINT8 RTC_EMU_get_reg(UINT8 reg_addr_u8)
+{
+    return emu_s.reg_u8[reg_addr_u8];
+}
+
+/**===< global >===============================================================
+ * NAME:
+ *      RTC_EMU_set_reg() - Set a register behind the driver
+ *
+ * SUMMARY:
+ *      For the state left by a reset of the CPU, e.g. a stale flag. Flags
+ *      are set, not cleared, by a 1.
+ **===< global >===============================================================*/
+void RTC_EMU_set_reg(UINT8 reg_addr_u8, UINT8 value_u8)
+{
+    emu_s.reg_u8[reg_addr_u8] = value_u8;
+    isr_check();
+}
+
+BOOL RTC_EMU_inta_low(void)
+{
+    return inta_low();
+}
+
+BOOL RTC_EMU_intr_enabled(void)
+{
+    return emu_s.intr_enabled_b;
+}
+
+UINT32 RTC_EMU_get_isr_count(void)
+{
+    return emu_s.isr_count_u32;
+}
+
+/**===< global >===============================================================
+ * NAME:
+ *      RTC_EMU_date_to_us() - RTC time of a date
+ *
+ * INPUT REQUIREMENTS:
+ *      year 0-99 (2000-2099), month 1-12, day 1-31
+ *
+ * OUTPUT GUARANTEES:
+ *      Returns us since 2000-01-01 00:00:00
+ **===< global >===============================================================*/
+INT64 RTC_EMU_date_to_us(INT32 year_i32, INT32 month_i32, INT32 day_i32,
+                         INT32 hour_i32, INT32 minute_i32, INT32 second_i32)
+{
+    INT64 days_i64 = day_i32 - 1;
+
+    for(INT32 year_index_i32 = 0; year_index_i32 < year_i32; year_index_i32++)
+    {
+        days_i64 += (year_index_i32 % 4 == 0) ? 366 : 365;
+    }
+    for(INT32 month_index_i32 = 1; month_index_i32 < month_i32; month_index_i32++)
+    {
+        days_i64 += month_days(year_i32, month_index_i32);
+    }
+
+    return ((days_i64 * 24 + hour_i32) * 3600 + minute_i32 * 60 + second_i32) * 1000000;
+}
+
+/*=============================================================================*/
+/*][ Driver stubs ][===========================================================*/
+/*=============================================================================*/
+
+UINT64 TIMER_GetTimeUs()
+{
+    RTC_EMU_run_until(emu_s.cpu_us_i64 + RTC_EMU_TIMER_READ_US);
+
+    return (UINT64)emu_s.cpu_us_i64;
+}
+
+UINT64 TIMER_GetTickMs()
+{
+    return TIMER_GetTimeUs() / 1000;
+}
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t* p_bus_config, i2c_master_bus_handle_t* p_bus_handle)
+{
+    *p_bus_handle = (i2c_master_bus_handle_t)&emu_s;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle, const i2c_device_config_t* p_dev_config,
+                                    i2c_master_dev_handle_t* p_dev_handle)
+{
+    if(p_dev_config->device_address != PCF85263A_ADDR_7BIT || p_dev_config->scl_speed_hz > 400000)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *p_dev_handle = (i2c_master_dev_handle_t)&emu_s;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t dev_handle, const uint8_t* write_buffer, size_t write_size,
+                              int xfer_timeout_ms)
+{
+    if(emu_s.in_isr_b == TRUE || write_size < 1 || write_buffer[0] + write_size - 1 > EMU_REG_COUNT)
+    {
+        return ESP_FAIL;
+    }
+
+    // Device address, register address and data
+    bus_time(write_size + 1);
+
+    UINT8 first_u8 = write_buffer[0];
+    UINT8 last_u8 = (UINT8)(first_u8 + write_size - 2);
+
+    if(write_size > 1 && first_u8 <= EMU_TIME_REG_LAST)
+    {
+        UINT8 time_last_u8 = (last_u8 < EMU_TIME_REG_LAST) ? last_u8 : EMU_TIME_REG_LAST;
+
+        time_write(&write_buffer[1], first_u8, time_last_u8);
+    }
+
+    for(size_t i = 1; i < write_size; i++)
+    {
+        UINT8 reg_addr_u8 = (UINT8)(first_u8 + i - 1);
+
+        if(reg_addr_u8 > EMU_TIME_REG_LAST)
+        {
+            reg_write(reg_addr_u8, write_buffer[i]);
+        }
+    }
+
+    isr_check();
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t dev_handle, const uint8_t* write_buffer, size_t write_size,
+                                      uint8_t* read_buffer, size_t read_size, int xfer_timeout_ms)
+{
+    if(emu_s.in_isr_b == TRUE || write_size != 1 || write_buffer[0] + read_size > EMU_REG_COUNT)
+    {
+        return ESP_FAIL;
+    }
+
+    bus_time(write_size + 2);
+    latch();
+    memcpy(read_buffer, &emu_s.reg_u8[write_buffer[0]], read_size);
+    bus_time(read_size);
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_config(const gpio_config_t* p_config)
+{
+    if(p_config->intr_type != GPIO_INTR_DISABLE)
+    {
+        emu_s.intr_enabled_b = TRUE;
+        emu_s.level_wakeup_b = (p_config->intr_type == GPIO_INTR_LOW_LEVEL) ? TRUE : FALSE;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    if(emu_s.isr_service_b == TRUE)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    emu_s.isr_service_b = TRUE;
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void* args)
+{
+    if(emu_s.isr_service_b != TRUE)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    emu_s.int_gpio_i32 = gpio_num;
+    emu_s.isr = isr_handler;
+    emu_s.isr_arg = args;
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num)
+{
+    if(gpio_num != emu_s.int_gpio_i32)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    emu_s.intr_enabled_b = TRUE;
+    isr_check();
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num)
+{
+    if(gpio_num != emu_s.int_gpio_i32)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    emu_s.intr_enabled_b = FALSE;
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+{
+    // Also sets the interrupt type, only a level wakes from light sleep
+    if(intr_type != GPIO_INTR_LOW_LEVEL && intr_type != GPIO_INTR_HIGH_LEVEL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    emu_s.level_wakeup_b = (intr_type == GPIO_INTR_LOW_LEVEL) ? TRUE : FALSE;
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_sleep_sel_dis(gpio_num_t gpio_num)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup(void)
+{
+    return ESP_OK;
+}
+
+BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t group_h, EventBits_t bits, BaseType_t* p_task_woken)
+{
+    if(emu_s.in_isr_b != TRUE)
+    {
+        fprintf(stderr, "rtc_emu: xEventGroupSetBitsFromISR() outside the ISR\n");
+        abort();
+    }
+
+    emu_s.event_bits |= bits;
+    *p_task_woken = pdTRUE;
+
+    return pdPASS;
+}
@@ -0,0 +1,60 @@
+/*==============================================================================
+ *==============================================================================
+ * NAME:
+ *      rtc_emu.h
+ *
+ * PURPOSE:
+ *      Emulated PCF85263A for the host tests of rtc.c.
+ *
+ *      The register model runs on an emulated CPU timer. The I2C and GPIO
+ *      driver calls rtc.c makes act on the registers, a transfer takes the
+ *      time it takes on the 400 kHz bus, and ~INTA calls the GPIO ISR like
+ *      the level interrupt on the target. The RTC crystal can run fast or
+ *      slow against the CPU timer.
+ *
+ * DEPENDENCIES:
+ *      rtc.h, the stub ESP-IDF headers in stub/
+ *
+ *==============================================================================
+ * (C) Andrew Bright 2024, github.com/e5h
+ *==============================================================================
+ *=============================================================================*/
+
+#ifndef WC_RTC_EMU_H
+
+/*=============================================================================*/
+/*][ Include Files ][==========================================================*/
+/*=============================================================================*/
+
+#include "rtc.h"
+
+/*=============================================================================*/
+/*][ GLOBAL : Constants and Types ][===========================================*/
+/*=============================================================================*/
+
+#define RTC_EMU_I2C_BYTE_US     (23)        // One byte and its ack at 400 kHz
+#define RTC_EMU_TIMER_READ_US   (1)         // A TIMER_GetTimeUs() call
+
+/*=============================================================================*/
+/*][ GLOBAL : Exportable Function Prototypes ][================================*/
+/*=============================================================================*/
+
+extern void         RTC_EMU_start(INT64 rtc_us_i64, UINT8 wday_u8, INT32 drift_ppb_i32);
+extern void         RTC_EMU_run_until(INT64 cpu_us_i64);
+extern INT64        RTC_EMU_wait_bits(INT64 until_cpu_us_i64);
+extern EventBits_t  RTC_EMU_take_bits(void);
+extern INT64        RTC_EMU_get_cpu_us(void);
+extern INT64        RTC_EMU_get_rtc_us(void);
+extern INT64        RTC_EMU_get_cpu_at(INT64 rtc_us_i64);
+extern void         RTC_EMU_get_time(struct tm* p_timestamp_s);
+extern UINT8        RTC_EMU_get_reg(UINT8 reg_addr_u8);
+extern void         RTC_EMU_set_reg(UINT8 reg_addr_u8, UINT8 value_u8);
+extern BOOL         RTC_EMU_inta_low(void);
+extern BOOL         RTC_EMU_intr_enabled(void);
+extern UINT32       RTC_EMU_get_isr_count(void);
+extern INT64        RTC_EMU_date_to_us(INT32 year_i32, INT32 month_i32, INT32 day_i32,
+                                       INT32 hour_i32, INT32 minute_i32, INT32 second_i32);
+
+/* End */
+#define WC_RTC_EMU_H
+#endif
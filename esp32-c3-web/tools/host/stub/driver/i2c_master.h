@@ -0,0 +1,43 @@
+/* Host build stub of the ESP-IDF header, only what the drivers under test use */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+
+typedef struct i2c_master_bus_t* i2c_master_bus_handle_t;
+typedef struct i2c_master_dev_t* i2c_master_dev_handle_t;
+
+#define I2C_NUM_0               (0)
+#define I2C_CLK_SRC_DEFAULT     (0)
+
+typedef enum {
+    I2C_ADDR_BIT_LEN_7 = 0,
+    I2C_ADDR_BIT_LEN_10,
+} i2c_addr_bit_len_t;
+
+typedef struct {
+    int i2c_port;
+    int sda_io_num;
+    int scl_io_num;
+    int clk_source;
+    uint8_t glitch_ignore_cnt;
+    struct {
+        uint32_t enable_internal_pullup : 1;
+    } flags;
+} i2c_master_bus_config_t;
+
+typedef struct {
+    i2c_addr_bit_len_t dev_addr_length;
+    uint16_t device_address;
+    uint32_t scl_speed_hz;
+} i2c_device_config_t;
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t* p_bus_config, i2c_master_bus_handle_t* p_bus_handle);
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle, const i2c_device_config_t* p_dev_config,
+                                    i2c_master_dev_handle_t* p_dev_handle);
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t dev_handle, const uint8_t* write_buffer, size_t write_size,
+                              int xfer_timeout_ms);
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t dev_handle, const uint8_t* write_buffer, size_t write_size,
+                                      uint8_t* read_buffer, size_t read_size, int xfer_timeout_ms);
@@ -0,0 +1,4 @@
+/* Host build stub of the ESP-IDF header, only what the drivers under test use */
+#pragma once
+
+#include "driver/i2c_master.h"
@@ -0,0 +1,11 @@
+/* Host build stub of the ESP-IDF header, only what the drivers under test use */
+#pragma once
+
+#include <stdio.h>
+
+/* Warnings and errors are printed, the tests check them against the output they expect */
+#define ESP_LOGE(tag, format, ...)  printf("E %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)  printf("W %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)  do { if(0) printf(format, ##__VA_ARGS__); (void)(tag); } while(0)
+#define ESP_LOGD(tag, format, ...)  ESP_LOGI(tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)  ESP_LOGI(tag, format, ##__VA_ARGS__)
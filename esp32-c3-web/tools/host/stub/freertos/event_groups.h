@@ -0,0 +1,10 @@
+/* Host build stub of the ESP-IDF header, only what the drivers under test use */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef void*       EventGroupHandle_t;
+typedef uint32_t    EventBits_t;
+
+/* The emulated RTC keeps the bits, see rtc_emu.c */
+BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t group_h, EventBits_t bits, BaseType_t* p_task_woken);
@@ -0,0 +1,4 @@
+/* Host build stub of the ESP-IDF header, ESP32-C3 values */
+#pragma once
+
+#define SOC_GPIO_SUPPORT_SLP_SWITCH     (1)
@@ -0,0 +1,204 @@
+/*==============================================================================
+ *==============================================================================
+ * NAME:
+ *      test_rtc_events.c
+ *
+ * PURPOSE:
+ *      Host test of the RTC events (RTC_enable_events(), RTC_clear_events()).
+ *
+ *      Walks 24 hours of minute wakeups on the emulated PCF85263A, handled
+ *      the way the heartbeat task in main.c handles FLAG_RTC_EVENT and
+ *      FLAG_RTC_SYNC. The walk starts before midnight on the 28th of
+ *      February of a leap year, with a stale flag left from before a reset
+ *      and the RTC crystal 35 ppm fast, and has an alarm at 07:30:00.
+ *
+ *      Every minute must wake the task exactly once, within the first
+ *      second, show that minute, and leave ~INTA released with the
+ *      interrupt unmasked.
+ *
+ * DEPENDENCIES:
+ *      rtc.c, rtc_emu.c
+ *
+ *==============================================================================
+ * (C) Andrew Bright 2024, github.com/e5h
+ *==============================================================================
+ *=============================================================================*/
+
+/*=============================================================================*/
+/*][ Include Files ][==========================================================*/
+/*=============================================================================*/
+
+#include "rtc_emu.h"
+
+/*=============================================================================*/
+/*][ LOCAL : Constants and Types ][============================================*/
+/*=============================================================================*/
+
+/* Heartbeat flags, as in main.c */
+#define FLAG_RTC_EVENT      (0x10)
+#define FLAG_RTC_SYNC       (0x20)
+
+#define TEST_INT_GPIO       (3)
+#define TEST_DRIFT_PPB      (35000)
+#define TEST_WEEKDAY        (3)         // 2024-02-28 was a wednesday, any value does
+#define TEST_MINUTES        (24 * 60 + 2) // Over both midnights
+#define TEST_ALARM_HOUR     (7)
+#define TEST_ALARM_MIN      (30)
+#define TEST_WAKE_MAX_US    (1000000)   // A minute is shown within its first second
+
+#define CHECK(cond) check((cond) ? TRUE : FALSE, #cond, __LINE__)
+
+/*=============================================================================*/
+/*][ LOCAL : Variables ][======================================================*/
+/*=============================================================================*/
+
+static UINT32 test_failures_u32;
+static INT32 test_event_group_i32;      // Only its address is used
+
+/*=============================================================================*/
+/*][ LOCAL : Functions ][======================================================*/
+/*=============================================================================*/
+
+static void check(BOOL passed_b, const CHAR* cond_c, INT32 line_i32)
+{
+    if(passed_b != TRUE)
+    {
+        struct tm time_s;
+
+        RTC_EMU_get_time(&time_s);
+        printf("test_rtc_events.c:%d: failed at RTC 20%02d-%02d-%02d %02d:%02d:%02d: %s\n", (int)line_i32,
+               time_s.tm_year, time_s.tm_mon, time_s.tm_mday, time_s.tm_hour, time_s.tm_min, time_s.tm_sec, cond_c);
+        test_failures_u32++;
+    }
+}
+
+int main(void)
+{
+    INT64 start_us_i64 = RTC_EMU_date_to_us(24, 2, 28, 23, 58, 30) + 417321;
+    INT64 first_minute_us_i64 = RTC_EMU_date_to_us(24, 2, 28, 23, 59, 0);
+    INT64 alarm_us_i64 = RTC_EMU_date_to_us(24, 2, 29, TEST_ALARM_HOUR, TEST_ALARM_MIN, 0);
+    struct tm alarm_s = { .tm_hour = TEST_ALARM_HOUR, .tm_min = TEST_ALARM_MIN, .tm_sec = 0 };
+    UINT32 next_sync_ms_u32;
+    UINT32 minutes_u32 = 0;
+    UINT32 alarms_u32 = 0;
+    UINT32 wakes_u32 = 0;
+    EventBits_t flags = 0;
+    INT64 end_us_i64 = first_minute_us_i64 + TEST_MINUTES * 60000000LL;
+
+    // Left by the firmware before a reset: ~INTA configured and a minute not acknowledged
+    RTC_EMU_start(start_us_i64, TEST_WEEKDAY, TEST_DRIFT_PPB);
+    RTC_EMU_set_reg(CTRL_REG_ADDR_PIN_IO, PIN_IO_INTAPM_N_INTA_OUT);
+    RTC_EMU_set_reg(CTRL_REG_ADDR_INTA_ENABLE, CTRL_REG_INTA_ENABLE_M_ILPA | CTRL_REG_INTA_ENABLE_M_PIEA);
+    RTC_EMU_set_reg(CTRL_REG_ADDR_FLAGS, CTRL_REG_FLAGS_M_PIF);
+    RTC_EMU_run_until(200000);
+
+    // app_main()
+    CHECK(RTC_init(PCF85263A_ADDR_7BIT) >= STATUS_OK);
+    INT64 sync_at_us_i64 = RTC_EMU_get_cpu_us() + RTC_SYNC_MIN_S * 1000000LL;
+    CHECK(RTC_set_alarm(&alarm_s) >= STATUS_OK);
+    CHECK(RTC_enable_events(TEST_INT_GPIO, RTC_EVENT_MINUTE | RTC_EVENT_ALARM,
+                            (EventGroupHandle_t)&test_event_group_i32, FLAG_RTC_EVENT) >= STATUS_OK);
+
+    // The stale flag is cleared, not reported
+    CHECK((RTC_EMU_get_reg(CTRL_REG_ADDR_FLAGS) & (CTRL_REG_FLAGS_M_PIF | CTRL_REG_FLAGS_M_A1F)) == 0);
+    CHECK(RTC_EMU_inta_low() != TRUE);
+    CHECK(RTC_EMU_intr_enabled() == TRUE);
+    CHECK(RTC_EMU_get_isr_count() == 0);
+
+    // Alarm 1 on the second, minute and hour only
+    CHECK(RTC_EMU_get_reg(RTC_REG_ADDR_SECOND_ALARM1) == 0x00);
+    CHECK(RTC_EMU_get_reg(RTC_REG_ADDR_MINUTE_ALARM1) == 0x30);
+    CHECK(RTC_EMU_get_reg(RTC_REG_ADDR_HOUR_ALARM1) == 0x07);
+    CHECK((RTC_EMU_get_reg(RTC_REG_ADDR_ALARM_ENABLES) & 0x1F)
+          == (RTC_REG_ALARM_EN_M_SEC_A1E | RTC_REG_ALARM_EN_M_MIN_A1E | RTC_REG_ALARM_EN_M_HR_A1E));
+
+    // Show the time now, not at the next minute
+    flags |= FLAG_RTC_EVENT;
+
+    // heartbeat_task(), until a minute past the end if the events stop
+    while(minutes_u32 < TEST_MINUTES && RTC_EMU_get_rtc_us() < end_us_i64 + 60000000LL && test_failures_u32 < 10)
+    {
+        if(flags == 0)
+        {
+            RTC_EMU_wait_bits(sync_at_us_i64);
+            flags |= RTC_EMU_take_bits();
+            if(RTC_EMU_get_cpu_us() >= sync_at_us_i64)
+            {
+                flags |= FLAG_RTC_SYNC;
+            }
+        }
+
+        if(flags & FLAG_RTC_SYNC)
+        {
+            CHECK(RTC_sync(&next_sync_ms_u32) >= STATUS_OK);
+            sync_at_us_i64 = RTC_EMU_get_cpu_us() + next_sync_ms_u32 * 1000LL;
+            flags &= ~FLAG_RTC_SYNC;
+        }
+
+        if(flags & FLAG_RTC_EVENT)
+        {
+            UINT8 rtc_events_u8 = RTC_EVENT_NONE;
+            INT64 woke_us_i64 = RTC_EMU_get_rtc_us();
+            struct tm shown_s;
+            struct tm rtc_s;
+
+            flags &= ~FLAG_RTC_EVENT;
+            wakes_u32++;
+
+            CHECK(RTC_clear_events(&rtc_events_u8) >= STATUS_OK);
+            CHECK(RTC_EMU_inta_low() != TRUE);
+            CHECK(RTC_EMU_intr_enabled() == TRUE);
+
+            if(rtc_events_u8 & RTC_EVENT_MINUTE)
+            {
+                INT64 minute_us_i64 = first_minute_us_i64 + minutes_u32 * 60000000LL;
+
+                // Every minute once, in order, woken on its edge
+                CHECK(woke_us_i64 >= minute_us_i64 && woke_us_i64 < minute_us_i64 + TEST_WAKE_MAX_US);
+                minutes_u32++;
+            }
+
+            if(rtc_events_u8 & RTC_EVENT_ALARM)
+            {
+                CHECK(woke_us_i64 >= alarm_us_i64 && woke_us_i64 < alarm_us_i64 + TEST_WAKE_MAX_US);
+                CHECK(rtc_events_u8 & RTC_EVENT_MINUTE);
+                alarms_u32++;
+            }
+
+            // Resync when the cached time is short of the edge
+            CHECK(RTC_get_time(&shown_s) >= STATUS_OK);
+            if((rtc_events_u8 & RTC_EVENT_MINUTE) && shown_s.tm_sec != 0)
+            {
+                CHECK(RTC_sync(&next_sync_ms_u32) >= STATUS_OK);
+                sync_at_us_i64 = RTC_EMU_get_cpu_us() + next_sync_ms_u32 * 1000LL;
+                CHECK(RTC_get_time(&shown_s) >= STATUS_OK);
+            }
+
+            // The minute shown is the minute of the RTC
+            RTC_EMU_get_time(&rtc_s);
+            CHECK(shown_s.tm_min == rtc_s.tm_min && shown_s.tm_hour == rtc_s.tm_hour);
+            CHECK(shown_s.tm_mday == rtc_s.tm_mday && shown_s.tm_mon == rtc_s.tm_mon && shown_s.tm_year == rtc_s.tm_year);
+            CHECK(shown_s.tm_wday == rtc_s.tm_wday);
+        }
+    }
+
+    RTC_SYNC_STATS stats_s;
+    struct tm end_s;
+
+    RTC_get_sync_stats(&stats_s);
+    RTC_EMU_get_time(&end_s);
+
+    CHECK(minutes_u32 == TEST_MINUTES);
+    CHECK(alarms_u32 == 1);
+    CHECK(wakes_u32 == minutes_u32 + 1);
+    CHECK(RTC_EMU_get_isr_count() == minutes_u32);
+    CHECK(end_s.tm_mon == 3 && end_s.tm_mday == 1 && end_s.tm_hour == 0 && end_s.tm_min == 0);
+    CHECK(stats_s.steps_u32 == 0);
+    CHECK(stats_s.drift_ppb_i32 > TEST_DRIFT_PPB - 1000 && stats_s.drift_ppb_i32 < TEST_DRIFT_PPB + 1000);
+
+    printf("test_rtc_events: %u minutes, %u alarm, %u wakeups, %u resyncs, drift %d ppb: %s\n",
+           (unsigned)minutes_u32, (unsigned)alarms_u32, (unsigned)wakes_u32, (unsigned)stats_s.resyncs_u32,
+           (int)stats_s.drift_ppb_i32, (test_failures_u32 == 0) ? "passed" : "FAILED");
+
+    return (test_failures_u32 == 0) ? 0 : 1;
+}
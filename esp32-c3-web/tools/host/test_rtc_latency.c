@@ -0,0 +1,261 @@
+/*==============================================================================
+ *==============================================================================
+ * NAME:
+ *      test_rtc_latency.c
+ *
+ * PURPOSE:
+ *      Host test of the minute change latency of the time service (RTC_sync(),
+ *      RTC_get_time(), RTC_get_next_edge()).
+ *
+ *      Runs the heartbeat task of main.c on the emulated PCF85263A for days
+ *      at a time, with the RTC crystal fast and slow against the CPU timer.
+ *      The latency is the RTC time at which CLOCK_UpdateTime() is called
+ *      with a new minute, from the edge of that minute. Negative is a
+ *      minute shown before the RTC got there.
+ *
+ *      Polled (~INTA not wired): the 1 s deadline expires on the second
+ *      edges the cached time predicts, on the next whole millisecond of the
+ *      timer wheel. Events (~INTA wired): the minute interrupt wakes the
+ *      task. Both must show every minute within TEST_LATENCY_MAX_US of its
+ *      edge once the drift is measured.
+ *
+ *      Usage: test_rtc_latency <drift ppm> <polled|events>
+ *
+ * DEPENDENCIES:
+ *      rtc.c, rtc_emu.c
+ *
+ *==============================================================================
+ * (C) Andrew Bright 2024, github.com/e5h
+ *==============================================================================
+ *=============================================================================*/
+
+/*=============================================================================*/
+/*][ Include Files ][==========================================================*/
+/*=============================================================================*/
+
+#include "rtc_emu.h"
+
+/*=============================================================================*/
+/*][ LOCAL : Constants and Types ][============================================*/
+/*=============================================================================*/
+
+/* Heartbeat flags, as in main.c */
+#define FLAG_RTC_EVENT      (0x10)
+
+#define TEST_INT_GPIO       (3)
+#define TEST_DAYS           (3)
+#define TEST_SETTLE_US      (3600LL * 1000000)  // Drift not measured yet, latency not checked
+#define TEST_WAKE_US        (50)                // Deadline expiry or interrupt to the task running
+#define TEST_LATENCY_MAX_US (3000)              // Worst minute change after settling, either side
+
+#define CHECK(cond) check((cond) ? TRUE : FALSE, #cond, __LINE__)
+
+typedef struct{
+    INT32 drift_ppb_i32;
+    BOOL events_b;
+} TEST_CASE_T;
+
+typedef struct{
+    UINT32 minutes_u32;
+    UINT32 skipped_u32;             // Minutes not shown, or shown twice
+    INT64 last_minute_i64;          // Minutes since 2000 of the last minute shown, -1 = none
+    UINT32 late_u32;                // Outside TEST_LATENCY_MAX_US
+    INT64 min_us_i64;
+    INT64 max_us_i64;
+    INT64 sum_us_i64;
+} TEST_LATENCY_T;
+
+/*=============================================================================*/
+/*][ LOCAL : Variables ][======================================================*/
+/*=============================================================================*/
+
+static UINT32 test_failures_u32;
+static INT32 test_event_group_i32;      // Only its address is used
+
+/*=============================================================================*/
+/*][ LOCAL : Functions ][======================================================*/
+/*=============================================================================*/
+
+static void check(BOOL passed_b, const CHAR* cond_c, INT32 line_i32)
+{
+    if(passed_b != TRUE)
+    {
+        printf("test_rtc_latency.c:%d: failed: %s\n", (int)line_i32, cond_c);
+        test_failures_u32++;
+    }
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      tick_start() - deadline_start_on_rtc_edge() of main.c, 1 s period
+ *
+ * OUTPUT GUARANTEES:
+ *      Returns the CPU time the deadline expires, on a whole millisecond
+ **===< local >================================================================*/
+static INT64 tick_start(void)
+{
+    UINT64 edge_us_u64;
+    UINT32 delay_ms_u32 = 1000;
+
+    if(RTC_get_next_edge(1, &edge_us_u64) >= STATUS_OK)
+    {
+        INT64 delay_ms_i64 = (INT64)((edge_us_u64 + 999) / 1000) - (INT64)TIMER_GetTickMs();
+
+        delay_ms_u32 = (delay_ms_i64 > 0) ? (UINT32)delay_ms_i64 : 0;
+    }
+
+    return ((INT64)TIMER_GetTickMs() + delay_ms_u32) * 1000;
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      latency_add() - a new minute is shown
+ **===< local >================================================================*/
+static void latency_add(TEST_LATENCY_T* p_latency_s, const struct tm* p_shown_s, INT64 settle_us_i64)
+{
+    INT64 rtc_us_i64 = RTC_EMU_get_rtc_us();
+    INT64 latency_us_i64 = rtc_us_i64 % 60000000;
+    struct tm rtc_s;
+
+    RTC_EMU_get_time(&rtc_s);
+
+    // Shown before the RTC minute changed, the latency is to the coming edge
+    if(p_shown_s->tm_min != rtc_s.tm_min)
+    {
+        latency_us_i64 -= 60000000;
+    }
+
+    INT64 minute_i64 = RTC_EMU_date_to_us(p_shown_s->tm_year, p_shown_s->tm_mon, p_shown_s->tm_mday,
+                                          p_shown_s->tm_hour, p_shown_s->tm_min, 0) / 60000000;
+    if(p_latency_s->last_minute_i64 >= 0 && minute_i64 != p_latency_s->last_minute_i64 + 1)
+    {
+        p_latency_s->skipped_u32++;
+    }
+    p_latency_s->last_minute_i64 = minute_i64;
+
+    if(RTC_EMU_get_cpu_us() < settle_us_i64)
+    {
+        return;
+    }
+
+    p_latency_s->minutes_u32++;
+    p_latency_s->sum_us_i64 += latency_us_i64;
+    p_latency_s->min_us_i64 = (latency_us_i64 < p_latency_s->min_us_i64) ? latency_us_i64 : p_latency_s->min_us_i64;
+    p_latency_s->max_us_i64 = (latency_us_i64 > p_latency_s->max_us_i64) ? latency_us_i64 : p_latency_s->max_us_i64;
+
+    if(latency_us_i64 > TEST_LATENCY_MAX_US || latency_us_i64 < -TEST_LATENCY_MAX_US)
+    {
+        p_latency_s->late_u32++;
+    }
+}
+
+/**===< local >================================================================
+ * NAME:
+ *      run_case() - the heartbeat task for TEST_DAYS
+ **===< local >================================================================*/
+static void run_case(const TEST_CASE_T* p_case_s)
+{
+    TEST_LATENCY_T latency_s = { .last_minute_i64 = -1, .min_us_i64 = INT64_MAX, .max_us_i64 = INT64_MIN };
+    INT64 end_us_i64 = TEST_DAYS * 86400LL * 1000000;
+    INT64 settle_us_i64 = TEST_SETTLE_US;
+    INT32 shown_min_i32 = -1;
+    UINT32 next_sync_ms_u32;
+    RTC_SYNC_STATS stats_s;
+    struct tm shown_s;
+
+    // Not on a second edge, the first read does not know the phase
+    RTC_EMU_start(RTC_EMU_date_to_us(24, 6, 1, 11, 59, 12) + 417321, 6, p_case_s->drift_ppb_i32);
+    RTC_EMU_run_until(300000);
+
+    CHECK(RTC_init(PCF85263A_ADDR_7BIT) >= STATUS_OK);
+    INT64 sync_at_us_i64 = RTC_EMU_get_cpu_us() + RTC_SYNC_MIN_S * 1000000LL;
+
+    if(p_case_s->events_b == TRUE)
+    {
+        CHECK(RTC_enable_events(TEST_INT_GPIO, RTC_EVENT_MINUTE, (EventGroupHandle_t)&test_event_group_i32,
+                                FLAG_RTC_EVENT) >= STATUS_OK);
+
+        while(RTC_EMU_get_cpu_us() < end_us_i64)
+        {
+            RTC_EMU_wait_bits(sync_at_us_i64);
+
+            if(RTC_EMU_take_bits() & FLAG_RTC_EVENT)
+            {
+                UINT8 rtc_events_u8 = RTC_EVENT_NONE;
+
+                RTC_EMU_run_until(RTC_EMU_get_cpu_us() + TEST_WAKE_US);
+                CHECK(RTC_clear_events(&rtc_events_u8) >= STATUS_OK);
+                CHECK(RTC_get_time(&shown_s) >= STATUS_OK);
+                if((rtc_events_u8 & RTC_EVENT_MINUTE) && shown_s.tm_sec != 0)
+                {
+                    CHECK(RTC_sync(&next_sync_ms_u32) >= STATUS_OK);
+                    sync_at_us_i64 = RTC_EMU_get_cpu_us() + next_sync_ms_u32 * 1000LL;
+                    CHECK(RTC_get_time(&shown_s) >= STATUS_OK);
+                }
+                latency_add(&latency_s, &shown_s, settle_us_i64);
+            }
+            else if(RTC_EMU_get_cpu_us() >= sync_at_us_i64)
+            {
+                RTC_EMU_run_until(RTC_EMU_get_cpu_us() + TEST_WAKE_US);
+                CHECK(RTC_sync(&next_sync_ms_u32) >= STATUS_OK);
+                sync_at_us_i64 = RTC_EMU_get_cpu_us() + next_sync_ms_u32 * 1000LL;
+            }
+        }
+    }
+    else
+    {
+        INT64 tick_at_us_i64 = tick_start();
+
+        while(RTC_EMU_get_cpu_us() < end_us_i64)
+        {
+            if(sync_at_us_i64 <= tick_at_us_i64)
+            {
+                RTC_EMU_run_until(sync_at_us_i64 + TEST_WAKE_US);
+                CHECK(RTC_sync(&next_sync_ms_u32) >= STATUS_OK);
+                sync_at_us_i64 = RTC_EMU_get_cpu_us() + next_sync_ms_u32 * 1000LL;
+                continue;
+            }
+
+            RTC_EMU_run_until(tick_at_us_i64 + TEST_WAKE_US);
+            tick_at_us_i64 = tick_start();
+
+            if(RTC_get_time(&shown_s) >= STATUS_OK && shown_s.tm_min != shown_min_i32)
+            {
+                shown_min_i32 = shown_s.tm_min;
+                latency_add(&latency_s, &shown_s, settle_us_i64);
+            }
+        }
+    }
+
+    RTC_get_sync_stats(&stats_s);
+
+    CHECK(latency_s.minutes_u32 > 0 && latency_s.skipped_u32 == 0);
+    CHECK(latency_s.late_u32 == 0);
+    CHECK(stats_s.steps_u32 == 0);
+
+    printf("test_rtc_latency: %s %+d ppm: %u minutes, latency %+lld/%+lld/%+lld us (min/avg/max), "
+           "%u over %d us, drift %+d ppb, %u resyncs: %s\n",
+           (p_case_s->events_b == TRUE) ? "events" : "polled", (int)(p_case_s->drift_ppb_i32 / 1000),
+           (unsigned)latency_s.minutes_u32, (long long)latency_s.min_us_i64,
+           (long long)(latency_s.minutes_u32 ? latency_s.sum_us_i64 / latency_s.minutes_u32 : 0),
+           (long long)latency_s.max_us_i64, (unsigned)latency_s.late_u32, TEST_LATENCY_MAX_US,
+           (int)stats_s.drift_ppb_i32, (unsigned)stats_s.resyncs_u32, (test_failures_u32 == 0) ? "passed" : "FAILED");
+}
+
+int main(int argc, char** argv)
+{
+    TEST_CASE_T case_s;
+
+    if(argc != 3 || (strcmp(argv[2], "polled") != 0 && strcmp(argv[2], "events") != 0))
+    {
+        printf("usage: test_rtc_latency <drift ppm> <polled|events>\n");
+        return 1;
+    }
+
+    // One case per process, rtc.c keeps its time service from RTC_init()
+    case_s.drift_ppb_i32 = atoi(argv[1]) * 1000;
+    case_s.events_b = (strcmp(argv[2], "events") == 0) ? TRUE : FALSE;
+    run_case(&case_s);
+
+    return (test_failures_u32 == 0) ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+"""
+Builds and runs the host tests of the firmware drivers.
+
+Each test in tools/host/ is compiled with the host C compiler against the
+driver sources from main/, the emulated hardware (tools/host/*_emu.c) and
+the stub ESP-IDF headers (tools/host/stub/), and run once per argument
+list, each run in a fresh process. A test that fails to build or exits
+non-zero fails the run, its output is printed. The build runs this on
+request only, through the host_tests target ("idf.py host_tests").
+
+The host compiler is $HOST_CC, else the first of cc, gcc and clang found.
+The IDF toolchain is a cross compiler, it cannot build programs to run here.
+
+Usage: python run_host_tests.py <path/to/main> <output directory>
+"""
+
+import os
+import shutil
+import subprocess
+import sys
+
+HOST_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "host")
+
+# Test program: (driver sources from main/, emulated hardware from tools/host/, argument lists)
+TESTS = {
+    "test_rtc_events": (["rtc.c"], ["rtc_emu.c"], [[]]),
+    # RTC crystal drift in ppm, ~INTA polled or wired
+    "test_rtc_latency": (["rtc.c"], ["rtc_emu.c"], [["0", "polled"], ["20", "polled"], ["-20", "polled"],
+                                                     ["100", "polled"], ["-100", "polled"],
+                                                     ["100", "events"], ["-100", "events"]]),
+}
+
+CFLAGS = ["-std=gnu11", "-O2", "-Wall", "-Werror", "-Wno-unused-function"]
+
+
+def fail(message):
+    print(f"run_host_tests.py: error: {message}", file=sys.stderr)
+    sys.exit(1)
+
+
+def find_compiler():
+    compiler = os.environ.get("HOST_CC")
+    if compiler:
+        return compiler
+    for name in ("cc", "gcc", "clang"):
+        if shutil.which(name):
+            return name
+    fail("no host C compiler found, set HOST_CC")
+
+
+def run(command):
+    result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    return result.returncode, result.stdout
+
+
+def run_test(compiler, main_dir, out_dir, name, sources, emulators, runs):
+    program = os.path.join(out_dir, name + (".exe" if os.name == "nt" else ""))
+    command = [compiler, *CFLAGS, "-I", os.path.join(HOST_DIR, "stub"), "-I", HOST_DIR, "-I", main_dir,
+               os.path.join(HOST_DIR, name + ".c"),
+               *[os.path.join(main_dir, source) for source in sources],
+               *[os.path.join(HOST_DIR, emulator) for emulator in emulators],
+               "-o", program]
+
+    code, output = run(command)
+    if code != 0:
+        print(output, end="")
+        return f"{name} does not build"
+
+    failed = []
+    for arguments in runs:
+        code, output = run([program, *arguments])
+        print(output, end="")
+        if code != 0:
+            failed.append(" ".join([name, *arguments]))
+
+    return ", ".join(failed) + " failed" if failed else None
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        fail("usage: run_host_tests.py <path/to/main> <output directory>")
+
+    main_dir, out_dir = sys.argv[1:3]
+    os.makedirs(out_dir, exist_ok=True)
+    compiler = find_compiler()
+
+    errors = [error for name, (sources, emulators, runs) in TESTS.items()
+              if (error := run_test(compiler, main_dir, out_dir, name, sources, emulators, runs))]
+    if errors:
+        fail(", ".join(errors))
+
+    # Stamp for the build, the tests run again when a source changes
+    with open(os.path.join(out_dir, "host_tests.stamp"), "w") as f:
+        f.write("\n".join(TESTS) + "\n")